@@ -4,6 +4,7 @@
 #include "core/uuid.h"
 #include "core/log.h"
 #include "core/system.h"
+#include "core/asset_manager.h"
 #include "core/runtime.h"
 #include "core/input.h"
 #include "core/event.h"
@@ -0,0 +1,65 @@
+#include "core/asset_archive.h"
+
+#include "core/log.h"
+
+namespace gs {
+
+	std::shared_ptr<asset_archive> asset_archive::open(const std::string& path, bool* outExists)
+	{
+		auto file = mapped_file::open(path, outExists);
+		if(!file)
+			return nullptr;
+
+		const archive_header* header = validate_archive(file->data(), file->size());
+		if(!header)
+		{
+			LOG_ENGINE(error, "file from path '%s' is not an asset archive or is corrupted", path.c_str());
+			return nullptr;
+		}
+
+		std::shared_ptr<asset_archive> outArchive = std::make_shared<asset_archive>();
+		outArchive->m_header = header;
+		outArchive->m_table = (const archive_entry*)(file->data() + header->table_offset);
+		outArchive->m_names = (const char*)(file->data() + header->names_offset);
+
+		/* the table first, then every blob in one sequential read ahead, instead of a page fault per asset later */
+		file->prefetch(0, file->size());
+		outArchive->m_file = std::move(file);
+
+		return outArchive;
+	}
+
+	bool asset_archive::find(std::string_view path, size_t& outOffset, size_t& outSize) const
+	{
+		if(path.substr(0, 2) == "./")
+			path.remove_prefix(2);
+
+		const uint64_t hash = archive_path_hash(path);
+		const uint32_t mask = m_header->table_size - 1;
+
+		for(uint32_t probe = 0; probe < m_header->table_size; probe++)
+		{
+			const archive_entry& entry = m_table[(hash + probe) & mask];
+			if(!entry.path_hash)
+				return false;
+
+			if(entry.path_hash != hash || (uint64_t)entry.name_offset + entry.name_size > m_header->names_size)
+				continue;
+
+			if(std::string_view(m_names + entry.name_offset, entry.name_size) != path)
+				continue;
+
+			if(entry.offset > m_file->size() || m_file->size() - entry.offset < entry.size)
+			{
+				LOG_ENGINE(error, "archive entry '%.*s' points outside of the archive", (int)path.size(), path.data());
+				return false;
+			}
+
+			outOffset = (size_t)entry.offset;
+			outSize = (size_t)entry.size;
+			return true;
+		}
+
+		return false;
+	}
+}
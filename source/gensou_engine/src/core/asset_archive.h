@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/mapped_file.h"
+#include "core/asset_archive_format.h"
+
+#include <string_view>
+
+namespace gs {
+
+	/* a packed asset archive (see asset_archive_format.h) mapped whole
+	 * files are found through its hashed table and handed out as ranges of the mapping, nothing is read or copied
+	 */
+	class asset_archive
+	{
+	public:
+		/* nullptr if the file is missing (outExists false) or is not a valid archive */
+		static std::shared_ptr<asset_archive> open(const std::string& path, bool* outExists = nullptr);
+
+		/* the range of the mapping holding the file at path, false if the archive doesn't have it */
+		bool find(std::string_view path, size_t& outOffset, size_t& outSize) const;
+
+		const std::shared_ptr<mapped_file>& get_mapping() const { return m_file; }
+		uint32_t get_entry_count() const { return m_header->entry_count; }
+
+	private:
+		std::shared_ptr<mapped_file> m_file;
+
+		const archive_header* m_header = nullptr;
+		const archive_entry* m_table = nullptr;
+		const char* m_names = nullptr;
+	};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string_view>
+
+/*
+ * packed asset archive, every file of one or more asset directories in a single file (written by tools/asset_packer)
+ *
+ * | archive_header                             | 64 bytes
+ * | archive_entry table[table_size]            | at table_offset, open addressing over archive_path_hash, empty slots are all zero
+ * | char names[names_size]                     | at names_offset, every entry's path, not null terminated
+ * | blobs                                      | the files as they are on disk, gensou headers included
+ *
+ * the table is a power of two at most half full, a lookup probes linearly from hash & (table_size - 1) and compares
+ * the stored path on a hash match, so collisions only cost a probe
+ * every file starts archive_blob_alignment aligned, so data aligned relative to the start of its file stays aligned in a
+ * mapped archive as it is in a mapped loose file (binary models place their blobs that way and use them in place)
+ *
+ * paths are stored the way the application asks for them: forward slashes, relative ("engine_res/textures/white.gsasset")
+ */
+
+static constexpr char archive_magic[4] = { 'G', 'S', 'P', 'K' };
+static constexpr uint32_t archive_version = 1;
+static constexpr uint64_t archive_blob_alignment = 64;
+
+struct archive_header
+{
+	char magic[4] = { archive_magic[0], archive_magic[1], archive_magic[2], archive_magic[3] };
+	uint32_t version = archive_version;
+
+	uint32_t entry_count = 0;
+	uint32_t table_size = 0;
+
+	uint64_t table_offset = 0;
+	uint64_t names_offset = 0;
+	uint64_t names_size = 0;
+
+	/* first blob, the rest of the archive is blobs */
+	uint64_t data_offset = 0;
+
+	uint64_t reserved[2] = {};
+};
+
+static_assert(sizeof(archive_header) == 64, "archive_header is stored as is");
+
+struct archive_entry
+{
+	/* 0 marks an empty slot, archive_path_hash never returns it */
+	uint64_t path_hash = 0;
+
+	/* from the start of the archive */
+	uint64_t offset = 0;
+	uint64_t size = 0;
+
+	uint32_t name_offset = 0;
+	uint32_t name_size = 0;
+};
+
+static_assert(sizeof(archive_entry) == 32, "archive_entry is stored as is");
+
+/* 64-bit fnv-1a */
+inline uint64_t archive_path_hash(std::string_view path)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for(char c : path)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash ? hash : 1;
+}
+
+/* the header and table of a whole archive in memory, nullptr if it's not one or its offsets point outside of it */
+inline const archive_header* validate_archive(const void* data, size_t size)
+{
+	if(size < sizeof(archive_header))
+		return nullptr;
+
+	const archive_header* header = (const archive_header*)data;
+	if(header->magic[0] != archive_magic[0] || header->magic[1] != archive_magic[1] || header->magic[2] != archive_magic[2] || header->magic[3] != archive_magic[3])
+		return nullptr;
+
+	if(header->version != archive_version)
+		return nullptr;
+
+	/* a power of two, the probing masks with it */
+	if(!header->table_size || (header->table_size & (header->table_size - 1)) || header->entry_count > header->table_size)
+		return nullptr;
+
+	if(header->table_offset % alignof(archive_entry) || header->table_offset > size || (size - header->table_offset) / sizeof(archive_entry) < header->table_size)
+		return nullptr;
+
+	if(header->names_offset > size || size - header->names_offset < header->names_size)
+		return nullptr;
+
+	return header;
+}
@@ -0,0 +1,229 @@
+#include "core/asset_manager.h"
+
+#include "core/log.h"
+
+namespace gs {
+
+	////////////////////////////--STATICS--//////////////////////////////////
+
+	std::mutex													asset_manager::s_mutex;
+	std::condition_variable										asset_manager::s_condition;
+	std::map<asset_manager::request_key, std::shared_ptr<asset_manager::request>>	asset_manager::s_in_flight;
+	std::priority_queue<asset_manager::queued_request>			asset_manager::s_queue;
+	uint64_t													asset_manager::s_sequence = 0;
+	std::deque<std::shared_ptr<asset_manager::request>>			asset_manager::s_create_queue;
+	bool														asset_manager::s_create_scheduled = false;
+	uint32_t													asset_manager::s_running_workers = 0;
+	bool														asset_manager::s_alive = true;
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void asset_manager::cancel(const void* owner)
+	{
+		std::vector<std::shared_ptr<request>> cancelledRequests;
+
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+
+			for(auto mapIterator = s_in_flight.begin(); mapIterator != s_in_flight.end();)
+			{
+				auto& target = mapIterator->second;
+				auto& owners = target->owners;
+
+				owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+				if(!owners.empty())
+				{
+					++mapIterator;
+					continue;
+				}
+
+				target->cancelled = true;
+
+				/* a running request is resolved by whoever is running it, once its decode returns */
+				if(target->state == request_state::pending)
+				{
+					target->state = request_state::done;
+					cancelledRequests.push_back(target);
+				}
+
+				mapIterator = s_in_flight.erase(mapIterator);
+			}
+		}
+
+		for(auto& target : cancelledRequests)
+			target->resolve_cancelled();
+
+		if(!cancelledRequests.empty())
+		{
+			LOG_ENGINE(trace, "cancelled %zu pending asset requests", cancelledRequests.size());
+			s_condition.notify_all();
+		}
+	}
+
+	size_t asset_manager::get_in_flight_count()
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		return s_in_flight.size();
+	}
+
+	void asset_manager::terminate()
+	{
+		std::vector<std::shared_ptr<request>> cancelledRequests;
+
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_alive = false;
+
+			for(auto& [key, target] : s_in_flight)
+			{
+				target->cancelled = true;
+
+				if(target->state == request_state::pending)
+				{
+					target->state = request_state::done;
+					cancelledRequests.push_back(target);
+				}
+			}
+
+			s_in_flight.clear();
+			s_queue = {};
+		}
+
+		for(auto& target : cancelledRequests)
+			target->resolve_cancelled();
+
+		/* running decodes finish on their own (cancelled), whatever they hand to the loading thread is resolved here */
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_condition.notify_all();
+		s_condition.wait(lock, []() { return s_running_workers == 0; });
+
+		while(!s_create_queue.empty())
+		{
+			auto target = std::move(s_create_queue.front());
+			s_create_queue.pop_front();
+
+			target->resolve_cancelled();
+		}
+	}
+
+	uint32_t asset_manager::reserve_workers()
+	{
+		/* one worker per request up to the pool's size, every worker keeps taking requests until the queue is empty */
+		const uint32_t maxWorkers = std::max(system::get_worker_count(), 1U);
+		const uint32_t count = (uint32_t)std::min<size_t>(maxWorkers - std::min(s_running_workers, maxWorkers), s_queue.size());
+
+		s_running_workers += count;
+		return count;
+	}
+
+	void asset_manager::start_workers(uint32_t count)
+	{
+		for(uint32_t i = 0; i < count; i++)
+			system::submit_async([]() { worker_loop(); });
+	}
+
+	void asset_manager::worker_loop()
+	{
+		for(;;)
+		{
+			std::shared_ptr<request> target;
+
+			{
+				std::unique_lock<std::mutex> lock(s_mutex);
+
+				/* entries of requests already taken (queued twice) or cancelled are skipped */
+				while(!s_queue.empty() && !target)
+				{
+					if(s_queue.top().target->state == request_state::pending)
+					{
+						target = s_queue.top().target;
+						target->state = request_state::running;
+					}
+
+					s_queue.pop();
+				}
+
+				if(!target)
+				{
+					s_running_workers--;
+					s_condition.notify_all();
+					return;
+				}
+			}
+
+			if(!target->cancelled)
+				target->decode();
+
+			if(!target->create_on_loading_thread || target->cancelled)
+			{
+				complete(target);
+				continue;
+			}
+
+			bool schedule = false;
+
+			{
+				std::unique_lock<std::mutex> lock(s_mutex);
+				s_create_queue.push_back(std::move(target));
+
+				schedule = !s_create_scheduled;
+				s_create_scheduled = true;
+			}
+
+			/* a thread waiting in get() on the loading thread picks it up as well */
+			s_condition.notify_all();
+
+			if(schedule)
+				system::run_on_loading_thread([]() { run_pending_creates(); });
+		}
+	}
+
+	void asset_manager::complete(const std::shared_ptr<request>& target)
+	{
+		/* unlocked, creating can take a while. a load_async for the same path meanwhile still finds target and shares it */
+		if(!target->cancelled)
+			target->create();
+
+		/* published under the lock, a waiter in get() checks its future under it too and can't miss the notification */
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			target->state = request_state::done;
+
+			/* a cancelled request was already forgotten, and a new one may have taken its key */
+			if(target->cancelled)
+			{
+				target->resolve_cancelled();
+			}
+			else
+			{
+				s_in_flight.erase({ target->type, target->path });
+				target->publish();
+			}
+		}
+
+		s_condition.notify_all();
+	}
+
+	void asset_manager::run_pending_creates()
+	{
+		for(;;)
+		{
+			std::shared_ptr<request> target;
+
+			{
+				std::unique_lock<std::mutex> lock(s_mutex);
+
+				if(s_create_queue.empty())
+				{
+					s_create_scheduled = false;
+					return;
+				}
+
+				target = std::move(s_create_queue.front());
+				s_create_queue.pop_front();
+			}
+
+			complete(target);
+		}
+	}
+}
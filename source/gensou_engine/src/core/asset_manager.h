@@ -0,0 +1,242 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/misc.h"
+#include "core/system.h"
+
+#include <future>
+#include <map>
+#include <queue>
+#include <typeindex>
+
+namespace gs {
+
+	enum class load_priority : uint8_t { low = 0, normal = 1, high = 2, critical = 3 };
+
+	/* how asset_manager loads a T, specialized next to every asset type that can be loaded asynchronously
+	 * decode runs on a thread pool worker (file io, parsing, image or audio decoding), create turns its result into the asset:
+	 * on the loading thread if create_on_loading_thread (anything that records vulkan commands), right after decode otherwise
+	 * create gets the path too, assets that keep it (textures name themselves after it) have no other way to know it
+	 *
+	 * template<> struct asset_traits<T>
+	 * {
+	 *     using decoded_type = ...;
+	 *     static constexpr bool create_on_loading_thread = ...;
+	 *
+	 *     static std::shared_ptr<decoded_type> decode(const std::string& path);
+	 *     static std::shared_ptr<T> create(const std::string& path, std::shared_ptr<decoded_type> decoded);
+	 * };
+	 */
+	template<typename T>
+	struct asset_traits;
+
+	template<>
+	struct asset_traits<gensou_file>
+	{
+		using decoded_type = gensou_file;
+		static constexpr bool create_on_loading_thread = false;
+
+		static std::shared_ptr<gensou_file> decode(const std::string& path) { return system::load_file(path); }
+		static std::shared_ptr<gensou_file> create(const std::string&, std::shared_ptr<gensou_file> decoded) { return decoded; }
+	};
+
+	/*
+	 * asynchronous asset loading on top of the thread pool and the loading thread
+	 * requests are decoded highest priority first (in submission order within one), at most one per worker at a time, so
+	 * independent assets decode side by side and a scene waiting on all of them waits for the slowest one, not their sum
+	 * a path already in flight as the same type is not loaded twice, every request for it shares one future
+	 *
+	 * requests can carry an owner (scenes pass themselves, see scene::load_async) and cancel(owner) drops the ones it owns:
+	 * pending requests resolve to null right away, running ones after their decode, without being created
+	 */
+	class asset_manager
+	{
+	public:
+		template<typename T>
+		using asset_future = std::shared_future<std::shared_ptr<T>>;
+
+		/* safe to call from any thread, the future holds null if loading failed or the request was cancelled */
+		template<typename T>
+		static asset_future<T> load_async(const std::string& path, load_priority priority = load_priority::normal, const void* owner = nullptr)
+		{
+			const request_key key{ std::type_index(typeid(T)), path };
+
+			std::unique_lock<std::mutex> lock(s_mutex);
+
+			auto mapIterator = s_in_flight.find(key);
+			if(mapIterator != s_in_flight.end() && !mapIterator->second->cancelled)
+			{
+				auto& existing = static_cast<typed_request<T>&>(*mapIterator->second);
+				add_owner(existing, owner);
+
+				/* queued again at the higher priority, workers skip whichever entry they find second */
+				if(existing.state == request_state::pending && priority > existing.priority)
+				{
+					existing.priority = priority;
+					s_queue.push({ mapIterator->second, priority, s_sequence++ });
+				}
+
+				return existing.future;
+			}
+
+			auto newRequest = std::make_shared<typed_request<T>>();
+			newRequest->type = key.first;
+			newRequest->path = path;
+			newRequest->priority = priority;
+			newRequest->create_on_loading_thread = asset_traits<T>::create_on_loading_thread;
+			newRequest->future = newRequest->promise.get_future().share();
+			add_owner(*newRequest, owner);
+
+			asset_future<T> outFuture = newRequest->future;
+
+			if(!s_alive)
+			{
+				newRequest->resolve_cancelled();
+				return outFuture;
+			}
+
+			s_in_flight[key] = newRequest;
+			s_queue.push({ newRequest, priority, s_sequence++ });
+
+			/* started unlocked, a full pool runs the task right here */
+			const uint32_t newWorkers = reserve_workers();
+			lock.unlock();
+
+			start_workers(newWorkers);
+
+			return outFuture;
+		}
+
+		/* waits for future. on the loading thread it runs the create steps queued for it while waiting,
+		 * so a scene's on_init can wait on its textures. not to be called from inside run_async tasks
+		 */
+		template<typename T>
+		static std::shared_ptr<T> get(const asset_future<T>& future)
+		{
+			if(std::this_thread::get_id() == system::get_loading_thread_id())
+			{
+				while(!is_future_ready(future))
+				{
+					run_pending_creates();
+
+					std::unique_lock<std::mutex> lock(s_mutex);
+					s_condition.wait(lock, [&future]() { return !s_create_queue.empty() || is_future_ready(future); });
+				}
+			}
+
+			return future.get();
+		}
+
+		/* drops every request owner is the last owner of */
+		static void cancel(const void* owner);
+
+		/* requests submitted and not resolved yet */
+		static size_t get_in_flight_count();
+
+		/* cancels everything and waits for running decodes, called by system::terminate before the thread pool goes away */
+		static void terminate();
+
+	private:
+		enum class request_state : uint8_t { pending, running, done };
+
+		struct request
+		{
+			virtual ~request() = default;
+
+			/* worker thread */
+			virtual void decode() = 0;
+
+			/* worker or loading thread, turns the decoded data into the asset */
+			virtual void create() = 0;
+
+			/* resolve the future, with the asset or with null */
+			virtual void publish() = 0;
+			virtual void resolve_cancelled() = 0;
+
+			std::type_index type = typeid(void);
+			std::string path;
+			load_priority priority = load_priority::normal;
+			bool create_on_loading_thread = false;
+
+			/* guarded by s_mutex */
+			request_state state = request_state::pending;
+			std::vector<const void*> owners;
+
+			std::atomic<bool> cancelled = false;
+		};
+
+		template<typename T>
+		struct typed_request : request
+		{
+			std::promise<std::shared_ptr<T>> promise;
+			asset_future<T> future;
+			std::shared_ptr<typename asset_traits<T>::decoded_type> decoded;
+			std::shared_ptr<T> asset;
+
+			void decode() override { decoded = asset_traits<T>::decode(path); }
+
+			void create() override
+			{
+				if(decoded)
+					asset = asset_traits<T>::create(path, std::move(decoded));
+
+				decoded.reset();
+			}
+
+			void publish() override { promise.set_value(std::move(asset)); }
+
+			void resolve_cancelled() override
+			{
+				decoded.reset();
+				asset.reset();
+				promise.set_value(nullptr);
+			}
+		};
+
+		struct queued_request
+		{
+			std::shared_ptr<request> target;
+			load_priority priority;
+			uint64_t sequence;
+
+			/* std::priority_queue pops the greatest: highest priority, then the oldest */
+			bool operator<(const queued_request& other) const
+			{
+				return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+			}
+		};
+
+		using request_key = std::pair<std::type_index, std::string>;
+
+		/* s_mutex held */
+		static void add_owner(request& target, const void* owner)
+		{
+			if(std::find(target.owners.begin(), target.owners.end(), owner) == target.owners.end())
+				target.owners.push_back(owner);
+		}
+
+		/* s_mutex held, how many more workers the queue can keep busy (counted as running already) */
+		static uint32_t reserve_workers();
+		static void start_workers(uint32_t count);
+		static void worker_loop();
+
+		/* creates target and resolves it (created or cancelled), it is forgotten only once its future is ready */
+		static void complete(const std::shared_ptr<request>& target);
+		static void run_pending_creates();
+
+	private:
+		static std::mutex s_mutex;
+		static std::condition_variable s_condition;
+
+		static std::map<request_key, std::shared_ptr<request>> s_in_flight;
+		static std::priority_queue<queued_request> s_queue;
+		static uint64_t s_sequence;
+
+		/* decoded requests waiting for the loading thread */
+		static std::deque<std::shared_ptr<request>> s_create_queue;
+		static bool s_create_scheduled;
+
+		static uint32_t s_running_workers;
+		static bool s_alive;
+	};
+}
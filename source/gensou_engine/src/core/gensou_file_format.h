@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * the .gsasset container, two forms told apart by their magic
+ *
+ * raw         | 'AOTO' | uuid (8) | payload
+ * compressed  | 'AOTC' | uuid (8) | codec (1) | reserved (3) | raw size (8, little endian) | encoded payload
+ *
+ * the raw form is viewed in place (mapped), the compressed one is decoded by system::load_file into memory owned by
+ * its gensou_file, so consumers see the same payload either way
+ * compression pays off for text and raw data read once (csv models, series), binary data meant to be used in place
+ * (binary models) should stay raw
+ */
+
+static constexpr uint8_t gensou_magic[4] = { 'A', 'O', 'T', 'O' };
+static constexpr uint8_t gensou_compressed_magic[4] = { 'A', 'O', 'T', 'C' };
+
+static constexpr size_t gensou_header_size = 12;
+static constexpr size_t gensou_compressed_header_size = 24;
+
+enum class gensou_codec : uint8_t
+{
+	none = 0,
+	lz4 = 1, /* lz4 block format, see lz4_block.h */
+};
+
+/* an lz4 sequence can't expand more than this, larger claimed raw sizes are corrupt headers */
+static constexpr uint64_t gensou_lz4_max_ratio = 255;
+
+struct gensou_compressed_header
+{
+	uint64_t id = 0;
+	gensou_codec codec = gensou_codec::none;
+	uint64_t raw_size = 0;
+};
+
+/* the header of a compressed gensou file, false if data doesn't start with one */
+inline bool read_gensou_compressed_header(const uint8_t* data, size_t size, gensou_compressed_header& outHeader)
+{
+	if(size < gensou_compressed_header_size || memcmp(data, gensou_compressed_magic, 4) != 0)
+		return false;
+
+	memcpy(&outHeader.id, data + 4, 8);
+	outHeader.codec = (gensou_codec)data[12];
+
+	outHeader.raw_size = 0;
+	for(int i = 7; i >= 0; i--)
+		outHeader.raw_size = (outHeader.raw_size << 8) | data[16 + i];
+
+	return true;
+}
+
+/* writes the compressed header into out[gensou_compressed_header_size] */
+inline void write_gensou_compressed_header(const gensou_compressed_header& header, uint8_t* out)
+{
+	memcpy(out, gensou_compressed_magic, 4);
+	memcpy(out + 4, &header.id, 8);
+
+	out[12] = (uint8_t)header.codec;
+	out[13] = out[14] = out[15] = 0;
+
+	for(int i = 0; i < 8; i++)
+		out[16 + i] = uint8_t(header.raw_size >> (8 * i));
+}
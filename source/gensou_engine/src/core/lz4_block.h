@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * decoder for the lz4 block format (a single raw block, no frame), the codec of compressed gensou files
+ * a block is a run of sequences: a token (literal count << 4 | match length - 4), the literal count's extra bytes,
+ * the literals, a 16-bit little endian match offset and the match length's extra bytes, the last sequence is literals only
+ * standalone on purpose, tools/asset_compressor encodes with it in sight and checks every block it writes against it
+ */
+
+/* decodes src into exactly dstSize bytes at dst, false if the block is malformed, reaches outside of either buffer
+ * or doesn't decode to dstSize bytes, dst can't overlap src
+ */
+inline bool lz4_decompress_block(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	const uint8_t* in = src;
+	const uint8_t* const inEnd = src + srcSize;
+
+	uint8_t* out = dst;
+	uint8_t* const outEnd = dst + dstSize;
+
+	/* a 15 nibble is followed by bytes added to it, every 255 means another one follows */
+	auto read_length = [&](size_t& ioLength)
+	{
+		uint8_t next = 255;
+		while(next == 255)
+		{
+			if(in == inEnd)
+				return false;
+
+			next = *in++;
+			ioLength += next;
+		}
+
+		return true;
+	};
+
+	while(in < inEnd)
+	{
+		const uint8_t token = *in++;
+
+		size_t literalCount = token >> 4;
+		if(literalCount == 15 && !read_length(literalCount))
+			return false;
+
+		if(literalCount > size_t(inEnd - in) || literalCount > size_t(outEnd - out))
+			return false;
+
+		if(literalCount)
+			memcpy(out, in, literalCount);
+
+		in += literalCount;
+		out += literalCount;
+
+		/* the last sequence ends with its literals */
+		if(in == inEnd)
+			break;
+
+		if(inEnd - in < 2)
+			return false;
+
+		const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+		in += 2;
+
+		if(!offset || offset > size_t(out - dst))
+			return false;
+
+		size_t matchLength = token & 15;
+		if(matchLength == 15 && !read_length(matchLength))
+			return false;
+
+		matchLength += 4;
+		if(matchLength > size_t(outEnd - out))
+			return false;
+
+		/* a match closer than its length repeats the bytes it is writing, those are copied forward one at a time */
+		const uint8_t* match = out - offset;
+		if(offset >= matchLength)
+		{
+			memcpy(out, match, matchLength);
+			out += matchLength;
+		}
+		else
+		{
+			for(uint8_t* matchEnd = out + matchLength; out < matchEnd;)
+				*out++ = *match++;
+		}
+	}
+
+	return out == outEnd;
+}
@@ -0,0 +1,120 @@
+#include "core/mapped_file.h"
+
+#if defined(APP_WINDOWS)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace gs {
+
+	std::shared_ptr<mapped_file> mapped_file::open(const std::string& path, bool* outExists)
+	{
+		if(outExists)
+			*outExists = true;
+
+		void* view = nullptr;
+		size_t size = 0;
+
+#if defined(APP_WINDOWS)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+		{
+			const DWORD error = GetLastError();
+			if(outExists)
+				*outExists = error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND;
+
+			return nullptr;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+		{
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		/* the mapping keeps the file open and the view keeps the mapping, neither handle is needed afterwards */
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if(!mapping)
+			return nullptr;
+
+		view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if(!view)
+			return nullptr;
+
+		size = (size_t)fileSize.QuadPart;
+#else
+		int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(file < 0)
+		{
+			if(outExists)
+				*outExists = errno != ENOENT;
+
+			return nullptr;
+		}
+
+		struct stat info;
+		if(fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+		{
+			::close(file);
+			return nullptr;
+		}
+
+		/* the mapping holds its own reference to the file */
+		size = (size_t)info.st_size;
+		view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);
+
+		if(view == MAP_FAILED)
+			return nullptr;
+#endif
+
+		std::shared_ptr<mapped_file> outFile(new mapped_file());
+		outFile->m_data = (byte*)view;
+		outFile->m_size = size;
+
+		return outFile;
+	}
+
+	mapped_file::~mapped_file()
+	{
+		if(!m_data)
+			return;
+
+#if defined(APP_WINDOWS)
+		UnmapViewOfFile(m_data);
+#else
+		munmap(m_data, m_size);
+#endif
+	}
+
+	void mapped_file::prefetch(size_t offset, size_t size) const
+	{
+		if(offset >= m_size)
+			return;
+
+		size = std::min(size, m_size - offset);
+
+#if defined(APP_WINDOWS)
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+		WIN32_MEMORY_RANGE_ENTRY range{ m_data + offset, size };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+		/* madvise wants a page aligned start */
+		const uintptr_t pageMask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+		const uintptr_t start = (uintptr_t)(m_data + offset) & ~pageMask;
+
+		madvise((void*)start, (uintptr_t)(m_data + offset + size) - start, MADV_WILLNEED);
+#endif
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core/core.h"
+
+namespace gs {
+
+	/* a whole file mapped read-only into memory
+	 * the pages are backed by the file itself: nothing is read until it's touched, nothing is copied through userspace,
+	 * and being clean the os can drop them under memory pressure and fault them back in later
+	 * the view is unmapped when the last owner goes away
+	 */
+	class mapped_file
+	{
+	public:
+		/* nullptr if the file can't be opened or mapped (empty files included)
+		 * outExists tells a missing file apart from one that failed to map
+		 */
+		static std::shared_ptr<mapped_file> open(const std::string& path, bool* outExists = nullptr);
+
+		~mapped_file();
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		byte* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+		/* asks the os to start reading [offset, offset + size) in the background, for ranges about to be read whole */
+		void prefetch(size_t offset, size_t size) const;
+
+	private:
+		mapped_file() = default;
+
+	private:
+		byte* m_data = nullptr;
+		size_t m_size = 0;
+	};
+}
@@ -98,6 +98,15 @@ namespace gs {
 		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 	}
 
+	template<typename T>
+	inline bool is_future_ready(const std::shared_future<T>& future)
+	{
+		if (!future.valid())
+			return false;
+
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
 	/* first == quad_count in this draw, second == texture index (push constant) in this draw */
 	typedef std::vector<std::pair<uint32_t, uint32_t>> draw_call;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "core/core.h"
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace gs {
+
+	/*
+	 * bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design)
+	 * every cell carries a sequence number that tells producers and consumers whose turn it is,
+	 * so pushes and pops only contend on a single compare-exchange of their own cursor
+	 * try_push fails instead of overwriting when the queue is full, callers decide how to apply backpressure
+	 */
+	template<typename T>
+	class mpmc_queue
+	{
+	public:
+		mpmc_queue() = default;
+
+		/* capacity is rounded up to a power of 2 */
+		explicit mpmc_queue(size_t capacity) { resize(capacity); }
+
+		~mpmc_queue()
+		{
+			if(!m_cells)
+				return;
+
+			/* destroy whatever is still queued */
+			T value;
+			while(try_pop(value)) {}
+		}
+
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		/* not thread-safe, only call it before the queue is shared */
+		void resize(size_t capacity)
+		{
+			size_t powerOf2 = 2;
+			while(powerOf2 < capacity)
+				powerOf2 <<= 1;
+
+			m_capacity = powerOf2;
+			m_mask = powerOf2 - 1;
+			m_cells = std::make_unique<cell[]>(powerOf2);
+
+			for(size_t i = 0; i < powerOf2; i++)
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+			m_enqueue_pos.store(0, std::memory_order_relaxed);
+			m_dequeue_pos.store(0, std::memory_order_relaxed);
+		}
+
+		/* value is only moved from on success */
+		bool try_push(T& value)
+		{
+			cell* pCell = nullptr;
+			size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+			for(;;)
+			{
+				pCell = &m_cells[pos & m_mask];
+				size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+				if(diff == 0)
+				{
+					if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if(diff < 0)
+				{
+					/* the cell still holds the value from one lap ago, full */
+					return false;
+				}
+				else
+				{
+					pos = m_enqueue_pos.load(std::memory_order_relaxed);
+				}
+			}
+
+			new(pCell->storage) T(std::move(value));
+			pCell->sequence.store(pos + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		bool try_pop(T& outValue)
+		{
+			cell* pCell = nullptr;
+			size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+			for(;;)
+			{
+				pCell = &m_cells[pos & m_mask];
+				size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+				if(diff == 0)
+				{
+					if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if(diff < 0)
+				{
+					/* nothing published in this cell yet, empty */
+					return false;
+				}
+				else
+				{
+					pos = m_dequeue_pos.load(std::memory_order_relaxed);
+				}
+			}
+
+			T* pValue = std::launder(reinterpret_cast<T*>(pCell->storage));
+			outValue = std::move(*pValue);
+			pValue->~T();
+
+			pCell->sequence.store(pos + m_capacity, std::memory_order_release);
+
+			return true;
+		}
+
+		/* only a snapshot, it may be stale by the time it returns */
+		size_t size_approx() const
+		{
+			size_t enqueuePos = m_enqueue_pos.load(std::memory_order_relaxed);
+			size_t dequeuePos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+			return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+		}
+
+		bool empty_approx() const { return size_approx() == 0; }
+		size_t capacity() const { return m_capacity; }
+
+	private:
+		struct cell
+		{
+			std::atomic<size_t> sequence{ 0 };
+			alignas(T) byte storage[sizeof(T)];
+		};
+
+		std::unique_ptr<cell[]> m_cells;
+		size_t m_capacity = 0, m_mask = 0;
+
+		/* producers and consumers each get their own cache line */
+		alignas(64) std::atomic<size_t> m_enqueue_pos{ 0 };
+		alignas(64) std::atomic<size_t> m_dequeue_pos{ 0 };
+	};
+}
@@ -1,8 +1,11 @@
 #include "core/system.h"
 
+#include "core/asset_manager.h"
 #include "core/gensou_app.h"
 #include "core/misc.h"
 #include "core/runtime.h"
+#include "core/gensou_file_format.h"
+#include "core/lz4_block.h"
 
 #include "renderer/renderer.h"
 
@@ -23,10 +26,11 @@ namespace gs {
 	bool									system::s_rumbler_active = true;
 	std::string								system::s_internal_data_path;
 	std::shared_ptr<app_settings>			system::s_app_settings;
+	std::vector<std::shared_ptr<asset_archive>>	system::s_archives;
 
 	system::render_thread					system::s_render_thread;
 	system::loading_thread					system::s_loading_thread;
-	system::thread_pool						system::s_thread_pool;
+	thread_pool								system::s_thread_pool;
 	
 	std::thread::id							system::s_main_thread_id;
 	std::thread::id							system::s_render_thread_id;
@@ -76,7 +80,7 @@ namespace gs {
 		/* loading thread */
 		{
 			s_loading_thread.thread_name = "loading";
-			s_loading_thread.task_queue.resize(256);
+			s_loading_thread.task_queue.resize(loading_thread::queue_capacity);
 
 			s_loading_thread.thread = std::thread([&data = s_loading_thread]()
 			{
@@ -84,27 +88,23 @@ namespace gs {
 
 				while(data.is_alive)
 				{
-					/* thread-safe when there is a single producer thread and single consumer thread */
+					loading_thread::task nextTask;
+
+					if(!data.task_queue.try_pop(nextTask))
 					{
 						std::unique_lock<std::mutex> lock(data.mutex);
+						data.sleeping.store(true, std::memory_order_relaxed);
+
+						/* pairs with the fence in wake(), the queue is checked (the predicate runs once before waiting) after it */
+						std::atomic_thread_fence(std::memory_order_seq_cst);
 						data.mutex_condition.wait(lock, [&data] { return data.has_work() || !data.is_alive; });
+						data.sleeping.store(false, std::memory_order_relaxed);
 
-						if (!data.is_alive)
-							break;
+						continue;
 					}
 
-					if (data.tail_ptr == data.task_queue.size())
-						data.tail_ptr = 0;
-
-					/* take ownership to free up a slot in the task queue */
-					std::function<void(void)> function(std::move(data.task_queue[data.tail_ptr].function));
-					std::promise<void> promise(std::move(data.task_queue[data.tail_ptr].promise));
-					data.task_queue[data.tail_ptr].free = true;
-
-					data.tail_ptr++;
-
-					function();
-					promise.set_value();
+					nextTask.function();
+					nextTask.promise.set_value();
 				}
 
 				LOG_ENGINE(trace, "finishing %s thread | thread id == %llX", data.thread_name.c_str(), std::this_thread::get_id());
@@ -114,42 +114,23 @@ namespace gs {
 		}
 
 		/* thread pool */
-		for(uint32_t i = 0; i < thread_pool::thread_count; i++)
-		{
-			s_thread_pool.threads.push_back(std::thread([&pool = s_thread_pool]
-			{
-				while(pool.is_alive)
-				{
-					thread_pool::task nextTask;
-					{
-						std::unique_lock<std::mutex> lock(pool.mutex);
-						pool.mutex_condition.wait(lock, [&pool]
-						{ 
-							return !pool.tasks_queue.empty() || !pool.is_alive;
-						});
-
-						if (!pool.is_alive) 
-							break;
-
-						nextTask = std::move(pool.tasks_queue.front());
-						pool.tasks_queue.pop();
-					}
-
-					nextTask.function();
-					nextTask.promise.set_value();
-				}					
-			}));
-		}
+		s_thread_pool.init();
 
 		#ifdef APP_ANDROID
 		s_internal_data_path = static_cast<android_app*>(s_platform_data)->activity->internalDataPath;
 		#else
 		s_internal_data_path = std::filesystem::absolute(std::filesystem::current_path()).string();
+
+		for(const char* archive : s_default_archives)
+			mount_archive(archive);
 		#endif
 	}
 
 	void system::terminate()
 	{
+		/* its workers run on the pool and hand work to the loading thread, both still have to be alive */
+		asset_manager::terminate();
+
 		s_thread_pool.terminate();
 
 		/* terminate loading thread */
@@ -170,6 +151,18 @@ namespace gs {
 		s_render_thread.thread.join();
 	}
 
+	loading_queue_stats system::get_loading_queue_stats()
+	{
+		loading_queue_stats stats;
+		stats.depth = (uint32_t)s_loading_thread.task_queue.size_approx();
+		stats.high_water_mark = s_loading_thread.high_water_mark.load(std::memory_order_relaxed);
+		stats.capacity = (uint32_t)s_loading_thread.task_queue.capacity();
+		stats.submitted = s_loading_thread.submitted.load(std::memory_order_relaxed);
+		stats.stalls = s_loading_thread.stalls.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
 	void system::set_cursor_type(cursor_type cursorType)
 	{
 		gensou_app::get()->get_window()->set_cursor_type(cursorType);
@@ -314,9 +307,7 @@ namespace gs {
 			outData->m_id = uuid(*idPtr);
 		}
 
-		outData->m_size = totaldDataSize - 16ULL; /* minus header and hash size */
-		outData->m_data = std::make_unique<byte[]>(outData->m_size);
-		memset(outData->m_data.get(), 0, outData->m_size);
+		outData->allocate(totaldDataSize - 16ULL); /* minus header and hash size */
 
 		dword correctHash = 0;
 
@@ -330,7 +321,7 @@ namespace gs {
 			return outData;
 		}
 
-		if (fread(outData->m_data.get(), 1, outData->m_size, file) != outData->m_size)
+		if (fread(outData->data(), 1, outData->m_size, file) != outData->m_size)
 		{
 			outData.reset();
 			fclose(file);
@@ -341,7 +332,7 @@ namespace gs {
 
 		/* compare hash to assert data integrity */
 		{
-			dword dataHash = get_hashcode_from_binary(outData->m_data.get(), outData->m_size);
+			dword dataHash = get_hashcode_from_binary(outData->data(), outData->m_size);
 			if(dataHash != correctHash)
 			{
 				LOG_ENGINE(error, "corrupted data | file from path '%s' failed hash check", path.c_str());
@@ -487,8 +478,18 @@ namespace gs {
 
 	static std::unordered_map<std::string, uuid> s_id_from_path_atlas;
 
+	/* load_file also runs on asset_manager's workers */
+	static std::mutex s_id_from_path_mutex;
+
+	static void cache_id_from_file(const std::string& filePath, uuid id)
+	{
+		std::unique_lock<std::mutex> lock(s_id_from_path_mutex);
+		s_id_from_path_atlas[filePath] = id;
+	}
+
 	uuid system::get_cached_id_from_file(const std::string& filePath)
 	{
+		std::unique_lock<std::mutex> lock(s_id_from_path_mutex);
 		const auto mapIterator = s_id_from_path_atlas.find(filePath);
 
 		if (mapIterator != s_id_from_path_atlas.end())
@@ -581,6 +582,24 @@ namespace gs {
 							uint64_t* idPtr = (uint64_t*)(&headerData[4]);
 							outData->m_id = uuid(*idPtr);
 						}
+						else if(memcmp(headerData, gensou_compressed_magic, 4) == 0)
+						{
+							/* the encoded payload is read whole and decoded into the file's own memory */
+							std::vector<byte> encodedData(dataSize);
+							AAsset_seek(asset, 0L, SEEK_SET);
+
+							if((size_t)AAsset_read(asset, encodedData.data(), dataSize) == dataSize)
+								outData = decode_gensou_file(path, encodedData.data(), dataSize);
+							else
+								LOG_ENGINE(error, "failed to parse file from path '%s'", path.c_str());
+
+							AAsset_close(asset);
+
+							if(outData)
+								cache_id_from_file(path, outData->m_id);
+
+							return outData;
+						}
 						else
 						{
 							LOG_ENGINE(error, "file from path '%s' is not a gensou file", path.c_str());
@@ -594,12 +613,10 @@ namespace gs {
 
 				if (outData)
 				{
-					outData->m_size = dataSize - 12ULL;
-					outData->m_data = std::make_unique<byte[]>(outData->m_size);
-					memset(outData->m_data.get(), 0, outData->m_size);
+					outData->allocate(dataSize - 12ULL);
 
 					AAsset_seek(asset, 12L, SEEK_SET);
-					size_t readsize = AAsset_read(asset, outData->m_data.get(), outData->m_size);
+					size_t readsize = AAsset_read(asset, outData->data(), outData->m_size);
 
 					if (readsize != outData->m_size)
 					{
@@ -621,86 +638,147 @@ namespace gs {
 		}
 
 #else
-		if (!std::filesystem::exists(path))
+		/* the payload is a view into the mapped archive or file, no copies and its pages stay evictable */
+		std::shared_ptr<mapped_file> mapping;
+		size_t offset = 0, size = 0;
+
+		if (!find_in_archives(path, mapping, offset, size))
 		{
-			LOG_ENGINE(warn, "file with path '%s' does not exist", path.c_str());
-			return outData;
-		}
+			bool exists = true;
+			mapping = mapped_file::open(path, &exists);
 
-		FILE* file = nullptr;
+			if (!mapping)
+			{
+				if (!exists)
+					LOG_ENGINE(warn, "file with path '%s' does not exist", path.c_str());
+				else
+					LOG_ENGINE(error, "Failed to load file from path '%s'", path.c_str());
 
-		file = fopen(path.c_str(), "rb");
+				return outData;
+			}
 
-		if (file)
-		{
 			LOG_ENGINE(trace, "loading file from path '%s'", path.c_str());
+			size = mapping->size();
+		}
 
-			fseek(file, 0, SEEK_END);
-			if (size_t totaldDataSize = ftell(file))
-			{
-				if(totaldDataSize < 12ULL)
-				{
-					LOG_ENGINE(error, "could not read file from path '%s', data incomplete", path.c_str());
-					return outData;
-				}
+		outData = view_gensou_file(path, std::move(mapping), offset, size);
 
-				/* extract gensou header to assert it's our data type */
-				{
-					rewind(file);
-					byte headerData[12];
-					size_t readsize = fread(headerData, 1, 12ULL, file);
-					if(readsize == 12ULL)
-					{
-						/* check magic number */
-						if(headerData[0] == 0x41 && headerData[1] == 0x4F && headerData[2] == 0x54 && headerData[3] == 0x4F)
-						{
-							outData = std::make_shared<gensou_file>();
-							uint64_t* idPtr = (uint64_t*)(&headerData[4]);
-							outData->m_id = uuid(*idPtr);
-						}
-						else
-						{
-							LOG_ENGINE(error, "file from path '%s' is not a gensou file", path.c_str());
-						}
-					}
-					else
-					{
-						LOG_ENGINE(error, "failed to parse file from path '%s'", path.c_str());
-					}
-				}
+#endif
 
-				if (outData)
-				{
-					outData->m_size = totaldDataSize - 12ULL;
-					outData->m_data = std::make_unique<byte[]>(outData->m_size);
-					memset(outData->m_data.get(), 0, outData->m_size);
+		if(outData)
+			cache_id_from_file(path, outData->m_id);
 
-					fseek(file, 12L, SEEK_SET);
-					size_t readsize = fread(outData->m_data.get(), 1, outData->m_size, file);
+		return outData;
+	}
 
-					if (readsize != outData->m_size)
-					{
-						outData.reset();
-						LOG_ENGINE(error, "failed to parse file from path '%s'", path.c_str());
-					}
-				}
-			}
-			else
+	bool system::mount_archive(const std::string& path)
+	{
+		bool exists = true;
+		auto archive = asset_archive::open(path, &exists);
+
+		if (!archive)
+		{
+			if (exists)
+				LOG_ENGINE(error, "failed to mount archive from path '%s'", path.c_str());
+
+			return false;
+		}
+
+		LOG_ENGINE(trace, "mounted archive '%s' | %u files", path.c_str(), archive->get_entry_count());
+		s_archives.emplace_back(std::move(archive));
+
+		return true;
+	}
+
+	bool system::find_in_archives(const std::string& path, std::shared_ptr<mapped_file>& outMapping, size_t& outOffset, size_t& outSize)
+	{
+		for (const auto& archive : s_archives)
+		{
+			if (archive->find(path, outOffset, outSize))
 			{
-				LOG_ENGINE(error, "could not read file from path '%s'", path.c_str());
+				LOG_ENGINE(trace, "loading file from path '%s' (archive)", path.c_str());
+				outMapping = archive->get_mapping();
+				return true;
 			}
+		}
+
+		return false;
+	}
+
+	std::shared_ptr<gensou_file> system::view_gensou_file(const std::string& path, std::shared_ptr<mapped_file> mapping, size_t offset, size_t size)
+	{
+		std::shared_ptr<gensou_file> outData;
 
-			fclose(file); 
+		if (size < 12ULL)
+		{
+			LOG_ENGINE(error, "could not read file from path '%s', data incomplete", path.c_str());
+			return outData;
 		}
-		else
+
+		/* check magic number */
+		const byte* headerData = mapping->data() + offset;
+		if (memcmp(headerData, gensou_compressed_magic, 4) == 0)
+			return decode_gensou_file(path, headerData, size);
+
+		if (headerData[0] != 0x41 || headerData[1] != 0x4F || headerData[2] != 0x54 || headerData[3] != 0x4F)
 		{
-			LOG_ENGINE(error, "Failed to load file from path '%s'", path.c_str());
+			LOG_ENGINE(error, "file from path '%s' is not a gensou file", path.c_str());
+			return outData;
 		}
 
-#endif
+		outData = std::make_shared<gensou_file>();
 
-		if(outData)
-			s_id_from_path_atlas[path] = outData->m_id;
+		uint64_t id = 0;
+		memcpy(&id, &headerData[4], sizeof(id));
+		outData->m_id = uuid(id);
+
+		/* every consumer reads its asset whole, start reading it in before the first page fault */
+		mapping->prefetch(offset + 12ULL, size - 12ULL);
+		outData->map(std::move(mapping), offset + 12ULL, size - 12ULL);
+
+		return outData;
+	}
+
+	std::shared_ptr<gensou_file> system::decode_gensou_file(const std::string& path, const byte* data, size_t size)
+	{
+		std::shared_ptr<gensou_file> outData;
+
+		gensou_compressed_header header;
+		if (!read_gensou_compressed_header(data, size, header))
+		{
+			LOG_ENGINE(error, "could not read file from path '%s', data incomplete", path.c_str());
+			return outData;
+		}
+
+		const byte* encodedData = data + gensou_compressed_header_size;
+		const size_t encodedSize = size - gensou_compressed_header_size;
+
+		if (header.codec != gensou_codec::lz4)
+		{
+			LOG_ENGINE(error, "file from path '%s' is compressed with an unknown codec (%u)", path.c_str(), (uint32_t)header.codec);
+			return outData;
+		}
+
+		if (header.raw_size > (uint64_t)encodedSize * gensou_lz4_max_ratio || header.raw_size > (uint64_t)SIZE_MAX)
+		{
+			LOG_ENGINE(error, "file from path '%s' claims a raw size of %llu bytes, data may be corrupted", path.c_str(), (unsigned long long)header.raw_size);
+			return outData;
+		}
+
+		outData = std::make_shared<gensou_file>();
+		outData->m_id = uuid(header.id);
+
+		/* decoded straight from the mapping (or read buffer) into the payload, no staging buffer in between */
+		outData->allocate((size_t)header.raw_size);
+
+		if (!lz4_decompress_block(encodedData, encodedSize, outData->data(), outData->m_size))
+		{
+			LOG_ENGINE(error, "failed to decompress file from path '%s', data may be corrupted", path.c_str());
+			outData.reset();
+			return outData;
+		}
+
+		LOG_ENGINE(trace, "decompressed file from path '%s' | %zu -> %zu bytes", path.c_str(), encodedSize, outData->m_size);
 
 		return outData;
 	}
@@ -777,6 +855,28 @@ namespace gs {
 		}
 
 #else
+		/* shaders packed in an archive are copied straight out of its mapping */
+		{
+			std::shared_ptr<mapped_file> mapping;
+			size_t offset = 0, size = 0;
+
+			if (find_in_archives(path, mapping, offset, size))
+			{
+				const byte* spvData = mapping->data() + offset;
+				uint32_t magicNumber = 0;
+
+				if (size >= 4ULL)
+					memcpy(&magicNumber, spvData, 4ULL);
+
+				if (magicNumber == 0x07230203)
+					outData.assign(spvData, spvData + size);
+				else
+					LOG_ENGINE(error, "file from path '%s' is not a spv shader file", path.c_str());
+
+				return outData;
+			}
+		}
+
 		FILE* file = nullptr;
 		file = fopen(path.c_str(), "rb");
 
@@ -5,7 +5,11 @@
 #include "core/uuid.h"
 #include "core/input_codes.h"
 #include "core/cmd_queue.h"
+#include "core/thread_pool.h"
+#include "core/mpmc_queue.h"
 #include "core/window.h"
+#include "core/mapped_file.h"
+#include "core/asset_archive.h"
 
 #include <glm/glm.hpp>
 #include <streambuf>
@@ -25,15 +29,37 @@ namespace gs {
 		}
 	};
 
+	/* the payload of an asset file, past its header
+	 * either owned (read into memory) or a view into a memory mapped file, which is read-only and shared
+	 * with every other gensou_file viewing the same mapping, the mapping lives as long as any of them does
+	 */
 	struct gensou_file
 	{
 		friend class system;
 
 	private:
 		std::unique_ptr<byte[]> m_data;
+		std::shared_ptr<mapped_file> m_mapping;
+		byte* m_view = nullptr;
 		size_t m_size = 0;
 		uuid m_id{ 0ULL };
 
+		void allocate(size_t size)
+		{
+			m_mapping = nullptr;
+			m_data = std::make_unique<byte[]>(size);
+			m_view = m_data.get();
+			m_size = size;
+		}
+
+		void map(std::shared_ptr<mapped_file> mapping, size_t offset, size_t size)
+		{
+			m_data = nullptr;
+			m_view = mapping->data() + offset;
+			m_size = size;
+			m_mapping = std::move(mapping);
+		}
+
 	public:
 		gensou_file() = default;
 
@@ -41,9 +67,9 @@ namespace gs {
 		gensou_file& operator=(const gensou_file&) = delete;
 
 		gensou_file(gensou_file&& other) noexcept
-			: m_data(std::move(other.m_data)), m_size(other.m_size), m_id(other.m_id)
+			: m_data(std::move(other.m_data)), m_mapping(std::move(other.m_mapping)), m_view(other.m_view), m_size(other.m_size), m_id(other.m_id)
 		{
-			other.m_data = nullptr;
+			other.m_view = nullptr;
 			other.m_size = 0;
 			other.m_id = uuid(0ULL);
 		}
@@ -51,28 +77,35 @@ namespace gs {
 		gensou_file& operator=(gensou_file&& other) noexcept
 		{ 
 			m_data = std::move(other.m_data);
+			m_mapping = std::move(other.m_mapping);
+			m_view = other.m_view;
 			m_size = other.m_size;
 			m_id = other.m_id;
 
-			other.m_data = nullptr;
+			other.m_view = nullptr;
 			other.m_size = 0;
 			other.m_id = uuid(0ULL);
 			
 			return *this;
 		}
 
-		byte* data() const { return m_data.get(); }
+		/* must not be written to when mapped() */
+		byte* data() const { return m_view; }
 		size_t size() const { return m_size; }
 		uuid id() const { return m_id; }
 
+		bool mapped() const { return m_mapping != nullptr; }
+
 		gs_stream_buffer data_as_buffer_stream()
 		{
-			return gs_stream_buffer(m_data.get(), m_size);
+			return gs_stream_buffer(m_view, m_size);
 		}
 
 		void reset()
 		{
 			m_data = nullptr;
+			m_mapping = nullptr;
+			m_view = nullptr;
 			m_size = 0ULL;
 			m_id = { 0LL };
 		}
@@ -81,29 +114,47 @@ namespace gs {
 		 * (the cast is not safe, use at your own risk)
 		 * mind that a gensou_file.data is simply a pointer to a buffer of raw data loaded from a file
 		 * it only makes scene to cast it to trivially copyable types (scalars, POD, etc) 
+		 * a mapped file has nothing to yield, its data is copied out
 		 */
 		template<typename T>
 		std::unique_ptr<T> get_data_as()
 		{
 			static_assert(std::is_trivially_copyable_v<T>);
 
-			assert(m_data);
+			assert(m_view);
 			if(sizeof(T) != m_size)
 			{
 				LOG_ENGINE(error, "sizes do not match | sizeof(T) == %zu, m_size == %zu", sizeof(T), m_size);
 				assert(sizeof(T) == m_size);
 			}
 
-			std::unique_ptr<T> out{ reinterpret_cast<T*>(m_data.release()) };
+			std::unique_ptr<T> out;
+			if(m_mapping)
+			{
+				out = std::make_unique<T>();
+				memcpy(out.get(), m_view, sizeof(T));
+			}
+			else
+			{
+				out.reset(reinterpret_cast<T*>(m_data.release()));
+			}
 
 			reset();
 
 			return out;
 		}
 
-		bool valid() const { return m_data && m_size && m_id; }
+		bool valid() const { return m_view && m_size && m_id; }
 
-		operator bool() { return m_data && m_size && m_id; }
+		operator bool() { return m_view && m_size && m_id; }
+	};
+
+	struct loading_queue_stats
+	{
+		uint32_t depth = 0, high_water_mark = 0, capacity = 0;
+
+		/* total tasks submitted and how many times a producer found the queue full */
+		uint64_t submitted = 0, stalls = 0;
 	};
 
 	struct app_settings
@@ -170,6 +221,11 @@ namespace gs {
 
 		static std::shared_ptr<gensou_file> load_file(const std::string& path);
 
+		/* files in a mounted archive (see asset_archive_format.h) are loaded from it instead of from disk, the first mounted wins
+		 * not synchronized with loading, mount before anything is loaded. on desktop init mounts s_default_archives that exist
+		 */
+		static bool mount_archive(const std::string& path);
+
 		/* loads a free file (not a gensou_file) from the application's internal data folder */
 		static std::vector<byte> load_internal_file(const std::string& path);
 
@@ -180,12 +236,15 @@ namespace gs {
 		static void* get_platform_data() { return s_platform_data; }
 		static void set_platform_data(void* data) { s_platform_data = data; }
 
+		/* safe to call from any thread, blocks while the loading queue is full */
 		template<typename Functor>
 		static std::future<void> run_on_loading_thread(Functor&& functor)
 		{
 			return s_loading_thread.submit(std::forward<Functor>(functor));
 		}
 
+		static loading_queue_stats get_loading_queue_stats();
+
 		/* 
 		 * only for regular tasks
 		 * not suitable for vulkan commands as they do not have their own command pool
@@ -194,9 +253,31 @@ namespace gs {
 		template<typename Functor>
 		static std::future<void> run_async(Functor&& functor)
 		{
-			return s_thread_pool.submit(std::forward<Functor>(functor));
+			return s_thread_pool.submit_with_future(std::forward<Functor>(functor));
+		}
+
+		/* same restrictions as run_async, without the future
+		 * small functors (see thread_pool::task_storage_size) are submitted without any allocation
+		 */
+		template<typename Functor>
+		static void submit_async(Functor&& functor, thread_pool::wait_group* group = nullptr)
+		{
+			s_thread_pool.submit(std::forward<Functor>(functor), group);
+		}
+
+		/* runs pending tasks while waiting, safe to call from inside a task */
+		static void wait(thread_pool::wait_group& group) { s_thread_pool.wait(group); }
+
+		/* functor(first, last) over chunks of [begin, end), returns when every chunk is done */
+		template<typename Functor>
+		static void parallel_for(size_t begin, size_t end, size_t grain, Functor&& functor)
+		{
+			s_thread_pool.parallel_for(begin, end, grain, std::forward<Functor>(functor));
 		}
 
+		/* number of threads behind run_async */
+		static uint32_t get_worker_count() { return s_thread_pool.worker_count(); }
+
 		template<typename Functor>
 		static void submit_render_cmd(uint32_t frame, Functor&& functor)
 		{
@@ -215,6 +296,15 @@ namespace gs {
 	private:
 		static std::shared_ptr<gensou_file> deserialize_data_internal(const std::string& path);
 		static std::shared_ptr<app_settings> deserialize_settings();
+
+		/* the mounted archive holding path, if any, and the file's range in its mapping */
+		static bool find_in_archives(const std::string& path, std::shared_ptr<mapped_file>& outMapping, size_t& outOffset, size_t& outSize);
+
+		/* checks the gensou header of the file at [offset, offset + size) of mapping and views its payload, or decodes it if compressed */
+		static std::shared_ptr<gensou_file> view_gensou_file(const std::string& path, std::shared_ptr<mapped_file> mapping, size_t offset, size_t size);
+
+		/* decodes a compressed gensou file (see gensou_file_format.h), header included, into an owned payload */
+		static std::shared_ptr<gensou_file> decode_gensou_file(const std::string& path, const byte* data, size_t size);
 		
 	private:
 		static bool s_rumbler_active;
@@ -223,6 +313,9 @@ namespace gs {
 		static std::shared_ptr<app_settings> s_app_settings;
 		static void* s_platform_data;
 
+		static constexpr const char* s_default_archives[] = { "engine_res.gspak", "resources.gspak" };
+		static std::vector<std::shared_ptr<asset_archive>> s_archives;
+
 	private:
 		/*-----------------THREAD-RELATED--------------------------*/
 		struct render_thread
@@ -277,17 +370,16 @@ namespace gs {
 				task() = default;
 
 				template<typename Functor>
-				task(Functor&& f) : function(f) {}
+				task(Functor&& f) : function(std::forward<Functor>(f)) {}
 
 				std::function<void(void)> function;
 				std::promise<void> promise;
-				bool free = false;
 			};
 
-			/* a simple ring buffer structure */
-			/* only thread-safe if there is a single producer thread and single consumer thread */
-			std::vector<task> task_queue;
-			uint32_t head_ptr = 0, tail_ptr = 0;
+			static constexpr size_t queue_capacity = 256ULL;
+
+			/* lock-free, any thread can submit. a full queue blocks the producer until a slot frees up */
+			mpmc_queue<task> task_queue;
 
 			std::thread thread;
 			mutable std::mutex mutex;
@@ -295,79 +387,71 @@ namespace gs {
 
 			uint32_t id = 0;
 			std::string thread_name;
-			bool is_alive = true;
+			std::atomic<bool> is_alive = true;
+			std::atomic<bool> sleeping = false;
+
+			/* metrics */
+			std::atomic<uint64_t> submitted = 0, stalls = 0;
+			std::atomic<uint32_t> high_water_mark = 0;
 
 			operator bool() const { return id; }
 
-			bool has_work() const { return tail_ptr != head_ptr; }
+			bool has_work() const { return !task_queue.empty_approx(); }
 
 			template<typename Functor>
 			std::future<void> submit(Functor&& functor)
 			{
-				if (head_ptr == task_queue.size())
-					head_ptr = 0;
-
-				task_queue[head_ptr] = task(std::forward<Functor>(functor));
-				auto oldtPtr = head_ptr++;
-
-				std::unique_lock<std::mutex> lock(mutex);
-				mutex_condition.notify_one();
-
-				return task_queue[oldtPtr].promise.get_future();
-			}
-
-		};
-
-		static class thread_pool
-		{
-		public:
-			struct task
-			{
-				task() = default;
-
-				template<typename Functor>
-				task(Functor&& f) : function(f) {}
-
-				std::function<void(void)> function;
-				std::promise<void> promise;
-			};
+				task newTask(std::forward<Functor>(functor));
+				std::future<void> future = newTask.promise.get_future();
 
-			static constexpr uint32_t thread_count = 4UL;
+				if(!task_queue.try_push(newTask))
+				{
+					stalls.fetch_add(1, std::memory_order_relaxed);
+
+					/* the loading thread can't wait on itself, run it right away */
+					if(std::this_thread::get_id() == s_loading_thread_id)
+					{
+						newTask.function();
+						newTask.promise.set_value();
+						return future;
+					}
+
+					/* backpressure, wait for the loading thread to free a slot */
+					while(!task_queue.try_push(newTask))
+					{
+						wake();
+						std::this_thread::yield();
+					}
+				}
 
-			std::vector<std::thread> threads;
-			std::queue<task> tasks_queue;
+				submitted.fetch_add(1, std::memory_order_relaxed);
 
-			mutable std::mutex mutex;
-			std::condition_variable mutex_condition;
-
-			bool is_alive = true;
+				uint32_t depth = (uint32_t)task_queue.size_approx();
+				uint32_t highWaterMark = high_water_mark.load(std::memory_order_relaxed);
+				while(depth > highWaterMark && !high_water_mark.compare_exchange_weak(highWaterMark, depth, std::memory_order_relaxed)) {}
 
-			/*------------------------------------------------------------------*/
-			void terminate()
-			{
-				{
-					std::unique_lock<std::mutex> lock(s_render_thread.mutex);
-					is_alive = false;
-					mutex_condition.notify_all();
-				}
-				
-				for(auto& t : threads)
-					t.join();
+				wake();
 
-				threads.clear();
+				return future;
 			}
 
-			template<typename Functor>
-			std::future<void> submit(Functor&& functor)
+			/* the push has to be visible before sleeping is read, and the loading thread reads the queue only after storing it:
+			 * the two fences make sure that either it sees the task or this sees it asleep, plain loads and stores don't
+			 */
+			void wake()
 			{
-				std::unique_lock<std::mutex> lock(mutex);
-				auto& newTask = tasks_queue.emplace(std::forward<Functor>(functor));
-				mutex_condition.notify_one();
+				std::atomic_thread_fence(std::memory_order_seq_cst);
 
-				return newTask.promise.get_future();
+				if(sleeping.load(std::memory_order_relaxed))
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					mutex_condition.notify_one();
+				}
 			}
+		};
 
-		} s_thread_pool;
+		/* work-stealing pool behind run_async, submit_async and parallel_for */
+		static thread_pool s_thread_pool;
 
 		/* the render, loading and main threads can do operations that require command buffers */
 		static render_thread s_render_thread;
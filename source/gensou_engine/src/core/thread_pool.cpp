@@ -0,0 +1,297 @@
+#include "core/thread_pool.h"
+
+#include "core/log.h"
+
+namespace gs {
+
+	static constexpr int64_t s_task_mask = (int64_t)thread_pool::task_capacity - 1LL;
+
+	/* set on worker threads only */
+	static thread_local thread_pool* s_worker_pool = nullptr;
+	static thread_local int32_t s_worker_index = -1;
+
+	//////////////////////////////////////////////////////////////////////////
+	// work_deque
+	//////////////////////////////////////////////////////////////////////////
+
+	void thread_pool::work_deque::push(task* newTask)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+
+		/* release publishes the task (and its functor) to the thieves' acquire load of bottom */
+		m_buffer[bottom & s_task_mask].store(newTask, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+	}
+
+	thread_pool::task* thread_pool::work_deque::pop()
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if(top > bottom)
+		{
+			/* empty */
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		task* outTask = m_buffer[bottom & s_task_mask].load(std::memory_order_relaxed);
+
+		if(top == bottom)
+		{
+			/* last element, race against the thieves for it */
+			if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				outTask = nullptr;
+
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return outTask;
+	}
+
+	thread_pool::task* thread_pool::work_deque::steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if(top >= bottom)
+			return nullptr;
+
+		task* outTask = m_buffer[top & s_task_mask].load(std::memory_order_relaxed);
+
+		/* lost the race to another thief or to the owner */
+		if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return outTask;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// thread_pool
+	//////////////////////////////////////////////////////////////////////////
+
+	void thread_pool::init(uint32_t workerCount)
+	{
+		if(m_alive.load())
+			return;
+
+		/* leave room for the main and render threads, they are busy every frame */
+		if(!workerCount)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = std::max(hardwareThreads > 2U ? hardwareThreads - 2U : 0U, 2U);
+		}
+
+		m_tasks = std::make_unique<task[]>(task_capacity);
+		m_injection_queue.resize(task_capacity);
+		m_alive.store(true);
+
+		/* every deque has to exist before any worker starts stealing */
+		for(uint32_t i = 0; i < workerCount; i++)
+		{
+			auto& newWorker = m_workers.emplace_back(std::make_unique<worker>());
+			newWorker->random_state = 0x9E3779B9U * (i + 1);
+		}
+
+		for(uint32_t i = 0; i < workerCount; i++)
+			m_workers[i]->thread = std::thread([this, i]() { worker_loop(i); });
+
+		LOG_ENGINE(trace, "thread pool started with %u workers", workerCount);
+	}
+
+	void thread_pool::terminate()
+	{
+		if(!m_alive.exchange(false))
+			return;
+
+		{
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleep_condition.notify_all();
+		}
+
+		for(auto& w : m_workers)
+			w->thread.join();
+
+		/* a submission that saw the pool alive is pushed before the queues are drained, any later one runs inline */
+		while(m_submitting.load(std::memory_order_seq_cst))
+			std::this_thread::yield();
+
+		/* whatever is left runs here, anything it submits runs inline */
+		uint32_t drainedCount = 0;
+		while(task* pTask = find_task(-1))
+		{
+			execute(pTask);
+			drainedCount++;
+		}
+
+		if(drainedCount)
+			LOG_ENGINE(trace, "thread pool ran %u tasks left at termination", drainedCount);
+
+		m_workers.clear();
+	}
+
+	thread_pool::task* thread_pool::allocate_task()
+	{
+		/* seq_cst on both sides, either terminate sees the submission or the submission sees the pool stopped */
+		m_submitting.fetch_add(1, std::memory_order_seq_cst);
+
+		if(!m_alive.load(std::memory_order_seq_cst))
+		{
+			m_submitting.fetch_sub(1, std::memory_order_release);
+			return nullptr;
+		}
+
+		/* slots are handed out round robin, so the one under the cursor is almost always free already */
+		for(size_t tries = 0; tries < task_capacity; tries++)
+		{
+			task& slot = m_tasks[m_task_cursor.fetch_add(1, std::memory_order_relaxed) & (task_capacity - 1)];
+
+			bool expected = false;
+			if(!slot.in_use.load(std::memory_order_relaxed) && slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				return &slot;
+		}
+
+		m_submitting.fetch_sub(1, std::memory_order_release);
+		return nullptr;
+	}
+
+	void thread_pool::push(task* newTask)
+	{
+		if(s_worker_pool == this)
+			m_workers[s_worker_index]->deque.push(newTask);
+		else
+			m_injection_queue.try_push(newTask);
+
+		m_queued.fetch_add(1, std::memory_order_seq_cst);
+
+		if(m_sleeping.load(std::memory_order_seq_cst))
+		{
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleep_condition.notify_one();
+		}
+
+		m_submitting.fetch_sub(1, std::memory_order_release);
+	}
+
+	thread_pool::task* thread_pool::find_task(int32_t workerIndex)
+	{
+		task* outTask = nullptr;
+
+		if(workerIndex >= 0)
+			outTask = m_workers[workerIndex]->deque.pop();
+
+		if(!outTask)
+			m_injection_queue.try_pop(outTask);
+
+		if(!outTask)
+		{
+			const uint32_t workerCount = (uint32_t)m_workers.size();
+
+			/* xorshift, any thread that is not a worker just starts from 0 */
+			uint32_t start = 0;
+			if(workerIndex >= 0)
+			{
+				uint32_t& state = m_workers[workerIndex]->random_state;
+				state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+				start = state % workerCount;
+			}
+
+			for(uint32_t i = 0; i < workerCount && !outTask; i++)
+			{
+				uint32_t victim = (start + i) % workerCount;
+				if((int32_t)victim != workerIndex)
+					outTask = m_workers[victim]->deque.steal();
+			}
+		}
+
+		if(outTask)
+			m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+		return outTask;
+	}
+
+	void thread_pool::execute(task* pTask)
+	{
+		/* the group may be gone as soon as its count hits 0, read it first */
+		wait_group* group = pTask->group;
+
+		pTask->invoke(pTask->storage);
+		pTask->in_use.store(false, std::memory_order_release);
+
+		if(group)
+			finish_group_task(group);
+	}
+
+	void thread_pool::finish_group_task(wait_group* group)
+	{
+		/* the group may be gone right after the decrement, only the pool is touched past it
+		 * seq_cst pairs with the sleeper's increment of m_sleeping and its check of the count
+		 */
+		if(group->count.fetch_sub(1, std::memory_order_seq_cst) == 1 && m_sleeping.load(std::memory_order_seq_cst))
+		{
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleep_condition.notify_all();
+		}
+	}
+
+	void thread_pool::wait(wait_group& group)
+	{
+		const int32_t workerIndex = s_worker_pool == this ? s_worker_index : -1;
+
+		while(!group.done())
+		{
+			if(task* pTask = find_task(workerIndex))
+			{
+				execute(pTask);
+				continue;
+			}
+
+			/* the tasks left are running elsewhere, sleep until one of them finishes the group or new ones are queued */
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+
+			m_sleep_condition.wait(lock, [this, &group]
+			{
+				return group.count.load(std::memory_order_seq_cst) == 0 || m_queued.load(std::memory_order_seq_cst) > 0 || !m_alive.load();
+			});
+
+			m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+			/* push wakes a single sleeper, if it was this one and it leaves without the task an idle worker gets the wakeup instead */
+			if(group.done() && m_queued.load(std::memory_order_seq_cst) > 0)
+				m_sleep_condition.notify_one();
+		}
+	}
+
+	void thread_pool::worker_loop(uint32_t workerIndex)
+	{
+		s_worker_pool = this;
+		s_worker_index = (int32_t)workerIndex;
+
+		while(m_alive.load(std::memory_order_relaxed))
+		{
+			if(task* pTask = find_task((int32_t)workerIndex))
+			{
+				execute(pTask);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+
+			m_sleep_condition.wait(lock, [this]
+			{
+				return m_queued.load(std::memory_order_seq_cst) > 0 || !m_alive.load();
+			});
+
+			m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		s_worker_pool = nullptr;
+		s_worker_index = -1;
+	}
+}
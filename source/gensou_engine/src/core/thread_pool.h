@@ -0,0 +1,224 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/mpmc_queue.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <vector>
+
+namespace gs {
+
+	/*
+	 * work-stealing thread pool
+	 * every worker owns a Chase-Lev deque: it pushes and pops at the bottom, idle workers steal from the top
+	 * threads that are not workers (main, render, loading) submit through a shared lock-free injection queue
+	 *
+	 * tasks live in a fixed slab and functors up to task_storage_size bytes are stored inline,
+	 * so submitting a small task never allocates. bigger functors fall back to the heap
+	 */
+	class thread_pool
+	{
+	public:
+		static constexpr size_t task_storage_size = 48ULL;
+		static constexpr size_t task_capacity = 4096ULL; /* power of 2 */
+
+		/* counts unfinished tasks, wait() returns once it reaches 0 */
+		struct wait_group
+		{
+			std::atomic<uint32_t> count{ 0 };
+			bool done() const { return count.load(std::memory_order_acquire) == 0; }
+		};
+
+		thread_pool() = default;
+		~thread_pool() { terminate(); }
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/* 0 == derive it from std::thread::hardware_concurrency */
+		void init(uint32_t workerCount = 0);
+
+		/* joins the workers, tasks still queued run on the calling thread so their functors (and promises) are not lost */
+		void terminate();
+
+		uint32_t worker_count() const { return (uint32_t)m_workers.size(); }
+
+		/* fire and forget, optionally tracked by a wait_group */
+		template<typename Functor>
+		void submit(Functor&& functor, wait_group* group = nullptr)
+		{
+			using functor_type = std::decay_t<Functor>;
+
+			if(group)
+				group->count.fetch_add(1, std::memory_order_relaxed);
+
+			task* newTask = allocate_task();
+
+			/* every slot is taken (or the pool is not running), run it right here as backpressure */
+			if(!newTask)
+			{
+				functor_type localFunctor(std::forward<Functor>(functor));
+				localFunctor();
+
+				if(group)
+					finish_group_task(group);
+
+				return;
+			}
+
+			newTask->group = group;
+
+			if constexpr (sizeof(functor_type) <= task_storage_size && alignof(functor_type) <= alignof(std::max_align_t))
+			{
+				new(newTask->storage) functor_type(std::forward<Functor>(functor));
+				newTask->invoke = [](void* storage)
+				{
+					auto pFunctor = (functor_type*)storage;
+					(*pFunctor)();
+					pFunctor->~functor_type();
+				};
+			}
+			else
+			{
+				*(functor_type**)newTask->storage = new functor_type(std::forward<Functor>(functor));
+				newTask->invoke = [](void* storage)
+				{
+					auto pFunctor = *(functor_type**)storage;
+					(*pFunctor)();
+					delete pFunctor;
+				};
+			}
+
+			push(newTask);
+		}
+
+		/* same as submit but with a future to wait on (the promise's shared state does allocate) */
+		template<typename Functor>
+		std::future<void> submit_with_future(Functor&& functor)
+		{
+			std::promise<void> promise;
+			std::future<void> future = promise.get_future();
+
+			submit([fn = std::forward<Functor>(functor), promise = std::move(promise)]() mutable
+			{
+				fn();
+				promise.set_value();
+			});
+
+			return future;
+		}
+
+		/* blocks until group is done, executing pending tasks in the meantime so it is safe to wait from inside a task
+		 * with nothing left to run or steal it sleeps like an idle worker, until a task is queued or group is done
+		 */
+		void wait(wait_group& group);
+
+		/* splits [begin, end) in chunks of at least grain and calls functor(first, last) for each of them
+		 * the calling thread runs the first chunk and helps with the rest, returns when all of them are done
+		 */
+		template<typename Functor>
+		void parallel_for(size_t begin, size_t end, size_t grain, Functor&& functor)
+		{
+			if(begin >= end)
+				return;
+
+			const size_t count = end - begin;
+			const size_t maxChunks = (size_t)worker_count() + 1ULL;
+
+			grain = std::max<size_t>(grain, 1ULL);
+			size_t chunk = std::max<size_t>(grain, (count + maxChunks - 1) / maxChunks);
+
+			wait_group group;
+
+			for(size_t first = begin + chunk; first < end; first += chunk)
+			{
+				size_t last = std::min(first + chunk, end);
+				submit([&functor, first, last]() { functor(first, last); }, &group);
+			}
+
+			functor(begin, std::min(begin + chunk, end));
+
+			wait(group);
+		}
+
+	private:
+		struct alignas(64) task
+		{
+			void (*invoke)(void*) = nullptr;
+			wait_group* group = nullptr;
+			std::atomic<bool> in_use{ false };
+
+			alignas(std::max_align_t) byte storage[task_storage_size];
+		};
+
+		/* Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models")
+		 * fixed capacity, it can never hold more than every task in the slab
+		 */
+		class work_deque
+		{
+		public:
+			work_deque() : m_buffer(std::make_unique<std::atomic<task*>[]>(task_capacity)) {}
+
+			/* owner only */
+			void push(task* newTask);
+			task* pop();
+
+			/* any thread */
+			task* steal();
+
+			bool empty() const { return m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed); }
+
+		private:
+			alignas(64) std::atomic<int64_t> m_top{ 0 };
+			alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+			std::unique_ptr<std::atomic<task*>[]> m_buffer;
+		};
+
+		struct worker
+		{
+			std::thread thread;
+			work_deque deque;
+			uint32_t random_state = 0;
+		};
+
+		/* a task returned by allocate_task counts as a submission in progress until it is pushed */
+		task* allocate_task();
+		void push(task* newTask);
+
+		/* own deque first, then the injection queue, then steal from a random victim */
+		task* find_task(int32_t workerIndex);
+		void execute(task* pTask);
+
+		/* wakes the sleepers when the group's last task is done, one of them may be waiting on it */
+		void finish_group_task(wait_group* group);
+
+		void worker_loop(uint32_t workerIndex);
+
+	private:
+		std::unique_ptr<task[]> m_tasks;
+		std::atomic<size_t> m_task_cursor{ 0 };
+
+		std::vector<std::unique_ptr<worker>> m_workers;
+		/* submissions from threads that are not workers, can't overflow since it never holds more than the slab */
+		mpmc_queue<task*> m_injection_queue;
+
+		/* tasks pushed and not yet taken, workers only go to sleep when this is 0 */
+		std::atomic<int64_t> m_queued{ 0 };
+		/* idle workers and threads in wait() */
+		std::atomic<uint32_t> m_sleeping{ 0 };
+
+		/* tasks between allocate_task and push, terminate drains the queues only once none are left */
+		std::atomic<uint32_t> m_submitting{ 0 };
+
+		std::mutex m_sleep_mutex;
+		std::condition_variable m_sleep_condition;
+
+		std::atomic<bool> m_alive{ false };
+	};
+}
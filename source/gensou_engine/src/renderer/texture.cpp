@@ -177,6 +177,12 @@ namespace gs {
         return outTexture;
 	}
 
+	texture_data::~texture_data()
+	{
+		if (pixels)
+			stbi_image_free(pixels);
+	}
+
 	std::shared_ptr<texture> texture::create(const std::string& path, bool mips, bool flipOnLoad, sampler_info samplerInfo)
 	{
 		if (auto id = system::get_cached_id_from_file(path))
@@ -193,35 +199,73 @@ namespace gs {
 			}
 		}
 
-		std::shared_ptr<texture> outTexture;
-		auto data = system::load_file(path);
-
+		auto data = decode(path, mips);
 		if (!data)
-			return outTexture;
+			return std::shared_ptr<texture>();
+
+		return create(path, std::move(data), samplerInfo);
+	}
+
+	std::shared_ptr<texture_data> texture::decode(const std::string& path, bool mips)
+	{
+		std::shared_ptr<texture_data> outData = std::make_shared<texture_data>();
+		outData->mips = mips;
+		outData->file = system::load_file(path);
+
+		if (!outData->file)
+			return std::shared_ptr<texture_data>();
+
+		const byte* fileData = outData->file->data();
+
+		/* compressed formats are uploaded straight from the file */
+		if (is_astc(fileData) || is_ktx1(fileData) || is_ktx2(fileData))
+			return outData;
+
+		if (!decode_pixels(fileData, outData->file->size(), mips, *outData))
+		{
+			LOG_ENGINE(error, "Failed to decode texture from path '%s'", path.c_str());
+			return std::shared_ptr<texture_data>();
+		}
+
+		return outData;
+	}
+
+	std::shared_ptr<texture> texture::create(const std::string& path, std::shared_ptr<texture_data> data, sampler_info samplerInfo)
+	{
+		/* decoded twice (two requests raced), the first one uploaded is the texture */
+		const auto mapIterator = s_textures_atlas.find(data->file->id());
+		if (mapIterator != s_textures_atlas.end() && !mapIterator->second.expired())
+		{
+			LOG_ENGINE(trace, "texture with path '%s' found", path.c_str());
+			return std::shared_ptr<texture>(mapIterator->second);
+		}
 
-		if (is_astc(data->data()))
+		std::shared_ptr<texture> outTexture;
+		const byte* fileData = data->file->data();
+
+		if (data->pixels)
+		{
+			outTexture = create_from_pixels(data->pixels, data->size, data->extent, data->mips, data->format, samplerInfo);
+		}
+		else if (is_astc(fileData))
 		{
 			LOG_ENGINE(trace, "Loaded ASTC texture");
-			outTexture = create_from_astc(data, mips, samplerInfo);
+			outTexture = create_from_astc(data->file, data->mips, samplerInfo);
 		}
-		else if(is_ktx1(data->data()))
+		else if(is_ktx1(fileData))
 		{
 			LOG_ENGINE(trace, "Loaded KTX texture");
-			outTexture = create_from_ktx(data, mips, samplerInfo);
+			outTexture = create_from_ktx(data->file, data->mips, samplerInfo);
 		}
-		else if(is_ktx2(data->data()))
+		else if(is_ktx2(fileData))
 		{
 			LOG_ENGINE(trace, "Loaded KTX2 texture");
-			outTexture = create_from_ktx2(data, mips, samplerInfo);
-		}
-		else /* other (png, jpeg, etc)  */
-		{
-			outTexture = create_from_memory(data->data(), data->size(), mips, samplerInfo);
+			outTexture = create_from_ktx2(data->file, data->mips, samplerInfo);
 		}
 
 		if (outTexture)
 		{
-			outTexture->m_image->m_id = data->id();
+			outTexture->m_image->m_id = data->file->id();
 			LOG_ENGINE(trace, "adding texture from path [%s] and id 0x%xll to the textures atlas", path.c_str(), outTexture->get_image_id());
 
 			s_textures_atlas[outTexture->get_image_id()] = std::weak_ptr<texture>(outTexture);
@@ -241,6 +285,15 @@ namespace gs {
 	}
 
 	std::shared_ptr<texture> texture::create_from_memory(const byte* data, size_t size, bool mips, sampler_info samplerInfo)
+	{
+		texture_data decoded;
+		if (!decode_pixels(data, size, mips, decoded))
+			return std::shared_ptr<texture>();
+
+		return create_from_pixels(decoded.pixels, decoded.size, decoded.extent, mips, decoded.format, samplerInfo);
+	}
+
+	bool texture::decode_pixels(const byte* data, size_t size, bool mips, texture_data& outData)
 	{
 		int width, height, channels;
 		byte* pixels = nullptr;
@@ -288,10 +341,15 @@ namespace gs {
 			format = mips ? device::get_color_blitt_format(VK_FORMAT_R8G8B8A8_SRGB) : VK_FORMAT_R8G8B8A8_SRGB;
 		}
 
-		std::shared_ptr<texture> outTexture = create_from_pixels(pixels, imageSize, extent2d(width, height), mips, format, samplerInfo);
-		stbi_image_free(pixels);
+		if (!pixels)
+			return false;
 
-		return outTexture;
+		outData.pixels = pixels;
+		outData.size = imageSize;
+		outData.extent = extent2d(width, height);
+		outData.format = format;
+
+		return true;
 	}
 
 	std::shared_ptr<texture> texture::create_from_pixels(const byte* pixels, size_t size, extent2d extent, bool mips, VkFormat format, sampler_info samplerInfo)
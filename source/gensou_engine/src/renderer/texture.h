@@ -4,6 +4,7 @@
 #include "core/misc.h"
 #include "core/uuid.h"
 #include "core/engine_events.h"
+#include "core/asset_manager.h"
 
 #include "renderer/device.h"
 #include "renderer/image.h"
@@ -30,6 +31,27 @@ namespace gs {
 		} wrap;
 	};
 
+	/* a texture file read and, for regular images (png, jpg, hdr...), decoded to pixels, nothing uploaded yet
+	 * the cpu half of texture::create(path), see texture::decode
+	 */
+	struct texture_data
+	{
+		std::shared_ptr<gensou_file> file;
+
+		/* null for formats uploaded as they are (astc, ktx, ktx2) */
+		byte* pixels = nullptr;
+		size_t size = 0;
+		extent2d extent;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		bool mips = false;
+
+		texture_data() = default;
+		~texture_data();
+
+		texture_data(const texture_data&) = delete;
+		texture_data& operator=(const texture_data&) = delete;
+	};
+
 	class texture
 	{
 		static std::unordered_map<uuid, std::weak_ptr<texture>> s_textures_atlas;
@@ -40,6 +62,13 @@ namespace gs {
 		static std::shared_ptr<texture> create(const std::string& path, bool mips = false, bool flipOnLoad = INVERT_VIEWPORT, sampler_info samplerInfo = {});
 		static std::shared_ptr<texture> create(std::shared_ptr<image2d> image, sampler_info samplerInfo = {});
 
+		/* create(path) in two halves, so the decoding can run anywhere (see asset_traits<texture>)
+		 * decode reads the file and decodes regular images, safe on any thread. null if either fails
+		 * create uploads it and registers it as path's texture, on threads that can record vulkan commands only
+		 */
+		static std::shared_ptr<texture_data> decode(const std::string& path, bool mips = false);
+		static std::shared_ptr<texture> create(const std::string& path, std::shared_ptr<texture_data> data, sampler_info samplerInfo = {});
+
 		/* raw data loaded from a compressed file (png, jpg, etc) */
 		static std::shared_ptr<texture> create_from_memory(const byte* data, size_t size, bool mips, sampler_info samplerInfo = {});
 
@@ -56,6 +85,8 @@ namespace gs {
 		static std::shared_ptr<texture> create_from_ktx (std::shared_ptr<gensou_file> file, bool mips, sampler_info samplerInfo = {});
 		static std::shared_ptr<texture> create_from_ktx2(std::shared_ptr<gensou_file> file, bool mips, sampler_info samplerInfo = {});
 
+		static bool decode_pixels(const byte* data, size_t size, bool mips, texture_data& outData);
+
 		texture(const byte* pixels, size_t size, extent2d extent, bool mips, VkFormat format, sampler_info samplerInfo = {});
 		texture(std::shared_ptr<image2d> image, sampler_info samplerInfo = {});
 
@@ -90,6 +121,17 @@ namespace gs {
 		std::string m_path;
 	};
 
+	/* decoded on a worker, uploaded on the loading thread, without mips and with the default sampler */
+	template<>
+	struct asset_traits<texture>
+	{
+		using decoded_type = texture_data;
+		static constexpr bool create_on_loading_thread = true;
+
+		static std::shared_ptr<texture_data> decode(const std::string& path) { return texture::decode(path); }
+		static std::shared_ptr<texture> create(const std::string& path, std::shared_ptr<texture_data> decoded) { return texture::create(path, std::move(decoded)); }
+	};
+
 	class texture_cube
 	{
 	public:
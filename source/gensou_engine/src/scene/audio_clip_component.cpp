@@ -14,25 +14,32 @@ POP_IGNORE_WARNING
 namespace gs {
 
     std::unordered_map<std::string, std::weak_ptr<vorbis_audio_data>> vorbis_audio_data::s_audio_atlas;
+    std::mutex vorbis_audio_data::s_audio_atlas_mutex;
 
     std::shared_ptr<vorbis_audio_data> vorbis_audio_data::create(const std::string& path)
     {
-        const auto mapIterator = s_audio_atlas.find(path);
-        if (mapIterator != s_audio_atlas.end())
         {
-            auto audioWeakPtr = mapIterator->second;
-            if (!audioWeakPtr.expired())
+            std::unique_lock<std::mutex> lock(s_audio_atlas_mutex);
+
+            const auto mapIterator = s_audio_atlas.find(path);
+            if (mapIterator != s_audio_atlas.end())
             {
-                LOG_ENGINE(trace, "texture with path '%s' found", path.c_str());
-                return std::shared_ptr<vorbis_audio_data>(audioWeakPtr);
+                if (auto outData = mapIterator->second.lock())
+                {
+                    LOG_ENGINE(trace, "audio data with path '%s' found", path.c_str());
+                    return outData;
+                }
             }
         }
 
+        /* decoded unlocked, asset_manager decodes clips on several workers at once */
         auto outData = std::make_shared<vorbis_audio_data>(path);
         if(outData->valid())
         {
-            s_audio_atlas[path] = std::weak_ptr<vorbis_audio_data>(outData);
             outData->path = path;
+
+            std::unique_lock<std::mutex> lock(s_audio_atlas_mutex);
+            s_audio_atlas[path] = std::weak_ptr<vorbis_audio_data>(outData);
             return outData;
         }
 
@@ -137,6 +144,8 @@ namespace gs {
 
 		if (!path.empty())
 		{
+			std::unique_lock<std::mutex> lock(s_audio_atlas_mutex);
+
 			const auto mapIterator = s_audio_atlas.find(path);
 			if(mapIterator != s_audio_atlas.end())
 			{
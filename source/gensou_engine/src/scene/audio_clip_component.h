@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/core.h"
+#include "core/asset_manager.h"
 #include "scene/audio_mixer.h"
 #include "scene/game_object.h"
 
@@ -42,6 +43,18 @@ namespace gs {
         std::string path;
 
         static std::unordered_map<std::string, std::weak_ptr<vorbis_audio_data>> s_audio_atlas;
+        static std::mutex s_audio_atlas_mutex;
+    };
+
+    /* decoded whole on a worker, there is nothing left for the loading thread */
+    template<>
+    struct asset_traits<vorbis_audio_data>
+    {
+        using decoded_type = vorbis_audio_data;
+        static constexpr bool create_on_loading_thread = false;
+
+        static std::shared_ptr<vorbis_audio_data> decode(const std::string& path) { return vorbis_audio_data::create(path); }
+        static std::shared_ptr<vorbis_audio_data> create(const std::string&, std::shared_ptr<vorbis_audio_data> decoded) { return decoded; }
     };
 
     /* only vorbis is supported for the moment */
@@ -2,6 +2,7 @@
 
 #include "core/system.h"
 #include "core/runtime.h"
+#include "core/asset_manager.h"
 #include "core/engine_events.h"
 
 #include "scene/scene.h"
@@ -76,6 +77,7 @@ namespace gs {
 		if(m_current_scene && !keepOldSceneAlive)
 		{
 			m_current_scene->on_terminate();
+			asset_manager::cancel(m_current_scene.get());
 		}
 
 		m_current_scene = inScene;
@@ -806,6 +806,7 @@ namespace gs {
 		LOG_ENGINE(trace, "terminating scene with tag '%s'", scene_tag.c_str());
 
 		on_terminate();
+		asset_manager::cancel(this);
 
 		m_registry.clear<id_component>();
 
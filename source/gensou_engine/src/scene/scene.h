@@ -4,6 +4,7 @@
 #include "core/log.h"
 #include "core/system.h"
 #include "core/runtime.h"
+#include "core/asset_manager.h"
 
 #include "scene/audio_mixer.h"
 #include "scene/game_instance.h"
@@ -147,6 +148,17 @@ namespace gs {
 		/* return null if mixer not found */
 		std::shared_ptr<audio_mixer> get_audio_mixer(const std::string& mixerName);
 
+		/*--------------assets------------------------------------------*/
+
+		/* loads on asset_manager's workers, cancelled if the scene is torn down before the asset is done
+		 * in on_init start every load first and asset_manager::get them afterwards, they load side by side
+		 */
+		template<typename T>
+		asset_manager::asset_future<T> load_async(const std::string& path, load_priority priority = load_priority::normal)
+		{
+			return asset_manager::load_async<T>(path, priority, this);
+		}
+
 	protected:
 		[[nodiscard]] virtual scene* get_loading_scene();
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "simd.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+/* rows x columns of every layer in resources/model.gsasset, model_0.gsasset and model_1.gsasset */
+inline const std::pair<size_t, size_t> s_layer_shapes[] = {
+    { 8, 64 }, { 64, 64 }, { 64, 1 }, { 64, 256 }, { 256, 64 }
+};
+
+/* seconds per call, after warming up caches and finding an iteration count that runs for at least minSeconds */
+template<typename Kernel>
+inline double time_kernel(Kernel&& kernel, double minSeconds = 0.05)
+{
+    using clock = std::chrono::steady_clock;
+
+    size_t iterations = 1;
+    for (;;)
+    {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++)
+            kernel();
+
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        if (elapsed > minSeconds)
+            return elapsed / double(iterations);
+
+        iterations *= 2;
+    }
+}
+
+/* same scheme as model::quantize_weights, symmetric with one scale per output channel */
+inline void quantize_rows(const std::vector<float>& weights, size_t m, size_t n, std::vector<int8_t>& outWeights, std::vector<float>& outScales, std::vector<int32_t>& outRowSums)
+{
+    const size_t paddedM = simd::int8_padded_row(m);
+
+    outWeights.assign(paddedM * n, 0);
+    outScales.resize(n);
+    outRowSums.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        float maxAbs = 0.0f;
+        for (size_t j = 0; j < m; j++)
+            maxAbs = std::max(maxAbs, std::abs(weights[i * m + j]));
+
+        outScales[i] = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+        outRowSums[i] = 0;
+
+        for (size_t j = 0; j < m; j++)
+        {
+            int32_t q = std::clamp((int32_t)std::nearbyint(weights[i * m + j] / outScales[i]), -127, 127);
+            outWeights[i * paddedM + j] = (int8_t)q;
+            outRowSums[i] += q;
+        }
+    }
+}
+
+/* conformance.cpp, every kernel of every supported isa against simd::scalar over randomized shapes
+ * returns the number of kernels outside their tolerance
+ */
+int check_kernels(uint32_t seed, size_t caseCount);
+
+/* micro_bench.cpp, time, GFLOP/s and GB/s per kernel and layer shape for the active isa
+ * only the benchmarks whose name contains filter run (all of them when it is empty)
+ */
+void run_micro_benchmarks(const char* filter);
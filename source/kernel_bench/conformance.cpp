@@ -0,0 +1,473 @@
+#include "bench_common.hpp"
+
+#include <cstring>
+
+/* one randomized problem, every kernel runs on the same shape */
+struct test_case
+{
+    size_t m, n, batch, inStride, outStride;
+};
+
+/* worst error of one kernel over every case, and the case it happened on */
+struct kernel_result
+{
+    const char* name;
+    float tolerance;
+
+    float error = 0.0f;
+    test_case worst = {};
+
+    void update(float newError, const test_case& testCase)
+    {
+        /* nan never compares greater, it has to fail explicitly */
+        if (std::isnan(newError) || newError > error)
+        {
+            error = std::isnan(newError) ? INFINITY : newError;
+            worst = testCase;
+        }
+    }
+};
+
+/* the transcendental activations are polynomial approximations, everything else only reorders sums */
+static constexpr float s_linear_tolerance = 1e-4f;
+static constexpr float s_activation_tolerance = 1e-5f;
+
+enum kernel_id : uint32_t
+{
+    k_accumulate = 0, k_vec_mat_mul, k_mat_mat_mul, k_set_to_zero, k_set_range_value, k_scale_offset,
+    k_quantize_input, k_vec_mat_mul_i8, k_mat_mat_mul_i8,
+    k_add_bias_sigmoid, k_add_bias_tanh, k_add_bias_relu, k_add_bias_leaky_relu,
+    k_fused_sigmoid, k_fused_tanh, k_fused_relu, k_fused_leaky_relu,
+    k_mat_mat_mul_packed, k_packed_sigmoid, k_packed_tanh, k_packed_relu, k_packed_leaky_relu,
+    k_add_bias_linear, k_fused_linear, k_packed_linear,
+    k_mat_t_mat_mul, k_rank1_update, k_rank_k_update, k_accumulate_rows,
+    k_mul_derivative_sigmoid, k_mul_derivative_tanh, k_mul_derivative_relu, k_mul_derivative_leaky_relu,
+
+    /* one block per approximate activation_accuracy, in the enum's order */
+    k_sigmoid_polynomial, k_tanh_polynomial, k_fused_sigmoid_polynomial, k_fused_tanh_polynomial, k_packed_sigmoid_polynomial, k_packed_tanh_polynomial,
+    k_sigmoid_rational, k_tanh_rational, k_fused_sigmoid_rational, k_fused_tanh_rational, k_packed_sigmoid_rational, k_packed_tanh_rational,
+    k_count
+};
+
+static constexpr uint32_t s_accuracy_block = k_sigmoid_rational - k_sigmoid_polynomial;
+
+static const kernel_result s_kernels[k_count] = {
+    { "accumulate", s_linear_tolerance }, { "vec_mat_mul", s_linear_tolerance }, { "mat_mat_mul", s_linear_tolerance },
+    { "set_to_zero", 0.0f }, { "set_range_value", 0.0f }, { "scale_offset", s_linear_tolerance },
+    { "quantize_input", 0.0f }, { "vec_mat_mul_i8", s_linear_tolerance }, { "mat_mat_mul_i8", s_linear_tolerance },
+    { "add_bias_sigmoid", s_activation_tolerance }, { "add_bias_tanh", s_activation_tolerance },
+    { "add_bias_relu", 0.0f }, { "add_bias_leaky_relu", 0.0f },
+    { "mat_mat_mul_bias_sigmoid", s_linear_tolerance }, { "mat_mat_mul_bias_tanh", s_linear_tolerance },
+    { "mat_mat_mul_bias_relu", s_linear_tolerance }, { "mat_mat_mul_bias_leaky_relu", s_linear_tolerance },
+    { "mat_mat_mul_packed", s_linear_tolerance }, { "mat_mat_mul_packed_bias_sigmoid", s_linear_tolerance },
+    { "mat_mat_mul_packed_bias_tanh", s_linear_tolerance }, { "mat_mat_mul_packed_bias_relu", s_linear_tolerance },
+    { "mat_mat_mul_packed_bias_leaky_relu", s_linear_tolerance },
+    { "add_bias_linear", 0.0f }, { "mat_mat_mul_bias_linear", s_linear_tolerance }, { "mat_mat_mul_packed_bias_linear", s_linear_tolerance },
+    { "mat_t_mat_mul", s_linear_tolerance }, { "rank1_update", s_linear_tolerance }, { "rank_k_update", s_linear_tolerance },
+    { "accumulate_rows", s_linear_tolerance }, { "mul_derivative_sigmoid", s_activation_tolerance }, { "mul_derivative_tanh", s_activation_tolerance },
+    { "mul_derivative_relu", 0.0f }, { "mul_derivative_leaky_relu", 0.0f },
+    { "add_bias_sigmoid/polynomial", s_activation_tolerance }, { "add_bias_tanh/polynomial", s_activation_tolerance },
+    { "mat_mat_mul_bias_sigmoid/polynomial", s_linear_tolerance }, { "mat_mat_mul_bias_tanh/polynomial", s_linear_tolerance },
+    { "mat_mat_mul_packed_bias_sigmoid/polynomial", s_linear_tolerance }, { "mat_mat_mul_packed_bias_tanh/polynomial", s_linear_tolerance },
+    { "add_bias_sigmoid/rational", s_activation_tolerance }, { "add_bias_tanh/rational", s_activation_tolerance },
+    { "mat_mat_mul_bias_sigmoid/rational", s_linear_tolerance }, { "mat_mat_mul_bias_tanh/rational", s_linear_tolerance },
+    { "mat_mat_mul_packed_bias_sigmoid/rational", s_linear_tolerance }, { "mat_mat_mul_packed_bias_tanh/rational", s_linear_tolerance }
+};
+
+static constexpr float s_leaky_alpha = 0.01f;
+
+/* largest |a - b| relative to the magnitude of b (absolute below 1) */
+static float max_error(const float* a, const float* b, size_t count)
+{
+    float maxError = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        float error = std::abs(a[i] - b[i]) / std::max(1.0f, std::abs(b[i]));
+        if (std::isnan(error))
+            return NAN;
+
+        maxError = std::max(maxError, error);
+    }
+
+    return maxError;
+}
+
+/* same as max_error over batch rows of n values, outStride apart */
+static float max_error(const float* a, const float* b, size_t n, size_t batch, size_t outStride)
+{
+    float maxError = 0.0f;
+    for (size_t s = 0; s < batch; s++)
+    {
+        float error = max_error(&a[s * outStride], &b[s * outStride], n);
+        if (std::isnan(error))
+            return NAN;
+
+        maxError = std::max(maxError, error);
+    }
+
+    return maxError;
+}
+
+/* runs every kernel of the active isa on one case and folds the errors into results */
+static void run_case(const test_case& c, std::default_random_engine& engine, kernel_result* results)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> preActivation(-12.0f, 12.0f);
+    std::uniform_int_distribution<uint32_t> saturate(0, 15);
+
+    const size_t m = c.m, n = c.n, batch = c.batch;
+
+    /* the gaps between strided rows are filled too, a kernel writing into them shows up as a mismatch */
+    std::vector<float> input(batch * c.inStride), weights(m * n), biases(n);
+    std::vector<float> output(batch * c.outStride, -7.0f), reference(batch * c.outStride, -7.0f);
+
+    for (auto& f : input) f = distribution(engine);
+    for (auto& f : weights) f = distribution(engine);
+    for (auto& f : biases) f = distribution(engine);
+
+    /*------------------------------fp32------------------------------------------*/
+    const float sum = simd::accumulate(input.data(), m), referenceSum = simd::scalar::accumulate(input.data(), m);
+    results[k_accumulate].update(max_error(&sum, &referenceSum, 1), c);
+
+    simd::vec_mat_mul(input.data(), weights.data(), output.data(), m, n);
+    simd::scalar::vec_mat_mul(input.data(), weights.data(), reference.data(), m, n);
+    results[k_vec_mat_mul].update(max_error(output.data(), reference.data(), n), c);
+
+    simd::mat_mat_mul(input.data(), weights.data(), output.data(), m, n, batch, c.inStride, c.outStride);
+    simd::scalar::mat_mat_mul(input.data(), weights.data(), reference.data(), m, n, batch, c.inStride, c.outStride);
+    results[k_mat_mat_mul].update(max_error(output.data(), reference.data(), batch * c.outStride), c);
+
+    /* the fills have to be exact, and must not write past count */
+    {
+        std::vector<float> fill(m + 1, 1.0f), expected(m + 1, 0.5f);
+        expected[m] = 1.0f;
+
+        simd::set_range_value(fill.data(), m, 0.5f);
+        results[k_set_range_value].update(max_error(fill.data(), expected.data(), m + 1), c);
+
+        std::fill(expected.begin(), expected.end() - 1, 0.0f);
+
+        simd::set_to_zero(fill.data(), m);
+        results[k_set_to_zero].update(max_error(fill.data(), expected.data(), m + 1), c);
+
+        /* fma or not, one rounding apart */
+        fill.assign(input.begin(), input.begin() + m);
+        fill.push_back(-7.0f);
+        expected.assign(fill.begin(), fill.end());
+
+        simd::scale_offset(fill.data(), m, 1.7f, -0.3f);
+        simd::scalar::scale_offset(expected.data(), m, 1.7f, -0.3f);
+        results[k_scale_offset].update(max_error(fill.data(), expected.data(), m + 1), c);
+    }
+
+    /*------------------------------int8------------------------------------------*/
+    {
+        const size_t paddedM = simd::int8_padded_row(m);
+
+        std::vector<int8_t> quantizedWeights;
+        std::vector<float> scales;
+        std::vector<int32_t> rowSums;
+        quantize_rows(weights, m, n, quantizedWeights, scales, rowSums);
+
+        std::vector<uint8_t> quantized(batch * paddedM, 0xFF), referenceQuantized(batch * paddedM, 0xFF);
+        std::vector<simd::int8_input> params(batch), referenceParams(batch);
+
+        for (size_t s = 0; s < batch; s++)
+        {
+            params[s] = simd::quantize_input(&input[s * c.inStride], &quantized[s * paddedM], m, paddedM);
+            referenceParams[s] = simd::scalar::quantize_input(&input[s * c.inStride], &referenceQuantized[s * paddedM], m, paddedM);
+
+            if (params[s].zero_point != referenceParams[s].zero_point || params[s].scale != referenceParams[s].scale)
+                results[k_quantize_input].update(1.0f, c);
+        }
+
+        if (std::memcmp(quantized.data(), referenceQuantized.data(), quantized.size()) != 0)
+            results[k_quantize_input].update(1.0f, c);
+
+        simd::vec_mat_mul_i8(quantized.data(), params[0], quantizedWeights.data(), scales.data(), rowSums.data(), output.data(), paddedM, n);
+        simd::scalar::vec_mat_mul_i8(referenceQuantized.data(), referenceParams[0], quantizedWeights.data(), scales.data(), rowSums.data(), reference.data(), paddedM, n);
+        results[k_vec_mat_mul_i8].update(max_error(output.data(), reference.data(), n), c);
+
+        simd::mat_mat_mul_i8(quantized.data(), params.data(), quantizedWeights.data(), scales.data(), rowSums.data(), output.data(), paddedM, n, batch, c.outStride);
+        simd::scalar::mat_mat_mul_i8(referenceQuantized.data(), referenceParams.data(), quantizedWeights.data(), scales.data(), rowSums.data(), reference.data(),
+            paddedM, n, batch, c.outStride);
+        results[k_mat_mat_mul_i8].update(max_error(output.data(), reference.data(), n, batch, c.outStride), c);
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    /* a range that reaches both saturated ends, plus the odd lane far past exp's clamp */
+    std::vector<float> values(n);
+    for (auto& f : values)
+    {
+        const uint32_t roll = saturate(engine);
+        f = roll == 0 ? 100.0f : roll == 1 ? -100.0f : preActivation(engine);
+    }
+
+    auto check_activation = [&](kernel_id id, auto&& kernel, auto&& referenceKernel)
+    {
+        output.assign(values.begin(), values.end());
+        reference.assign(values.begin(), values.end());
+
+        kernel(output.data(), biases.data(), n);
+        referenceKernel(reference.data(), biases.data(), n);
+
+        results[id].update(max_error(output.data(), reference.data(), n), c);
+    };
+
+    /* sigmoid and tanh through lambdas, the accuracy argument is defaulted */
+    check_activation(k_add_bias_sigmoid, [](float* out, const float* bias, size_t count) { simd::add_bias_sigmoid(out, bias, count); }, simd::scalar::add_bias_sigmoid);
+    check_activation(k_add_bias_tanh, [](float* out, const float* bias, size_t count) { simd::add_bias_tanh(out, bias, count); }, simd::scalar::add_bias_tanh);
+    check_activation(k_add_bias_relu, simd::add_bias_relu, simd::scalar::add_bias_relu);
+    check_activation(k_add_bias_leaky_relu,
+        [](float* out, const float* bias, size_t count) { simd::add_bias_leaky_relu(out, bias, count, s_leaky_alpha); },
+        [](float* out, const float* bias, size_t count) { simd::scalar::add_bias_leaky_relu(out, bias, count, s_leaky_alpha); });
+    check_activation(k_add_bias_linear, simd::add_bias_linear, simd::scalar::add_bias_op<simd::scalar::linear_op>);
+
+    /*------------------------------fused layer-----------------------------------*/
+    /* against the scalar gemm followed by the scalar activation, the definition the fused kernels have to match */
+    auto check_fused = [&](kernel_id id, auto&& kernel, auto&& referenceKernel)
+    {
+        output.assign(batch * c.outStride, -7.0f);
+        reference.assign(batch * c.outStride, -7.0f);
+
+        kernel(input.data(), weights.data(), biases.data(), output.data(), m, n, batch, c.inStride, c.outStride);
+        simd::scalar::mat_mat_mul(input.data(), weights.data(), reference.data(), m, n, batch, c.inStride, c.outStride);
+
+        for (size_t s = 0; s < batch; s++)
+            referenceKernel(&reference[s * c.outStride], biases.data(), n);
+
+        results[id].update(max_error(output.data(), reference.data(), batch * c.outStride), c);
+    };
+
+    check_fused(k_fused_sigmoid,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_bias_sigmoid(in, w, bias, out, rows, columns, count, inStride, outStride);
+        }, simd::scalar::add_bias_sigmoid);
+
+    check_fused(k_fused_tanh,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_bias_tanh(in, w, bias, out, rows, columns, count, inStride, outStride);
+        }, simd::scalar::add_bias_tanh);
+
+    check_fused(k_fused_relu, simd::mat_mat_mul_bias_relu, simd::scalar::add_bias_relu);
+    check_fused(k_fused_leaky_relu,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_bias_leaky_relu(in, w, bias, out, rows, columns, count, inStride, outStride, s_leaky_alpha);
+        },
+        [](float* out, const float* bias, size_t count) { simd::scalar::add_bias_leaky_relu(out, bias, count, s_leaky_alpha); });
+    check_fused(k_fused_linear, simd::mat_mat_mul_bias_linear, simd::scalar::add_bias_op<simd::scalar::linear_op>);
+
+    /*------------------------------packed weights--------------------------------*/
+    /* the same layers through pack_weights, against the unpacked scalar definitions */
+    std::vector<float> packed(simd::packed_size(m, n), -7.0f);
+    simd::pack_weights(weights.data(), packed.data(), m, n, m);
+
+    output.assign(batch * c.outStride, -7.0f);
+    reference.assign(batch * c.outStride, -7.0f);
+
+    simd::mat_mat_mul_packed(input.data(), packed.data(), output.data(), m, n, batch, c.inStride, c.outStride);
+    simd::scalar::mat_mat_mul(input.data(), weights.data(), reference.data(), m, n, batch, c.inStride, c.outStride);
+    results[k_mat_mat_mul_packed].update(max_error(output.data(), reference.data(), batch * c.outStride), c);
+
+    auto check_packed = [&](kernel_id id, auto&& kernel, auto&& referenceKernel)
+    {
+        check_fused(id, [&](const float* in, const float*, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            kernel(in, packed.data(), bias, out, rows, columns, count, inStride, outStride);
+        }, referenceKernel);
+    };
+
+    check_packed(k_packed_sigmoid,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_packed_bias_sigmoid(in, w, bias, out, rows, columns, count, inStride, outStride);
+        }, simd::scalar::add_bias_sigmoid);
+
+    check_packed(k_packed_tanh,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_packed_bias_tanh(in, w, bias, out, rows, columns, count, inStride, outStride);
+        }, simd::scalar::add_bias_tanh);
+
+    check_packed(k_packed_relu, simd::mat_mat_mul_packed_bias_relu, simd::scalar::add_bias_relu);
+    check_packed(k_packed_leaky_relu,
+        [](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+        {
+            simd::mat_mat_mul_packed_bias_leaky_relu(in, w, bias, out, rows, columns, count, inStride, outStride, s_leaky_alpha);
+        },
+        [](float* out, const float* bias, size_t count) { simd::scalar::add_bias_leaky_relu(out, bias, count, s_leaky_alpha); });
+    check_packed(k_packed_linear, simd::mat_mat_mul_packed_bias_linear, simd::scalar::add_bias_op<simd::scalar::linear_op>);
+
+    /*------------------------------approximate activations-----------------------*/
+    /* against the scalar version of the same approximation, how far each one is from the real function
+     * is what kernel_bench --compare measures
+     */
+    static const simd::kernel_table scalarKernels = simd::make_kernel_table(simd::isa::scalar);
+
+    for (uint32_t tier = 1; tier < uint32_t(simd::activation_accuracy::count); tier++)
+    {
+        const simd::activation_accuracy accuracy = simd::activation_accuracy(tier);
+        const uint32_t first = k_sigmoid_polynomial + (tier - 1) * s_accuracy_block;
+
+        check_activation(kernel_id(first + 0), [accuracy](float* out, const float* bias, size_t count) { simd::add_bias_sigmoid(out, bias, count, accuracy); },
+            scalarKernels.add_bias_sigmoid[tier]);
+
+        check_activation(kernel_id(first + 1), [accuracy](float* out, const float* bias, size_t count) { simd::add_bias_tanh(out, bias, count, accuracy); },
+            scalarKernels.add_bias_tanh[tier]);
+
+        check_fused(kernel_id(first + 2),
+            [accuracy](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+            {
+                simd::mat_mat_mul_bias_sigmoid(in, w, bias, out, rows, columns, count, inStride, outStride, accuracy);
+            }, scalarKernels.add_bias_sigmoid[tier]);
+
+        check_fused(kernel_id(first + 3),
+            [accuracy](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+            {
+                simd::mat_mat_mul_bias_tanh(in, w, bias, out, rows, columns, count, inStride, outStride, accuracy);
+            }, scalarKernels.add_bias_tanh[tier]);
+
+        check_packed(kernel_id(first + 4),
+            [accuracy](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+            {
+                simd::mat_mat_mul_packed_bias_sigmoid(in, w, bias, out, rows, columns, count, inStride, outStride, accuracy);
+            }, scalarKernels.add_bias_sigmoid[tier]);
+
+        check_packed(kernel_id(first + 5),
+            [accuracy](const float* in, const float* w, const float* bias, float* out, size_t rows, size_t columns, size_t count, size_t inStride, size_t outStride)
+            {
+                simd::mat_mat_mul_packed_bias_tanh(in, w, bias, out, rows, columns, count, inStride, outStride, accuracy);
+            }, scalarKernels.add_bias_tanh[tier]);
+    }
+
+    /*------------------------------backward--------------------------------------*/
+    /* the errors of the outputs (n per sample, outStride apart) go back through the same weights as the forward kernels,
+     * into rows shaped like the inputs (m per sample, inStride apart)
+     */
+    std::vector<float> deltas(batch * c.outStride);
+    for (auto& f : deltas) f = distribution(engine);
+
+    std::vector<float> back(batch * c.inStride, -7.0f), referenceBack(batch * c.inStride, -7.0f);
+
+    simd::mat_t_mat_mul(deltas.data(), weights.data(), back.data(), m, n, batch, c.outStride, c.inStride);
+    simd::scalar::mat_t_mat_mul(deltas.data(), weights.data(), referenceBack.data(), m, n, batch, c.outStride, c.inStride);
+    results[k_mat_t_mat_mul].update(max_error(back.data(), referenceBack.data(), batch * c.inStride), c);
+
+    /* the updates add onto weights that are already there */
+    std::vector<float> gradients(weights), referenceGradients(weights);
+
+    simd::rank1_update(deltas.data(), input.data(), gradients.data(), m, n, m);
+    simd::scalar::rank1_update(deltas.data(), input.data(), referenceGradients.data(), m, n, m);
+    results[k_rank1_update].update(max_error(gradients.data(), referenceGradients.data(), m * n), c);
+
+    simd::rank_k_update(deltas.data(), input.data(), gradients.data(), m, n, batch, c.outStride, c.inStride, m);
+    simd::scalar::rank_k_update(deltas.data(), input.data(), referenceGradients.data(), m, n, batch, c.outStride, c.inStride, m);
+    results[k_rank_k_update].update(max_error(gradients.data(), referenceGradients.data(), m * n), c);
+
+    std::vector<float> sums(biases), referenceSums(biases);
+    sums.push_back(-7.0f);
+    referenceSums.push_back(-7.0f);
+
+    simd::accumulate_rows(deltas.data(), sums.data(), n, batch, c.outStride);
+    simd::scalar::accumulate_rows(deltas.data(), referenceSums.data(), n, batch, c.outStride);
+    results[k_accumulate_rows].update(max_error(sums.data(), referenceSums.data(), n + 1), c);
+
+    /* outputs in (-1, 1) cover both sides of relu's kink, the element past n must stay untouched */
+    std::vector<float> layerDeltas(n + 1), layerOutputs(n);
+    for (auto& f : layerDeltas) f = distribution(engine);
+    for (auto& f : layerOutputs) f = distribution(engine);
+
+    auto check_derivative = [&](kernel_id id, auto&& kernel, auto&& referenceKernel)
+    {
+        output.assign(layerDeltas.begin(), layerDeltas.end());
+        reference.assign(layerDeltas.begin(), layerDeltas.end());
+
+        kernel(output.data(), layerOutputs.data(), n);
+        referenceKernel(reference.data(), layerOutputs.data(), n);
+
+        results[id].update(max_error(output.data(), reference.data(), n + 1), c);
+    };
+
+    check_derivative(k_mul_derivative_sigmoid, simd::mul_derivative_sigmoid, simd::scalar::mul_derivative_sigmoid);
+    check_derivative(k_mul_derivative_tanh, simd::mul_derivative_tanh, simd::scalar::mul_derivative_tanh);
+    check_derivative(k_mul_derivative_relu, simd::mul_derivative_relu, simd::scalar::mul_derivative_relu);
+    check_derivative(k_mul_derivative_leaky_relu,
+        [](float* delta, const float* outputs, size_t count) { simd::mul_derivative_leaky_relu(delta, outputs, count, s_leaky_alpha); },
+        [](float* delta, const float* outputs, size_t count) { simd::scalar::mul_derivative_leaky_relu(delta, outputs, count, s_leaky_alpha); });
+}
+
+int check_kernels(uint32_t seed, size_t caseCount)
+{
+    /* shapes that hit every tail path on purpose: fewer inputs than one register, one past a register,
+     * fewer columns than one register tile, an odd sample in the gemm and inputs wider than gemv_block_size
+     * the last two fill the packed kernels' 6 and 12 sample groups with a partial panel and leftover samples
+     */
+    std::vector<test_case> cases = {
+        { 1, 1, 1, 1, 1 }, { 3, 5, 2, 3, 5 }, { 8, 8, 1, 8, 8 }, { 9, 4, 3, 11, 6 }, { 15, 7, 2, 15, 7 },
+        { 16, 16, 1, 16, 16 }, { 17, 9, 3, 17, 9 }, { 33, 12, 5, 40, 13 }, { 64, 64, 4, 64, 64 },
+        { simd::gemv_block_size + 4, 9, 2, simd::gemv_block_size + 4, 9 },
+        { 8, 70, 13, 8, 71 }, { 5, 100, 27, 7, 100 }
+    };
+
+    std::default_random_engine engine(seed);
+    std::uniform_int_distribution<size_t> rows(1, 300), columns(1, 72), samples(1, 6), padding(0, 3);
+
+    for (size_t i = 0; i < caseCount; i++)
+    {
+        test_case c;
+        c.m = rows(engine);
+        c.n = columns(engine);
+        c.batch = samples(engine);
+        c.inStride = c.m + padding(engine);
+        c.outStride = c.n + padding(engine);
+
+        cases.push_back(c);
+    }
+
+    const simd::isa active = simd::active_isa();
+    int failures = 0;
+
+    std::printf("\n[check] every supported isa vs scalar, %zu cases (seed %u)\n", cases.size(), seed);
+
+    for (uint32_t level = 1; level < uint32_t(simd::isa::count); level++)
+    {
+        if (!simd::set_isa(simd::isa(level)))
+            continue;
+
+        kernel_result results[k_count];
+        std::copy(std::begin(s_kernels), std::end(s_kernels), results);
+
+        /* every isa sees the same inputs */
+        std::default_random_engine caseEngine(seed);
+
+        for (const test_case& c : cases)
+            run_case(c, caseEngine, results);
+
+        const char* name = simd::isa_name(simd::isa(level));
+
+        for (const kernel_result& result : results)
+        {
+            const bool pass = result.error <= result.tolerance;
+            failures += pass ? 0 : 1;
+
+            std::printf("%-8s %-44s %10.1e  %s", name, result.name, result.error, pass ? "ok" : "FAILED");
+
+            if (!pass)
+            {
+                const test_case& w = result.worst;
+                std::printf(" (m %zu, n %zu, batch %zu, strides %zu/%zu)", w.m, w.n, w.batch, w.inStride, w.outStride);
+            }
+
+            std::printf("\n");
+        }
+    }
+
+    simd::set_isa(active);
+
+    std::printf("%d failure%s\n", failures, failures == 1 ? "" : "s");
+
+    return failures;
+}
@@ -0,0 +1,494 @@
+#include "bench_common.hpp"
+
+#include <cstring>
+
+#ifdef SIMD_X86
+
+/* same target as simd_avx2.hpp, only called when the host supports it */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(APP_COMPILER_GNUC)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+/* the original vec_mat_mul, kept here as the baseline the current kernel is measured against */
+namespace baseline {
+
+#ifdef APP_COMPILER_GNUC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        using simd::avx2::getf;
+
+        /* originally a std::vector<__m256>, which can't be instantiated outside of the avx target */
+        __m256* tempResults = (__m256*)_mm_malloc(n * sizeof(__m256), 32);
+        for (size_t i = 0; i < n; i++)
+            tempResults[i] = _mm256_setzero_ps();
+
+        size_t nLeftover = n % 8;
+        size_t mLeftover = m % 8;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < (m - mLeftover); j+=8)
+                tempResults[i] = _mm256_fmadd_ps(_mm256_loadu_ps(&inVec[j]), _mm256_loadu_ps(&inMatrix[i * m + j]), tempResults[i]);
+
+            if(mLeftover)
+            {
+                size_t offset = m - mLeftover;
+                float vecTemp[8] = { 0.0f };
+                float matTemp[8] = { 0.0f };
+
+                for (size_t k = offset; k < m; k++)
+                {
+                    vecTemp[k - offset] = inVec[k];
+                    matTemp[k - offset] = inMatrix[i * m + k];
+                }
+
+                tempResults[i] = _mm256_fmadd_ps(_mm256_loadu_ps(vecTemp), _mm256_loadu_ps(matTemp), tempResults[i]);
+            }
+        }
+
+        for (size_t i = 0; i < (n - nLeftover); i += 8)
+        {
+            __m256 vec_0(_mm256_add_ps(
+                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 1]), _mm256_castps256_ps128(tempResults[i + 0])),
+                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 1], 1), _mm256_extractf128_ps(tempResults[i + 0], 1))));
+
+            __m256 vec_1(_mm256_add_ps(
+                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 3]), _mm256_castps256_ps128(tempResults[i + 2])),
+                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 3], 1), _mm256_extractf128_ps(tempResults[i + 2], 1))));
+
+            __m256 vec_2(_mm256_add_ps(
+                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 5]), _mm256_castps256_ps128(tempResults[i + 4])),
+                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 5], 1), _mm256_extractf128_ps(tempResults[i + 4], 1))));
+
+            __m256 vec_3(_mm256_add_ps(
+                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 7]), _mm256_castps256_ps128(tempResults[i + 6])),
+                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 7], 1), _mm256_extractf128_ps(tempResults[i + 6], 1))));
+
+            __m256 vec_4(_mm256_add_ps(
+                _mm256_setr_ps(getf(vec_0, 0), getf(vec_0, 1), getf(vec_0, 4), getf(vec_0, 5), getf(vec_1, 0), getf(vec_1, 1), getf(vec_1, 4), getf(vec_1, 5)),
+                _mm256_setr_ps(getf(vec_0, 2), getf(vec_0, 3), getf(vec_0, 6), getf(vec_0, 7), getf(vec_1, 2), getf(vec_1, 3), getf(vec_1, 6), getf(vec_1, 7))));
+
+            __m256 vec_5(_mm256_add_ps(
+                _mm256_setr_ps(getf(vec_2, 0), getf(vec_2, 1), getf(vec_2, 4), getf(vec_2, 5), getf(vec_3, 0), getf(vec_3, 1), getf(vec_3, 4), getf(vec_3, 5)),
+                _mm256_setr_ps(getf(vec_2, 2), getf(vec_2, 3), getf(vec_2, 6), getf(vec_2, 7), getf(vec_3, 2), getf(vec_3, 3), getf(vec_3, 6), getf(vec_3, 7))));
+
+            auto final_vector = _mm256_add_ps(
+                _mm256_setr_ps(getf(vec_4, 0), getf(vec_4, 2), getf(vec_4, 4), getf(vec_4, 6), getf(vec_5, 0), getf(vec_5, 2), getf(vec_5, 4), getf(vec_5, 6)),
+                _mm256_setr_ps(getf(vec_4, 1), getf(vec_4, 3), getf(vec_4, 5), getf(vec_4, 7), getf(vec_5, 1), getf(vec_5, 3), getf(vec_5, 5), getf(vec_5, 7)));
+
+            _mm256_storeu_ps(&outVec[i], final_vector);
+        }
+
+        for (size_t i = n - nLeftover; i < n; i++)
+            outVec[i] = simd::avx2::accumulate(tempResults[i]);
+
+        _mm_free(tempResults);
+    }
+
+#ifdef APP_COMPILER_GNUC
+#pragma GCC diagnostic pop
+#endif
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(APP_COMPILER_GNUC)
+#pragma GCC pop_options
+#endif
+
+#endif
+
+static void bench_gemv(std::default_random_engine& engine)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::printf("\n[gemv] simd::vec_mat_mul vs baseline\n");
+    std::printf("%-12s %14s %14s %10s %10s %8s\n", "shape", "current(ns)", "baseline(ns)", "GFLOP/s", "speedup", "max err");
+
+    for (auto [m, n] : s_layer_shapes)
+    {
+        std::vector<float> input(m), weights(m * n), output(n), reference(n);
+
+        for (auto& f : input) f = distribution(engine);
+        for (auto& f : weights) f = distribution(engine);
+
+        /* keep the compiler from discarding the results */
+        volatile float sink = 0.0f;
+
+        double current = time_kernel([&]
+        {
+            simd::vec_mat_mul(input.data(), weights.data(), output.data(), m, n);
+            sink = output[0];
+        });
+
+        double base = current;
+        reference = output;
+
+#ifdef SIMD_X86
+        if (simd::supported_isa() >= simd::isa::avx2)
+        {
+            base = time_kernel([&]
+            {
+                baseline::vec_mat_mul(input.data(), weights.data(), reference.data(), m, n);
+                sink = reference[0];
+            });
+        }
+#endif
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < n; i++)
+            maxError = std::max(maxError, std::abs(output[i] - reference[i]));
+
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+        double gflops = (2.0 * double(m) * double(n)) / current * 1e-9;
+        std::printf("%-12s %14.1f %14.1f %10.2f %9.2fx %8.1e\n", shape, current * 1e9, base * 1e9, gflops, base / current, maxError);
+
+        (void)sink;
+    }
+}
+
+static void bench_gemm(std::default_random_engine& engine, size_t batch)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::printf("\n[gemm] simd::mat_mat_mul vs %zu x simd::vec_mat_mul\n", batch);
+    std::printf("%-12s %14s %14s %10s %10s %8s\n", "shape", "gemm(us)", "gemv(us)", "GFLOP/s", "speedup", "max err");
+
+    for (auto [m, n] : s_layer_shapes)
+    {
+        std::vector<float> input(batch * m), weights(m * n), output(batch * n), reference(batch * n);
+
+        for (auto& f : input) f = distribution(engine);
+        for (auto& f : weights) f = distribution(engine);
+
+        volatile float sink = 0.0f;
+
+        double gemm = time_kernel([&]
+        {
+            simd::mat_mat_mul(input.data(), weights.data(), output.data(), m, n, batch, m, n);
+            sink = output[0];
+        });
+
+        double gemv = time_kernel([&]
+        {
+            for (size_t b = 0; b < batch; b++)
+                simd::vec_mat_mul(&input[b * m], weights.data(), &reference[b * n], m, n);
+
+            sink = reference[0];
+        });
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < batch * n; i++)
+            maxError = std::max(maxError, std::abs(output[i] - reference[i]));
+
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+        double gflops = (2.0 * double(batch) * double(m) * double(n)) / gemm * 1e-9;
+        std::printf("%-12s %14.2f %14.2f %10.2f %9.2fx %8.1e\n", shape, gemm * 1e6, gemv * 1e6, gflops, gemv / gemm, maxError);
+
+        (void)sink;
+    }
+}
+
+/* one pass per layer against the gemm followed by a second pass for the bias and activation */
+static void bench_fused(std::default_random_engine& engine, size_t batch)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::printf("\n[fused] simd::mat_mat_mul_bias_relu vs mat_mat_mul + add_bias_relu, batch %zu\n", batch);
+    std::printf("%-12s %14s %14s %10s %10s\n", "shape", "fused(us)", "split(us)", "speedup", "max err");
+
+    for (auto [m, n] : s_layer_shapes)
+    {
+        std::vector<float> input(batch * m), weights(m * n), biases(n), output(batch * n), reference(batch * n);
+
+        for (auto& f : input) f = distribution(engine);
+        for (auto& f : weights) f = distribution(engine);
+        for (auto& f : biases) f = distribution(engine);
+
+        volatile float sink = 0.0f;
+
+        double fused = time_kernel([&]
+        {
+            simd::mat_mat_mul_bias_relu(input.data(), weights.data(), biases.data(), output.data(), m, n, batch, m, n);
+            sink = output[0];
+        });
+
+        double split = time_kernel([&]
+        {
+            simd::mat_mat_mul(input.data(), weights.data(), reference.data(), m, n, batch, m, n);
+
+            for (size_t b = 0; b < batch; b++)
+                simd::add_bias_relu(&reference[b * n], biases.data(), n);
+
+            sink = reference[0];
+        });
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < batch * n; i++)
+            maxError = std::max(maxError, std::abs(output[i] - reference[i]));
+
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+        std::printf("%-12s %14.2f %14.2f %9.2fx %10.1e\n", shape, fused * 1e6, split * 1e6, split / fused, maxError);
+
+        (void)sink;
+    }
+}
+
+static void bench_gemv_i8(std::default_random_engine& engine)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::printf("\n[gemv int8] quantize_input + simd::vec_mat_mul_i8 vs simd::vec_mat_mul\n");
+    std::printf("%-12s %14s %14s %10s %10s %10s\n", "shape", "int8(ns)", "fp32(ns)", "speedup", "max err", "rel err");
+
+    for (auto [m, n] : s_layer_shapes)
+    {
+        const size_t paddedM = simd::int8_padded_row(m);
+
+        std::vector<float> input(m), weights(m * n), output(n), reference(n);
+        std::vector<uint8_t> quantizedInput(paddedM);
+        std::vector<int8_t> quantizedWeights;
+        std::vector<float> scales;
+        std::vector<int32_t> rowSums;
+
+        for (auto& f : input) f = distribution(engine);
+        for (auto& f : weights) f = distribution(engine);
+
+        quantize_rows(weights, m, n, quantizedWeights, scales, rowSums);
+
+        volatile float sink = 0.0f;
+
+        double int8 = time_kernel([&]
+        {
+            auto params = simd::quantize_input(input.data(), quantizedInput.data(), m, paddedM);
+            simd::vec_mat_mul_i8(quantizedInput.data(), params, quantizedWeights.data(), scales.data(), rowSums.data(), output.data(), paddedM, n);
+            sink = output[0];
+        });
+
+        double fp32 = time_kernel([&]
+        {
+            simd::vec_mat_mul(input.data(), weights.data(), reference.data(), m, n);
+            sink = reference[0];
+        });
+
+        float maxError = 0.0f, maxReference = 0.0f;
+        for (size_t i = 0; i < n; i++)
+        {
+            maxError = std::max(maxError, std::abs(output[i] - reference[i]));
+            maxReference = std::max(maxReference, std::abs(reference[i]));
+        }
+
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+        std::printf("%-12s %14.1f %14.1f %9.2fx %10.1e %9.2f%%\n", shape, int8 * 1e9, fp32 * 1e9, fp32 / int8, maxError, 100.0f * maxError / maxReference);
+
+        (void)sink;
+    }
+}
+
+/* the same kernels bound to every instruction set the host supports */
+static void bench_isa(std::default_random_engine& engine, size_t batch)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    const simd::isa active = simd::active_isa();
+
+    std::printf("\n[dispatch] supported: %s, active: %s (NNV_SIMD caps it)\n", simd::isa_name(simd::supported_isa()), simd::isa_name(active));
+    std::printf("%-12s %-8s %14s %14s %10s\n", "shape", "isa", "gemv(ns)", "gemm(us)", "max err");
+
+    for (auto [m, n] : s_layer_shapes)
+    {
+        std::vector<float> input(batch * m), weights(m * n), output(batch * n), reference(batch * n);
+
+        for (auto& f : input) f = distribution(engine);
+        for (auto& f : weights) f = distribution(engine);
+
+        simd::scalar::mat_mat_mul(input.data(), weights.data(), reference.data(), m, n, batch, m, n);
+
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+        for (uint32_t level = 0; level <= uint32_t(active); level++)
+        {
+            if (!simd::set_isa(simd::isa(level)))
+                continue;
+
+            volatile float sink = 0.0f;
+
+            double gemv = time_kernel([&]
+            {
+                simd::vec_mat_mul(input.data(), weights.data(), output.data(), m, n);
+                sink = output[0];
+            });
+
+            double gemm = time_kernel([&]
+            {
+                simd::mat_mat_mul(input.data(), weights.data(), output.data(), m, n, batch, m, n);
+                sink = output[0];
+            });
+
+            float maxError = 0.0f;
+            for (size_t i = 0; i < batch * n; i++)
+                maxError = std::max(maxError, std::abs(output[i] - reference[i]));
+
+            std::printf("%-12s %-8s %14.1f %14.2f %10.1e\n", shape, simd::isa_name(simd::isa(level)), gemv * 1e9, gemm * 1e6, maxError);
+
+            (void)sink;
+        }
+    }
+
+    simd::set_isa(active);
+}
+
+/* distance from the double precision result in units of the last place of that result rounded to fp32 */
+static double ulp_error(float value, double exact)
+{
+    const float rounded = std::abs(float(exact));
+    return std::abs(double(value) - exact) / double(std::nextafter(rounded, INFINITY) - rounded);
+}
+
+/* every activation_accuracy of sigmoid and tanh on every isa the host supports: speed against exact and error against double
+ * the ulp grow where the result gets small, the approximations bound the absolute error (sigmoid far below 0 in particular)
+ */
+static void bench_activation_accuracy()
+{
+    constexpr size_t count = 4096;
+    constexpr float low = -10.0f, high = 10.0f;
+
+    std::vector<float> sweep(count), output(count);
+    for (size_t i = 0; i < count; i++)
+        sweep[i] = low + (high - low) * float(i) / float(count - 1);
+
+    const simd::isa active = simd::active_isa();
+
+    std::printf("\n[activations] sigmoid and tanh per accuracy over [%.0f, %.0f], errors against double precision\n", low, high);
+    std::printf("%-8s %-8s %-12s %12s %10s %10s %10s\n", "isa", "function", "accuracy", "ns/value", "speedup", "max abs", "max ulp");
+
+    for (uint32_t level = 0; level <= uint32_t(active); level++)
+    {
+        if (!simd::set_isa(simd::isa(level)))
+            continue;
+
+        for (const bool tanh : { false, true })
+        {
+            double exactTime = 0.0;
+
+            for (uint32_t tier = 0; tier < uint32_t(simd::activation_accuracy::count); tier++)
+            {
+                const simd::activation_accuracy accuracy = simd::activation_accuracy(tier);
+
+                /* the sweep goes in as the biases, so output (sigmoid or tanh of the previous run) stays within [low - 1, high + 1] */
+                auto run = [&]
+                {
+                    if (tanh)
+                        simd::add_bias_tanh(output.data(), sweep.data(), count, accuracy);
+                    else
+                        simd::add_bias_sigmoid(output.data(), sweep.data(), count, accuracy);
+                };
+
+                std::fill(output.begin(), output.end(), 0.0f);
+                run();
+
+                double maxAbs = 0.0, maxUlp = 0.0;
+                for (size_t i = 0; i < count; i++)
+                {
+                    const double x = double(sweep[i]);
+                    const double exact = tanh ? std::tanh(x) : 1.0 / (1.0 + std::exp(-x));
+
+                    maxAbs = std::max(maxAbs, std::abs(double(output[i]) - exact));
+                    maxUlp = std::max(maxUlp, ulp_error(output[i], exact));
+                }
+
+                volatile float sink = 0.0f;
+                const double seconds = time_kernel([&] { run(); sink = output[0]; });
+                (void)sink;
+
+                if (accuracy == simd::activation_accuracy::exact)
+                    exactTime = seconds;
+
+                std::printf("%-8s %-8s %-12s %12.3f %9.2fx %10.1e %10.0f\n", simd::isa_name(simd::isa(level)), tanh ? "tanh" : "sigmoid",
+                    simd::activation_accuracy_name(accuracy), seconds / double(count) * 1e9, exactTime / seconds, maxAbs, maxUlp);
+            }
+        }
+    }
+
+    simd::set_isa(active);
+}
+
+static void print_usage()
+{
+    std::printf("kernel_bench [--check] [--bench[=filter]] [--compare] [--seed=n] [--cases=n]\n");
+    std::printf("  --check          every kernel of every supported isa against scalar, exit code is the number of failures\n");
+    std::printf("  --bench[=filter] micro benchmarks of the active isa (NNV_SIMD to pick it), optionally by name\n");
+    std::printf("  --compare        the comparisons against the baseline, gemv, int8, fused, per isa and per activation accuracy\n");
+    std::printf("  no arguments runs all three, the check first\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool check = false, bench = false, compare = false;
+    const char* filter = "";
+    uint32_t seed = 42;
+    size_t caseCount = 200;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--check") == 0)
+            check = true;
+        else if (std::strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (std::strncmp(argv[i], "--bench=", 8) == 0)
+            bench = true, filter = argv[i] + 8;
+        else if (std::strcmp(argv[i], "--compare") == 0)
+            compare = true;
+        else if (std::strncmp(argv[i], "--seed=", 7) == 0)
+            seed = (uint32_t)std::strtoul(argv[i] + 7, nullptr, 10);
+        else if (std::strncmp(argv[i], "--cases=", 8) == 0)
+            caseCount = (size_t)std::strtoull(argv[i] + 8, nullptr, 10);
+        else
+        {
+            print_usage();
+            return argv[i][0] == '-' && argv[i][1] == 'h' ? 0 : 1;
+        }
+    }
+
+    if (!check && !bench && !compare)
+        check = bench = compare = true;
+
+    /* the check gates every kernel change, a failure still runs the benchmarks but is reported through the exit code */
+    int failures = check ? check_kernels(seed, caseCount) : 0;
+
+    if (bench)
+        run_micro_benchmarks(filter);
+
+    if (compare)
+    {
+        std::default_random_engine engine(seed);
+
+        bench_gemv(engine);
+        bench_gemv_i8(engine);
+
+        /* the whole soybean series, one window per sample */
+        bench_gemm(engine, 2048);
+        bench_fused(engine, 1);
+        bench_fused(engine, 2048);
+
+        bench_isa(engine, 256);
+        bench_activation_accuracy();
+    }
+
+    return failures;
+}
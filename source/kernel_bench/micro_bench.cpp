@@ -0,0 +1,186 @@
+#include "bench_common.hpp"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+/* one registered benchmark, flops and bytes are per call and only used for the rates (0 == not meaningful) */
+struct micro_benchmark
+{
+    std::string name;
+    double flops;
+    double bytes;
+    std::function<void()> run;
+};
+
+/* everything a layer shape needs, shared by every benchmark registered for it */
+struct layer_buffers
+{
+    size_t m, n, paddedM;
+
+    std::vector<float> input, weights, biases, output, packed;
+
+    /* the backward kernels write here, the forward buffers keep their values */
+    std::vector<float> inputDeltas, weightGradients;
+
+    std::vector<uint8_t> quantizedInput;
+    std::vector<int8_t> quantizedWeights;
+    std::vector<float> scales;
+    std::vector<int32_t> rowSums;
+};
+
+/* samples per gemm call, the order of a frame's worth of windows */
+static constexpr size_t s_batch = 256;
+
+static void register_layer(std::vector<micro_benchmark>& benchmarks, std::vector<std::unique_ptr<layer_buffers>>& storage, size_t m, size_t n,
+    std::default_random_engine& engine)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    auto& buffers = storage.emplace_back(std::make_unique<layer_buffers>());
+    layer_buffers* l = buffers.get();
+
+    l->m = m;
+    l->n = n;
+    l->paddedM = simd::int8_padded_row(m);
+
+    l->input.resize(s_batch * m);
+    l->weights.resize(m * n);
+    l->biases.resize(n);
+    l->output.resize(s_batch * n);
+    l->quantizedInput.resize(l->paddedM);
+    l->inputDeltas.resize(s_batch * m);
+    l->weightGradients.resize(m * n);
+
+    for (auto& f : l->input) f = distribution(engine);
+    for (auto& f : l->weights) f = distribution(engine);
+    for (auto& f : l->biases) f = distribution(engine);
+
+    quantize_rows(l->weights, m, n, l->quantizedWeights, l->scales, l->rowSums);
+
+    l->packed.resize(simd::packed_size(m, n));
+    simd::pack_weights(l->weights.data(), l->packed.data(), m, n, m);
+
+    char shape[32];
+    std::snprintf(shape, sizeof(shape), "%zux%zu", m, n);
+
+    char batched[48];
+    std::snprintf(batched, sizeof(batched), "%s/b%zu", shape, s_batch);
+
+    const double md = double(m), nd = double(n), bd = double(s_batch);
+    const double weightBytes = 4.0 * md * nd;
+
+    benchmarks.push_back({ std::string("vec_mat_mul/") + shape, 2.0 * md * nd, weightBytes + 4.0 * (md + nd), [l]
+    {
+        simd::vec_mat_mul(l->input.data(), l->weights.data(), l->output.data(), l->m, l->n);
+    }});
+
+    benchmarks.push_back({ std::string("mat_mat_mul/") + batched, 2.0 * md * nd * bd, weightBytes + 4.0 * bd * (md + nd), [l]
+    {
+        simd::mat_mat_mul(l->input.data(), l->weights.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n);
+    }});
+
+    /* the bias add and activation are counted as 2 flops per output, whatever the activation costs */
+    benchmarks.push_back({ std::string("mat_mat_mul_bias_relu/") + batched, 2.0 * bd * nd * (md + 1.0), weightBytes + 4.0 * (bd * (md + nd) + nd), [l]
+    {
+        simd::mat_mat_mul_bias_relu(l->input.data(), l->weights.data(), l->biases.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n);
+    }});
+
+    benchmarks.push_back({ std::string("mat_mat_mul_bias_sigmoid/") + batched, 2.0 * bd * nd * (md + 1.0), weightBytes + 4.0 * (bd * (md + nd) + nd), [l]
+    {
+        simd::mat_mat_mul_bias_sigmoid(l->input.data(), l->weights.data(), l->biases.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n);
+    }});
+
+    /* the packed panels are padded to 16 columns, only the real weights are counted */
+    benchmarks.push_back({ std::string("mat_mat_mul_packed/") + batched, 2.0 * md * nd * bd, weightBytes + 4.0 * bd * (md + nd), [l]
+    {
+        simd::mat_mat_mul_packed(l->input.data(), l->packed.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n);
+    }});
+
+    benchmarks.push_back({ std::string("mat_mat_mul_packed_bias_relu/") + batched, 2.0 * bd * nd * (md + 1.0), weightBytes + 4.0 * (bd * (md + nd) + nd), [l]
+    {
+        simd::mat_mat_mul_packed_bias_relu(l->input.data(), l->packed.data(), l->biases.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n);
+    }});
+
+    /* backpropagation over the same shape, the output rows stand in for the errors */
+    benchmarks.push_back({ std::string("mat_t_mat_mul/") + batched, 2.0 * md * nd * bd, weightBytes + 4.0 * bd * (md + nd), [l]
+    {
+        simd::mat_t_mat_mul(l->output.data(), l->weights.data(), l->inputDeltas.data(), l->m, l->n, s_batch, l->n, l->m);
+    }});
+
+    /* the gradient is read and written once per call */
+    benchmarks.push_back({ std::string("rank_k_update/") + batched, 2.0 * md * nd * bd, 2.0 * weightBytes + 4.0 * bd * (md + nd), [l]
+    {
+        simd::rank_k_update(l->output.data(), l->input.data(), l->weightGradients.data(), l->m, l->n, s_batch, l->n, l->m, l->m);
+    }});
+
+    /* quantizing the input is part of what an int8 layer costs */
+    benchmarks.push_back({ std::string("vec_mat_mul_i8/") + shape, 2.0 * md * nd, double(l->paddedM) * (nd + 1.0) + 4.0 * (md + 3.0 * nd), [l]
+    {
+        auto params = simd::quantize_input(l->input.data(), l->quantizedInput.data(), l->m, l->paddedM);
+        simd::vec_mat_mul_i8(l->quantizedInput.data(), params, l->quantizedWeights.data(), l->scales.data(), l->rowSums.data(), l->output.data(), l->paddedM, l->n);
+    }});
+
+    /* activations over one sample's outputs: read output and bias, write output */
+    const std::string columns = std::to_string(n);
+
+    benchmarks.push_back({ "add_bias_sigmoid/" + columns, 0.0, 12.0 * nd, [l] { simd::add_bias_sigmoid(l->output.data(), l->biases.data(), l->n); } });
+    benchmarks.push_back({ "add_bias_tanh/" + columns, 0.0, 12.0 * nd, [l] { simd::add_bias_tanh(l->output.data(), l->biases.data(), l->n); } });
+    benchmarks.push_back({ "add_bias_relu/" + columns, 0.0, 12.0 * nd, [l] { simd::add_bias_relu(l->output.data(), l->biases.data(), l->n); } });
+    benchmarks.push_back({ "add_bias_leaky_relu/" + columns, 0.0, 12.0 * nd, [l] { simd::add_bias_leaky_relu(l->output.data(), l->biases.data(), l->n, 0.01f); } });
+
+    /* the approximate sigmoid and tanh, kernel_bench --compare has their error next to the same kind of timings */
+    for (uint32_t tier = 1; tier < uint32_t(simd::activation_accuracy::count); tier++)
+    {
+        const simd::activation_accuracy accuracy = simd::activation_accuracy(tier);
+        const std::string name = simd::activation_accuracy_name(accuracy);
+
+        benchmarks.push_back({ "mat_mat_mul_bias_sigmoid/" + name + "/" + batched, 2.0 * bd * nd * (md + 1.0), weightBytes + 4.0 * (bd * (md + nd) + nd), [l, accuracy]
+        {
+            simd::mat_mat_mul_bias_sigmoid(l->input.data(), l->weights.data(), l->biases.data(), l->output.data(), l->m, l->n, s_batch, l->m, l->n, accuracy);
+        }});
+
+        benchmarks.push_back({ "add_bias_sigmoid/" + name + "/" + columns, 0.0, 12.0 * nd, [l, accuracy]
+        {
+            simd::add_bias_sigmoid(l->output.data(), l->biases.data(), l->n, accuracy);
+        }});
+
+        benchmarks.push_back({ "add_bias_tanh/" + name + "/" + columns, 0.0, 12.0 * nd, [l, accuracy]
+        {
+            simd::add_bias_tanh(l->output.data(), l->biases.data(), l->n, accuracy);
+        }});
+    }
+}
+
+void run_micro_benchmarks(const char* filter)
+{
+    std::default_random_engine engine(42);
+
+    std::vector<micro_benchmark> benchmarks;
+    std::vector<std::unique_ptr<layer_buffers>> storage;
+
+    for (auto [m, n] : s_layer_shapes)
+        register_layer(benchmarks, storage, m, n, engine);
+
+    std::printf("\n[bench] isa: %s (NNV_SIMD to pick another one)\n", simd::isa_name(simd::active_isa()));
+    std::printf("%-48s %14s %12s %12s\n", "benchmark", "time(ns)", "GFLOP/s", "GB/s");
+    std::printf("%s\n", std::string(89, '-').c_str());
+
+    for (const micro_benchmark& benchmark : benchmarks)
+    {
+        if (filter && *filter && benchmark.name.find(filter) == std::string::npos)
+            continue;
+
+        const double seconds = time_kernel(benchmark.run, 0.1);
+
+        char flops[16] = "-", bytes[16] = "-";
+        if (benchmark.flops > 0.0)
+            std::snprintf(flops, sizeof(flops), "%.2f", benchmark.flops / seconds * 1e-9);
+
+        if (benchmark.bytes > 0.0)
+            std::snprintf(bytes, sizeof(bytes), "%.2f", benchmark.bytes / seconds * 1e-9);
+
+        std::printf("%-48s %14.1f %12s %12s\n", benchmark.name.c_str(), seconds * 1e9, flops, bytes);
+    }
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "simd.hpp"
+#include "model_format.h"
+
+#include <iterator>
+
 template<typename T>
 struct activation
 {
@@ -15,25 +20,47 @@ struct activation
 		return ((T*)this)->derivative(inValue);
 	}
 
+	/* ioDelta *= derivative(inOutputs) over a layer using simd, from the outputs the forward pass cached */
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n)
+	{
+		((T*)this)->mul_derivative(ioDelta, inOutputs, n);
+	}
+
 	/* operates on an entire layer using simd */
 	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
 	{
 		((T*)this)->add_bias_activation(outVec, inBiases, n);
 	}
 
+	/* a whole layer for a batch of samples in one pass: outMat = activation(inMat * inMatrix + inBiases)
+	 * the bias and activation are applied in registers by the gemm kernel, see simd::mat_mat_mul for the layout
+	 */
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		((T*)this)->mat_mat_mul_bias_activation(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+	}
+
+	/* same as mat_mat_mul_bias_activation with weights from simd::pack_weights */
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		((T*)this)->mat_mat_mul_packed_bias_activation(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+	}
+
 	static activation<T> static_class()
 	{
 		return activation<T>();
 	}
 };
 
-#ifndef APP_ANDROID
-
-#include <immintrin.h>
-#include "vendor/avx_mathfun.h"
+/* add_bias_activation goes through simd's kernel table, which picks the best implementation for the host */
 
+/* sigmoid and tanh run their layers at the accuracy they were built with, see simd::activation_accuracy
+ * the single value operator() is always exact
+ */
 struct sigmoid : public activation<sigmoid>
 {
+	sigmoid(simd::activation_accuracy accuracy = simd::activation_accuracy::exact) : m_accuracy(accuracy) {}
+
 	float operator()(float input)
 	{
 		return 1.0f / (1.0f + (std::exp(-input)));
@@ -44,33 +71,35 @@ struct sigmoid : public activation<sigmoid>
 		return inValue * (1.0f - inValue);
 	}
 
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n)
 	{
-		size_t leftover = n % 8;
-
-		for (size_t i = 0; i < (n - leftover); i+=8)
-		{
-			__m256 temp = _mm256_add_ps(_mm256_loadu_ps(&outVec[i]), _mm256_loadu_ps(&inBiases[i]));
-			_mm256_mul_ps(temp, _mm256_set1_ps(-1.0f));
+		simd::mul_derivative_sigmoid(ioDelta, inOutputs, n);
+	}
 
-			temp = exp256_ps(temp);
-			temp = _mm256_add_ps(temp, _mm256_set1_ps(1.0f));
+	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	{
+		simd::add_bias_sigmoid(outVec, inBiases, n, m_accuracy);
+	}
 
-			_mm256_storeu_ps(&outVec[i], _mm256_div_ps(_mm256_set1_ps(1.0f), temp));
-		}
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_bias_sigmoid(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride, m_accuracy);
+	}
 
-		if (leftover)
-		{
-			size_t offset = n - leftover;
-			for(size_t i = offset; i < n; i++)
-				outVec[i] = 1.0f / (1.0f + (std::exp(-1.0f * (outVec[i] + inBiases[i]))));
-		}
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_packed_bias_sigmoid(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride, m_accuracy);
 	}
+
+private:
+	simd::activation_accuracy m_accuracy;
 };
 
 // tanh
 struct hyperbolic_tan : public activation<hyperbolic_tan>
 {
+	hyperbolic_tan(simd::activation_accuracy accuracy = simd::activation_accuracy::exact) : m_accuracy(accuracy) {}
+
 	float operator()(float input)
 	{
 		return std::tanh(input);
@@ -81,43 +110,28 @@ struct hyperbolic_tan : public activation<hyperbolic_tan>
 		return 1.0f - std::pow(inValue, 2);
 	}
 
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n)
 	{
-        size_t leftover = n % 8;
-
-		/* there is no simd instruction for tanh (only intel extensions)
-		 * so we'll use exp256 to get the value through the definition:
-		 * tanh(x) == (exp(2x) - 1) / (exp(2x) + 1) 
-		 */
-
-        for (size_t i = 0; i < (n - leftover); i+=8)
-        {
-			/* add bias */ 
-			__m256 output = _mm256_add_ps(_mm256_loadu_ps(&outVec[i]), _mm256_loadu_ps(&inBiases[i]));
-
-			/* multiply by 2 (we need 2x) */
-			output = _mm256_mul_ps(output, _mm256_set1_ps(2.0f));
-
-			/* raise e to 2x */
-			__m256 exp_ = exp256_ps(output);
-
-			/* (exp(2x) - 1) */
-			__m256 dividend = _mm256_sub_ps(exp_, _mm256_set1_ps(1.0f));
+		simd::mul_derivative_tanh(ioDelta, inOutputs, n);
+	}
 
-			/* (exp(2x) + 1) */
-			__m256 divisor = _mm256_add_ps(exp_, _mm256_set1_ps(1.0f));
+	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	{
+		simd::add_bias_tanh(outVec, inBiases, n, m_accuracy);
+	}
 
-			/* divide and store the result */ 
-            _mm256_storeu_ps(&outVec[i], _mm256_div_ps(dividend, divisor));
-        }
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_bias_tanh(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride, m_accuracy);
+	}
 
-        if (leftover)
-        {
-			size_t offset = n - leftover;
-			for(size_t i = offset; i < n; i++)
-				outVec[i] = std::tanh(outVec[i] + inBiases[i]);
-		}
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_packed_bias_tanh(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride, m_accuracy);
 	}
+
+private:
+	simd::activation_accuracy m_accuracy;
 };
 
 struct relu : public activation<relu>
@@ -132,23 +146,24 @@ struct relu : public activation<relu>
 		return inValue > 0.0f ? 1.0f : 0.0f;
 	}
 
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n)
+	{
+		simd::mul_derivative_relu(ioDelta, inOutputs, n);
+	}
+
 	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
 	{
-		const __m256 zero_vector(_mm256_setzero_ps());
-		size_t leftover = n % 8;
+		simd::add_bias_relu(outVec, inBiases, n);
+	}
 
-		for (size_t i = 0; i < (n - leftover); i+=8)
-		{
-			__m256 sum = _mm256_add_ps(_mm256_loadu_ps(&outVec[i]), _mm256_loadu_ps(&inBiases[i]));
-			_mm256_storeu_ps(&outVec[i], _mm256_max_ps(sum, zero_vector));
-		}
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_bias_relu(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+	}
 
-		if (leftover)
-		{
-			size_t offset = n - leftover;
-			for(size_t i = offset; i < n; i++)
-				outVec[i] = std::max(outVec[i] + inBiases[i], 0.0f);
-		}
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_packed_bias_relu(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
 	}
 };
 
@@ -166,128 +181,160 @@ struct leaky_relu : public activation<leaky_relu>
 		return inValue > 0.0f ? 1.0f : m_alpha;
 	}
 
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n)
 	{
-		/* there is no good way to perform leaky relu with simd instructions
-		 * so we'll just add the bias using instrinsics and the leaky relu activation will be serial
-		 */
-
-		const __m256 zero_vector(_mm256_setzero_ps());
-		size_t leftover = n % 8;
+		simd::mul_derivative_leaky_relu(ioDelta, inOutputs, n, m_alpha);
+	}
 
-		for (size_t i = 0; i < (n - leftover); i+=8)
-		{
-			__m256 sum = _mm256_add_ps(_mm256_loadu_ps(&outVec[i]), _mm256_loadu_ps(&inBiases[i]));
-			_mm256_storeu_ps(&outVec[i], sum);
-		}
+	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+	{
+		simd::add_bias_leaky_relu(outVec, inBiases, n, m_alpha);
+	}
 
-		if (leftover)
-		{
-			size_t offset = n - leftover;
-			for(size_t i = offset; i < n; i++)
-				outVec[i] = outVec[i] + inBiases[i];
-		}
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_bias_leaky_relu(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride, m_alpha);
+	}
 
-		/* perform leaky relu */
-		for (size_t i = 0; i < n; i++)
-		{
-			float output = outVec[i];
-			outVec[i] = output > 0.0f ? output : output * m_alpha;
-		}
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+	{
+		simd::mat_mat_mul_packed_bias_leaky_relu(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride, m_alpha);
 	}
 
 private:
 	float m_alpha;
 };
 
-#else
-
-//TODO: implement NEON intrinsics. for now it will just be serial
-
-struct sigmoid : public activation<sigmoid>
+/* bias only, for regression outputs */
+struct linear : public activation<linear>
 {
 	float operator()(float input)
 	{
-		return 1.0f / (1.0f + (std::exp(-input)));
+		return input;
 	}
 
-	float derivative(float inValue)
+	float derivative(float)
 	{
-		return inValue * (1.0f - inValue);
+		return 1.0f;
 	}
 
+	/* the derivative is 1, nothing to do */
+	void mul_derivative(float*, const float*, size_t) {}
+
 	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
 	{
-		for(size_t i = 0; i < n; i++)
-			outVec[i] = 1.0f / (1.0f + (std::exp(-1.0f * (outVec[i] + inBiases[i]))));
+		simd::add_bias_linear(outVec, inBiases, n);
 	}
-};
 
-// tanh
-struct hyperbolic_tan : public activation<hyperbolic_tan>
-{
-	float operator()(float input)
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
 	{
-		return std::tanh(input);
+		simd::mat_mat_mul_bias_linear(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
 	}
 
-	float derivative(float inValue)
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
 	{
-		return 1.0f - std::pow(inValue, 2);
-	}
-
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
-	{
-		for(size_t i = 0; i < n; i++)
-			outVec[i] = std::tanh(outVec[i] + inBiases[i]);
+		simd::mat_mat_mul_packed_bias_linear(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
 	}
 };
 
-struct relu : public activation<relu>
+/*------------------------------per layer activation------------------------------*/
+/* the activation of one layer picked at runtime (from the model file, see model_format.h)
+ * every call goes through activation_kernels, a table built at compile time from the activation<T> kernels above:
+ * one indirect call per layer, the elements run inside the same simd kernels a hard-coded activation would use
+ */
+struct layer_activation
 {
-	float operator()(float input)
-	{
-		return std::max(0.0f, input);
-	}
+	model_activation type = model_activation::relu;
+	float alpha = 0.01f;
+	simd::activation_accuracy accuracy = simd::activation_accuracy::exact;
 
-	float derivative(float inValue)
-	{
-		return inValue > 0.0f ? 1.0f : 0.0f;
-	}
+	float operator()(float input) const;
+	float derivative(float inValue) const;
+	void mul_derivative(float* ioDelta, const float* inOutputs, size_t n) const;
 
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
-	{
-		for(size_t i = 0; i < n; i++)
-			outVec[i] = std::max(outVec[i] + inBiases[i], 0.0f);
-	}
+	void add_bias_activation(float* outVec, const float* inBiases, size_t n) const;
 
+	void mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch,
+		size_t inStride, size_t outStride) const;
+
+	void mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch,
+		size_t inStride, size_t outStride) const;
 };
 
-struct leaky_relu : public activation<leaky_relu>
-{
-	leaky_relu(float alpha = 0.01f) : m_alpha(alpha) {}
+/* an activation<T> carrying a layer's parameters */
+template<typename T>
+inline T make_activation(const layer_activation&) { return T(); }
 
-	float operator()(float input)
-	{
-		return input > 0.0f ? input : input * m_alpha;
-	}
+template<>
+inline leaky_relu make_activation<leaky_relu>(const layer_activation& layer) { return leaky_relu(layer.alpha); }
 
-	float derivative(float inValue)
-	{
-		return inValue > 0.0f ? 1.0f : m_alpha;
-	}
+template<>
+inline sigmoid make_activation<sigmoid>(const layer_activation& layer) { return sigmoid(layer.accuracy); }
 
-	void add_bias_activation(float* outVec, const float* inBiases, size_t n)
+template<>
+inline hyperbolic_tan make_activation<hyperbolic_tan>(const layer_activation& layer) { return hyperbolic_tan(layer.accuracy); }
+
+struct activation_kernels
+{
+	float (*value)(const layer_activation&, float);
+	float (*derivative)(const layer_activation&, float);
+	void (*mul_derivative)(const layer_activation&, float*, const float*, size_t);
+	void (*add_bias_activation)(const layer_activation&, float*, const float*, size_t);
+	void (*mat_mat_mul_bias_activation)(const layer_activation&, const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+	void (*mat_mat_mul_packed_bias_activation)(const layer_activation&, const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+
+	/* every entry forwards to the same member of a T built by make_activation */
+	template<typename T>
+	static constexpr activation_kernels of()
 	{
-		for (size_t i = 0; i < n; i++)
-		{
-			float output = outVec[i] + inBiases[i];
-			outVec[i] = output > 0.0f ? output : output * m_alpha;
-		}
+		return {
+			[](const layer_activation& layer, float input) { return make_activation<T>(layer)(input); },
+			[](const layer_activation& layer, float inValue) { return make_activation<T>(layer).derivative(inValue); },
+			[](const layer_activation& layer, float* ioDelta, const float* inOutputs, size_t n) { make_activation<T>(layer).mul_derivative(ioDelta, inOutputs, n); },
+			[](const layer_activation& layer, float* outVec, const float* inBiases, size_t n) { make_activation<T>(layer).add_bias_activation(outVec, inBiases, n); },
+			[](const layer_activation& layer, const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch,
+				size_t inStride, size_t outStride)
+			{
+				make_activation<T>(layer).mat_mat_mul_bias_activation(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+			},
+			[](const layer_activation& layer, const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch,
+				size_t inStride, size_t outStride)
+			{
+				make_activation<T>(layer).mat_mat_mul_packed_bias_activation(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+			}
+		};
 	}
+};
 
-private:
-	float m_alpha;
+/* indexed by model_activation, in the enum's order */
+inline constexpr activation_kernels s_activation_kernels[] = {
+	activation_kernels::of<relu>(), activation_kernels::of<leaky_relu>(), activation_kernels::of<sigmoid>(),
+	activation_kernels::of<hyperbolic_tan>(), activation_kernels::of<linear>()
 };
 
-#endif
+static_assert(std::size(s_activation_kernels) == size_t(model_activation::count), "one activation_kernels per model_activation");
+
+inline float layer_activation::operator()(float input) const { return s_activation_kernels[uint32_t(type)].value(*this, input); }
+inline float layer_activation::derivative(float inValue) const { return s_activation_kernels[uint32_t(type)].derivative(*this, inValue); }
+
+inline void layer_activation::mul_derivative(float* ioDelta, const float* inOutputs, size_t n) const
+{
+	s_activation_kernels[uint32_t(type)].mul_derivative(*this, ioDelta, inOutputs, n);
+}
+
+inline void layer_activation::add_bias_activation(float* outVec, const float* inBiases, size_t n) const
+{
+	s_activation_kernels[uint32_t(type)].add_bias_activation(*this, outVec, inBiases, n);
+}
+
+inline void layer_activation::mat_mat_mul_bias_activation(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n,
+	size_t batch, size_t inStride, size_t outStride) const
+{
+	s_activation_kernels[uint32_t(type)].mat_mat_mul_bias_activation(*this, inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+}
+
+inline void layer_activation::mat_mat_mul_packed_bias_activation(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n,
+	size_t batch, size_t inStride, size_t outStride) const
+{
+	s_activation_kernels[uint32_t(type)].mat_mat_mul_packed_bias_activation(*this, inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+}
@@ -0,0 +1,44 @@
+#include "activation_timeline.h"
+#include "model.h"
+
+void activation_timeline::build(model& inModel, const float* series, uint32_t windowCount)
+{
+    clear();
+
+    if(inModel.layout.empty() || !windowCount)
+        return;
+
+    const uint32_t layerCount = (uint32_t)inModel.layout.size();
+
+    m_window_count = windowCount;
+    m_neuron_count = inModel.input_count() + inModel.neuron_count();
+    m_values.resize(size_t(m_neuron_count) * windowCount);
+
+    const size_t stride = inModel.arena_stride();
+    aligned_buffer arena(inModel.batch_arena_size(std::min(windowCount, s_chunk_size)));
+
+    for(uint32_t first = 0; first < windowCount; first += s_chunk_size)
+    {
+        const uint32_t count = std::min(s_chunk_size, windowCount - first);
+        inModel.infer_batch_parallel(&series[first], count, nullptr, arena.data(), 1);
+
+        /* layer layerCount is the output, every layer's neurons sit at its arena offset within a window */
+        for(uint32_t layer = 0; layer <= layerCount; layer++)
+        {
+            const uint32_t neuronCount = layer < layerCount ? inModel.layout[layer].first : inModel.output_count();
+            const uint32_t firstNeuron = inModel.get_layer_offset(layer);
+            const uint32_t arenaOffset = inModel.get_arena_offset(layer);
+
+            for(uint32_t i = 0; i < neuronCount; i++)
+            {
+                uint8_t* values = &m_values[size_t(firstNeuron + i) * windowCount + first];
+
+                for(uint32_t t = 0; t < count; t++)
+                {
+                    const float value = std::clamp(arena[t * stride + arenaOffset + i], 0.0f, 1.0f);
+                    values[t] = uint8_t(std::lround(value * 255.0f));
+                }
+            }
+        }
+    }
+}
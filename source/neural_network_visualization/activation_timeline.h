@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class model;
+
+/* every neuron's activation at every window of a series, computed once up front so playback needs no inference at all
+ * structure of arrays: one neuron's values over the whole series are contiguous, clamped to [0, 1] (all the scene
+ * ever displays) and stored as uint8, 1 / 255 apart
+ * neurons are numbered as in model::get_layer_offset with the inputs first, so input i is neuron i
+ */
+class activation_timeline
+{
+public:
+	/* window t is series[t, t + input_count), windowCount of them, through the model's current precision
+	 * runs infer_batch_parallel over chunks of windows, the arena never grows past one chunk
+	 */
+	void build(model& inModel, const float* series, uint32_t windowCount);
+	void clear() { m_values.clear(); m_window_count = m_neuron_count = 0; }
+
+	bool empty() const { return m_values.empty(); }
+	uint32_t window_count() const { return m_window_count; }
+	uint32_t neuron_count() const { return m_neuron_count; }
+	size_t bytes() const { return m_values.size(); }
+
+	float get(uint32_t neuron, uint32_t window) const { return float(m_values[size_t(neuron) * m_window_count + window]) * (1.0f / 255.0f); }
+
+	/* window_count() values */
+	const uint8_t* neuron_values(uint32_t neuron) const { return &m_values[size_t(neuron) * m_window_count]; }
+
+private:
+	/* windows per infer_batch_parallel call */
+	static constexpr uint32_t s_chunk_size = 512;
+
+	std::vector<uint8_t> m_values;
+	uint32_t m_window_count = 0, m_neuron_count = 0;
+};
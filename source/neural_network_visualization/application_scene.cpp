@@ -11,6 +11,14 @@
 #include <limits>
 
 
+static constexpr size_t s_inference_cache_budget = 1024ULL * 1024ULL;
+
+/* neurons are drawn from 8 bit values (see activation_timeline), far coarser than the rational approximations */
+static constexpr simd::activation_accuracy s_activation_accuracy = simd::activation_accuracy::rational;
+
+/* minibatches per frame while training, the model gets their result in one go (see update_training) */
+static constexpr uint32_t s_training_steps_per_frame = 64;
+
 static std::random_device s_randomDevice;
 static std::default_random_engine s_randomEngine(s_randomDevice());
 
@@ -19,6 +27,13 @@ void application_scene::on_init()
     has_physics = false;
     set_const_base_unit(32.0f);
 
+    /* the model file loads on a worker while the scene objects are created and the series is parsed */
+    #ifdef APP_ANDROID
+    auto modelFile = load_async<gs::gensou_file>("resources/model.gsasset", gs::load_priority::high);
+    #else
+    auto modelFile = load_async<gs::gensou_file>("resources/model_1.gsasset", gs::load_priority::high);
+    #endif
+
     /* scene camera */
     {
         auto [obj, instance] = gs::game_statics::create_game_object<scene_camera>("application camera", {});
@@ -28,22 +43,33 @@ void application_scene::on_init()
     /* Widgets */
     gs::game_statics::create_game_object<application_widgets>("application widgets", {});
 
+    m_soybean_data = load_csv_series("resources/soybean.csv.gsasset", { 0, true, 2057 });
+
     /* Model */
     {
         auto [obj, instance] = gs::game_statics::create_game_object<model>("ann model", {});
         m_model = instance;
-        
-        #ifdef APP_ANDROID
-        m_model->load("resources/model.gsasset");
-        #else
-        m_model->load("resources/model_1.gsasset");
-        #endif
+        m_model->load(gs::asset_manager::get(modelFile), s_activation_accuracy);
     }
 
     m_animation.layer_count = m_model->layout.size();
     generate_ann_model();
 
-    m_soybean_data = load_soybean_series("resources/soybean.csv.gsasset", true, 2057);
+    /* the scene cycles through the same windows forever, every one of them fits (a few hundred floats each) */
+    m_model->set_cache_budget(s_inference_cache_budget);
+
+    if(m_precompute_timeline)
+        build_timelines();
+
+    /* how much the int8 path costs us in accuracy over every window we are going to show */
+    {
+        auto report = m_model->measure_quantization_error(m_soybean_data.data(), m_last_data_point, 1);
+
+        LOG(info, "int8 vs fp32 over %zu samples: max abs error %f, mean abs error %f, max error over output range %.3f%%",
+            report.samples, report.max_abs_error, report.mean_abs_error, report.max_relative_error * 100.0f);
+
+        LOG(info, "weights: fp32 %zu bytes, int8 %zu bytes", report.fp32_weight_bytes, report.int8_weight_bytes);
+    }
 
     /* set first set */
     forward_pass(0);
@@ -80,6 +106,9 @@ void application_scene::on_update(float dt)
         m_animation.waiting = false;
         m_animation.animating = true;
 
+        /* nothing reads the model until the next forward pass */
+        update_training();
+
         /* start computing next batch async */
         next_data_point();
     }
@@ -121,6 +150,11 @@ void application_scene::on_update(float dt)
 
 void application_scene::on_terminate()
 {
+    if(m_training_future.valid())
+        m_training_future.wait();
+
+    auto stats = m_model->cache_stats();
+    LOG(info, "inference cache: %zu hits, %zu misses, %zu/%zu slots (%zu bytes)", stats.hits, stats.misses, stats.entries, stats.capacity, stats.bytes);
 }
 
 void application_scene::generate_ann_model()
@@ -139,8 +173,8 @@ void application_scene::generate_ann_model()
     neuronPositions.reserve(totalCount);
 
     m_neurons[0].reserve(totalCount);
-    m_neuron_outputs[0].resize(totalCount, 0.0f);
-    m_neuron_outputs[1].resize(totalCount, 0.0f);
+    m_neuron_outputs[0].resize(m_model->batch_arena_size(1));
+    m_neuron_outputs[1].resize(m_model->batch_arena_size(1));
 
     /*------------------------------base-model-positions--------------------------------*/
 
@@ -258,7 +292,7 @@ void application_scene::generate_ann_model()
     /* base connections */
     m_line_renderer = create_object("line renderer");
     auto& lineRenderer = m_line_renderer.add_component<gs::line_renderer_component>();
-    lineRenderer.lines.reserve(m_model->weights.size());
+    lineRenderer.lines.reserve(m_model->weights_count());
 
     /* synapses */
     /* one game_object per layer */
@@ -329,56 +363,148 @@ void application_scene::generate_ann_model()
 
 void application_scene::forward_pass(uint32_t dataPoint)
 {
-    auto& neuronOutputs = m_neuron_outputs[m_local_frame];
-    simd::set_to_zero(neuronOutputs.data(), neuronOutputs.size());
-
-    /*--------------------input data------------------------------------------*/
-    uint32_t inputsize = m_model->input_count();
-    for(uint32_t i = 0; i < inputsize; i++)
-        neuronOutputs[i] = std::max(m_soybean_data[dataPoint + i], 0.11f);
+    m_frame_data_points[m_local_frame] = dataPoint;
 
-    /*--------------------offsets---------------------------------------------*/
-	size_t biasesOffset = 0, weightsOffset = 0, outputOffset = inputsize;
-    uint32_t row_i = 0;
+    /* a batch of one, every layer is padded in the arena so neurons are found through get_arena_offset
+     * after the first lap over the series every window comes out of the model's cache
+     */
+    if(m_timelines[uint32_t(m_model->get_precision())].empty())
+        m_model->infer_cached(&m_soybean_data[dataPoint], nullptr, m_neuron_outputs[m_local_frame].data());
 
-    const float* input = &m_soybean_data[dataPoint];
-    uint32_t layerIndex = 0;
     /*------------------------------------------------------------------------*/
-    
+    uint32_t layerIndex = 0;
+    const bool training = m_training.load(std::memory_order_relaxed);
+
     for (auto& [rowCount, columnCount] : m_model->layout)
     {
-        simd::vec_mat_mul(input, &m_model->weights[weightsOffset], &neuronOutputs[outputOffset], rowCount, columnCount);
-        m_model->activation_fn.add_bias_activation(&neuronOutputs[outputOffset], &m_model->biases[biasesOffset], columnCount);
+        auto& layerLines = m_weights[m_local_frame][layerIndex].get_component<gs::line_renderer_component>();
 
-        input = neuronOutputs.data() + outputOffset;
+        /* while training the synapses follow their weights as well, relative to the largest one of the layer */
+        const tensor_view layerWeights = m_model->layer_weights(layerIndex);
+        float weightScale = 0.0f;
 
-        outputOffset += columnCount;
-        biasesOffset += columnCount;
-        weightsOffset += columnCount * rowCount;
+        if(training)
+        {
+            float maxWeight = 0.0f;
+            for(uint32_t j = 0; j < columnCount; j++)
+            {
+                for(uint32_t i = 0; i < rowCount; i++)
+                    maxWeight = std::max(maxWeight, std::abs(layerWeights(j, i)));
+            }
 
-        auto& layerLines = m_weights[m_local_frame][layerIndex].get_component<gs::line_renderer_component>();
+            weightScale = maxWeight > 0.0f ? 1.0f / maxWeight : 0.0f;
+        }
 
         for(uint32_t i = 0; i < rowCount; i++)
         {
-            float output = neuronOutputs[row_i + i];
-            output = std::clamp(output, 0.0f, 1.0f);
+            float output = neuron_output(m_local_frame, layerIndex, i);
 
             /* update current layer's synapses */
             for(uint32_t j = 0; j < columnCount; j++)
             {
                 auto& segment = layerLines.lines[i * columnCount + j];
 
+                float intensity = output * 2.0f;
+                if(training)
+                    intensity *= std::abs(layerWeights(j, i)) * weightScale;
+
                 auto color = glm::vec3(m_base_synapses_color);
-                segment.p1.color = glm::vec4(color, output * 2.0f);
-                segment.p2.color = glm::vec4(color, output * 2.0f);
+                segment.p1.color = glm::vec4(color, intensity);
+                segment.p2.color = glm::vec4(color, intensity);
             }
         }
 
-        row_i += rowCount;
         layerIndex++;
     }
 }
 
+void application_scene::build_timelines()
+{
+    /* the last window has to end inside the series */
+    const size_t inputCount = m_model->input_count();
+    const uint32_t windowCount = m_soybean_data.size() >= inputCount ? std::min<uint32_t>(m_last_data_point, m_soybean_data.size() - inputCount + 1) : 0;
+
+    const model_precision precision = m_model->get_precision();
+
+    for(model_precision timelinePrecision : { model_precision::fp32, model_precision::int8 })
+    {
+        m_model->set_precision(timelinePrecision);
+        m_timelines[uint32_t(timelinePrecision)].build(*m_model, m_soybean_data.data(), windowCount);
+    }
+
+    m_model->set_precision(precision);
+
+    LOG(info, "activation timelines: %u windows x %u neurons, %zu bytes each", windowCount, m_timelines[0].neuron_count(), m_timelines[0].bytes());
+}
+
+float application_scene::neuron_output(uint32_t frame, uint32_t layer, uint32_t i) const
+{
+    const activation_timeline& timeline = m_timelines[uint32_t(m_model->get_precision())];
+
+    float output = timeline.empty() ?
+        m_neuron_outputs[frame][m_model->get_arena_offset(layer) + i] : timeline.get(m_model->get_layer_offset(layer) + i, m_frame_data_points[frame]);
+
+    /* inputs are only lit up for display, a zero would be invisible */
+    if(layer == 0)
+        output = std::max(output, 0.11f);
+
+    return std::clamp(output, 0.0f, 1.0f);
+}
+
+void application_scene::set_int8_inference(bool b)
+{
+    m_model->set_precision(b ? model_precision::int8 : model_precision::fp32);
+}
+
+void application_scene::set_training(bool b)
+{
+    if(b && !m_trainer.attached() && !m_trainer.attach(*m_model, m_soybean_data.data(), m_soybean_data.size()))
+        return;
+
+    /* the steps in flight still finish and get published, see update_training */
+    m_training.store(b, std::memory_order_relaxed);
+}
+
+void application_scene::update_training()
+{
+    if(!m_trainer.attached())
+        return;
+
+    /* still busy with the last steps, the model keeps its weights for another frame */
+    if(m_training_future.valid() && !gs::is_future_ready(m_training_future))
+        return;
+
+    if(m_training_future.valid())
+    {
+        m_training_future.get();
+        m_trainer.publish(*m_model);
+
+        const training_stats& stats = m_trainer.stats();
+        if(stats.epochs != m_published_epoch)
+        {
+            m_published_epoch = stats.epochs;
+            LOG(info, "training: epoch %u (%llu steps), loss %f", stats.epochs, (unsigned long long)stats.steps, stats.epoch_loss);
+        }
+    }
+
+    if(!m_training.load(std::memory_order_relaxed))
+        return;
+
+    /* the timelines hold the loaded weights, from now on every frame runs the model (and its cache) again
+     * the frame on screen was read from them and its arena never filled, it gets the same outputs from the (still untrained) model
+     */
+    if(!m_timelines[uint32_t(m_model->get_precision())].empty())
+        m_model->infer_cached(&m_soybean_data[m_frame_data_points[m_local_frame]], nullptr, m_neuron_outputs[m_local_frame].data());
+
+    for(auto& timeline : m_timelines)
+        timeline.clear();
+
+    m_training_future = gs::system::run_async([this]()
+    {
+        m_trainer.run(s_training_steps_per_frame);
+    });
+}
+
 void application_scene::next_data_point()
 {
     m_current_data_point = (m_current_data_point + 8) % m_last_data_point;
@@ -429,10 +555,10 @@ void application_scene::turn_on_neurons(uint32_t layer)
          
     uint32_t offset = m_model->get_layer_offset(layer);
 
-    for(uint32_t i = offset; i < offset + count; i++)
+    for(uint32_t i = 0; i < count; i++)
     {
-        auto& cube = m_neurons[m_local_frame][i].get_component<gs::cube_component>();
-        float output = std::clamp(m_neuron_outputs[m_local_frame][i], 0.0f, 1.0f);
+        auto& cube = m_neurons[m_local_frame][offset + i].get_component<gs::cube_component>();
+        float output = neuron_output(m_local_frame, layer, i);
         cube.color = { output + 0.2f, output + 0.2f, output + 0.2f, output + 0.1 };
     }
 }
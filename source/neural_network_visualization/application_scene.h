@@ -1,6 +1,10 @@
 #pragma once
 
+#include "activation_timeline.h"
 #include "scene_camera.h"
+#include "tensor.h"
+#include "trainer.h"
+#include <atomic>
 #include <future>
 #include <gensou/core.h>
 #include <gensou/scene.h>
@@ -25,12 +29,31 @@ public:
 
     void set_camera_orbiting(bool b) { if(m_camera) m_camera->set_orbit(b); }
 
+    /* switches the model between fp32 and int8 weights, picked up by the next forward pass */
+    void set_int8_inference(bool b);
+
+    /* retrains the model on the soybean series in the background, the weights are handed to the model between frames
+     * and the synapses follow them. turning it off keeps the trained weights
+     */
+    void set_training(bool b);
+
 private:
     void generate_ann_model();
 
     /* will set the weight's intensity based on their neuron's intensity */
     void forward_pass(uint32_t dataPoint);
 
+    /* while no forward pass is in flight: publishes the last training steps and starts the next ones */
+    void update_training();
+
+    /* every window of the series through both precisions, see activation_timeline */
+    void build_timelines();
+
+    /* neuron i of layer as displayed by frame (layer_count is the output), clamped to [0, 1]
+     * straight out of the timeline when there is one, from the frame's arena otherwise
+     */
+    float neuron_output(uint32_t frame, uint32_t layer, uint32_t i) const;
+
     void turn_off();
     void turn_on_layer(uint32_t layer);
     void turn_on_neurons(uint32_t layer);
@@ -52,10 +75,23 @@ private:
     uint32_t m_local_frame = 0;
     uint32_t m_frame_count = 2;
 
-    /* to hold the outputs during computation */
-    std::array<std::vector<float>, 2> m_neuron_outputs;
+    /* to hold the outputs during computation, a one sample inference arena (model::get_arena_offset) */
+    std::array<aligned_buffer, 2> m_neuron_outputs;
     std::vector<float> m_soybean_data;
 
+    /* precomputed activations, one per model_precision, and the window each frame is showing
+     * with the timelines built there is no inference left after on_init, any data point is just an index
+     */
+    bool m_precompute_timeline = true;
+    std::array<activation_timeline, 2> m_timelines;
+    std::array<uint32_t, 2> m_frame_data_points = { 0, 0 };
+
+    /* steps run between two frames, the model only sees their result once they are all done */
+    trainer m_trainer;
+    std::future<void> m_training_future;
+    std::atomic<bool> m_training{ false };
+    uint32_t m_published_epoch = 0;
+
     uint32_t m_current_data_point = 0;
     uint32_t m_last_data_point = 2048;
 
@@ -1,100 +1,661 @@
 #include "model.h"
+#include "simd.hpp"
 #include <gensou/components.h>
 #include <string>
 
 void model::on_init()
 {
-    biases.reserve(256);
-    weights.reserve(4096);
+    LOG(info, "simd kernels: %s (host supports %s)", simd::isa_name(simd::active_isa()), simd::isa_name(simd::supported_isa()));
 }
 
-void model::load(const std::string& path)
+void model::load(const std::string& path, simd::activation_accuracy accuracy)
+{
+    load(gs::system::load_file(path), accuracy);
+}
+
+void model::load(const std::shared_ptr<gs::gensou_file>& gsData, simd::activation_accuracy accuracy)
 {
-    auto gsData = gs::system::load_file(path);
     if(!gsData)
         return;
 
+    clear();
+    m_activation_accuracy = accuracy;
+
+    bool loaded = is_model_binary(gsData->data(), gsData->size()) ? load_binary(gsData) : load_csv(gsData);
+    if(!loaded)
+    {
+        clear();
+        return;
+    }
+
+    quantize_weights();
+    pack_weights();
+
+    /* every cached pass belongs to the previous weights */
+    m_version++;
+    set_cache_budget(m_cache_budget);
+
+    LOG(info, "layout:");
+    for(uint32_t layer = 0; layer < layout.size(); layer++)
+        LOG(info, "[%u, %u] %s", layout[layer].first, layout[layer].second, model_activation_name(m_layer_activations[layer].type));
+
+    LOG(info, "biases count == %zu, weights count == %zu (%s)", m_bias_count, m_weight_count, m_file ? "in place" : "copied");
+    LOG(info, "activation accuracy: %s", simd::activation_accuracy_name(accuracy));
+}
+
+tensor_view model::layer_weights(uint32_t layer) const
+{
+    const auto [rowCount, columnCount] = layout[layer];
+    return { m_weights + m_weight_offsets[layer], (uint32_t)padded_row(columnCount), rowCount, padded_row(rowCount) };
+}
+
+bool model::load_binary(const std::shared_ptr<gs::gensou_file>& gsData)
+{
+    model_binary_header header;
+    if(!validate_model_binary(gsData->data(), gsData->size(), header))
+    {
+        LOG(error, "failed to load ann model, bad or unsupported binary header");
+        return false;
+    }
+
+    const byte* base = gsData->data();
+    const std::vector<uint32_t> layerSizes = model_binary_layout(base, header);
+    set_layout(layerSizes.data(), header.layer_count);
+
+    if(!set_activations(model_binary_activations(base, header)))
+        return false;
+
+    const float* fileBiases = (const float*)(base + header.biases_offset);
+    const float* fileWeights = (const float*)(base + header.weights_offset);
+    const bool padded = header.version >= 2;
+
+    /* no parsing and no copies, the pointers go straight into the file */
+    if(padded && is_tensor_aligned(fileBiases) && is_tensor_aligned(fileWeights) &&
+        header.bias_count == m_bias_offsets.back() && header.weight_count == m_weight_offsets.back())
+    {
+        m_file = gsData;
+        m_biases = fileBiases;
+        m_weights = fileWeights;
+
+        return true;
+    }
+
+    return set_parameters(fileBiases, header.bias_count, fileWeights, header.weight_count, padded);
+}
+
+bool model::load_csv(const std::shared_ptr<gs::gensou_file>& gsData)
+{
     auto streamBuffer = gsData->data_as_buffer_stream();
     std::istream csv_stream(&streamBuffer);
 
     if (csv_stream.fail())
     {
         LOG(error, "failed to load file ann model");
-        return;
+        return false;
     }
 
-    std::string line, temp;
-    std::stringstream stream;
+    std::vector<uint32_t> layerSizes;
+    std::vector<float> csvBiases, csvWeights;
+    std::vector<model_layer_activation> activations;
 
-    std::getline(csv_stream, line);
-    if(line != "layout")
+    if(const char* error = parse_model_csv(csv_stream, layerSizes, csvBiases, csvWeights, activations))
     {
-        LOG(error, "failed to load ann model, bad layout");
-        return;
+        LOG(error, "failed to load ann model, %s", error);
+        return false;
+    }
+
+    set_layout(layerSizes.data(), layerSizes.size() - 1);
+
+    if(!set_activations(activations))
+        return false;
+
+    return set_parameters(csvBiases.data(), csvBiases.size(), csvWeights.data(), csvWeights.size(), false);
+}
+
+bool model::set_parameters(const float* biases, size_t biasCount, const float* weights, size_t weightCount, bool padded)
+{
+    const size_t expectedBiases = padded ? m_bias_offsets.back() : m_bias_count;
+    const size_t expectedWeights = padded ? m_weight_offsets.back() : m_weight_count;
+
+    if(biasCount != expectedBiases || weightCount != expectedWeights)
+    {
+        LOG(error, "failed to load ann model, %zu biases and %zu weights do not match its layout (%zu, %zu)", biasCount, weightCount, expectedBiases, expectedWeights);
+        return false;
     }
 
-    std::getline(csv_stream, line);
-    stream << line;
+    /* one allocation, the weights start right after the padded biases so both stay aligned
+     * kept when the size matches, assign_parameters goes through here on every update
+     */
+    if(m_parameters.size() != m_bias_offsets.back() + m_weight_offsets.back())
+        m_parameters.resize(m_bias_offsets.back() + m_weight_offsets.back());
+
+    float* outBiases = m_parameters.data();
+    float* outWeights = outBiases + m_bias_offsets.back();
+
+    if(padded)
+    {
+        memcpy(outBiases, biases, biasCount * sizeof(float));
+        memcpy(outWeights, weights, weightCount * sizeof(float));
+    }
+    else
+    {
+        std::vector<uint32_t> layerSizes;
+        for(auto [rowCount, columnCount] : layout)
+            layerSizes.push_back(rowCount);
+
+        layerSizes.push_back(layout.back().second);
+        pad_model_blobs(layerSizes.data(), (uint32_t)layout.size(), biases, weights, outBiases, outWeights);
+    }
+
+    m_biases = outBiases;
+    m_weights = outWeights;
+
+    return true;
+}
+
+void model::assign_parameters(const float* biases, const float* weights)
+{
+    if(layout.empty())
+        return;
+
+    set_parameters(biases, m_bias_offsets.back(), weights, m_weight_offsets.back(), true);
 
-    uint32_t count = 0;
-    std::pair<uint32_t , uint32_t> pair;
+    /* the file is no longer what the pointers refer to */
+    m_file.reset();
 
-    std::getline(stream, line, ',');
-    pair.first = std::stoul(line);
-    m_neuron_offsets.push_back(0);
-    uint32_t offset = 0;
+    quantize_weights();
+    pack_weights();
 
-    while(std::getline(stream, line, ','))
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    m_version++;
+}
+
+void model::set_layout(const uint32_t* layerSizes, uint32_t layerCount)
+{
+    layout.clear();
+    m_neuron_offsets.clear();
+    m_arena_offsets.clear();
+    m_bias_offsets.clear();
+    m_weight_offsets.clear();
+
+    uint32_t offset = 0, arenaOffset = 0;
+    size_t biasOffset = 0, weightOffset = 0;
+
+    m_neuron_offsets.push_back(offset);
+    m_arena_offsets.push_back(arenaOffset);
+
+    for(uint32_t i = 0; i < layerCount; i++)
     {
-        pair.second = std::stoul(line);
-        layout.push_back(pair);
-        
-        offset += pair.first;
+        layout.emplace_back(layerSizes[i], layerSizes[i + 1]);
+
+        offset += layerSizes[i];
         m_neuron_offsets.push_back(offset);
 
-        pair.first = pair.second;
+        arenaOffset += padded_row(layerSizes[i]);
+        m_arena_offsets.push_back(arenaOffset);
+
+        m_bias_offsets.push_back(biasOffset);
+        m_weight_offsets.push_back(weightOffset);
+
+        biasOffset += padded_row(layerSizes[i + 1]);
+        weightOffset += padded_row(layerSizes[i]) * padded_row(layerSizes[i + 1]);
+    }
+
+    /* the output layer's own segment closes the arena, its offset is the stride */
+    m_arena_offsets.push_back(arenaOffset + padded_row(layerSizes[layerCount]));
+
+    m_bias_offsets.push_back(biasOffset);
+    m_weight_offsets.push_back(weightOffset);
+
+    model_blob_sizes(layerSizes, layerCount, false, m_bias_count, m_weight_count);
+}
+
+bool model::set_activations(const std::vector<model_layer_activation>& activations)
+{
+    if(activations.size() != layout.size())
+    {
+        LOG(error, "failed to load ann model, %zu activations for %zu layers", activations.size(), layout.size());
+        return false;
+    }
+
+    m_layer_activations.clear();
+    for(const model_layer_activation& activation : activations)
+        m_layer_activations.push_back({ activation.activation, activation.alpha, m_activation_accuracy });
+
+    return true;
+}
+
+void model::quantize_weights()
+{
+    m_int8_offsets.clear();
+    m_int8_scales.resize(m_bias_offsets.back());
+    m_int8_row_sums.resize(m_bias_offsets.back());
+
+    size_t totalSize = 0;
+    for(auto [rowCount, columnCount] : layout)
+    {
+        m_int8_offsets.push_back(totalSize);
+        totalSize += simd::int8_padded_row(rowCount) * columnCount;
+    }
+
+    m_int8_weights.assign(totalSize, 0);
+
+    for(uint32_t layer = 0; layer < layout.size(); layer++)
+    {
+        const auto [rowCount, columnCount] = layout[layer];
+        const size_t paddedRow = simd::int8_padded_row(rowCount);
+        const tensor_view layerWeights = layer_weights(layer);
+
+        for(uint32_t i = 0; i < columnCount; i++)
+        {
+            /* symmetric, the largest weight of each output channel maps to +-127 */
+            const float* row = layerWeights.row(i);
+            int8_t* quantizedRow = &m_int8_weights[m_int8_offsets[layer] + i * paddedRow];
+
+            float maxAbs = 0.0f;
+            for(uint32_t j = 0; j < rowCount; j++)
+                maxAbs = std::max(maxAbs, std::abs(row[j]));
+
+            const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+            int32_t rowSum = 0;
+
+            for(uint32_t j = 0; j < rowCount; j++)
+            {
+                int32_t q = std::clamp((int32_t)std::nearbyint(row[j] / scale), -127, 127);
+                quantizedRow[j] = (int8_t)q;
+                rowSum += q;
+            }
+
+            m_int8_scales[m_bias_offsets[layer] + i] = scale;
+            m_int8_row_sums[m_bias_offsets[layer] + i] = rowSum;
+        }
+    }
+}
+
+void model::pack_weights()
+{
+    m_packed_offsets.clear();
+
+    size_t totalSize = 0;
+    for(auto [rowCount, columnCount] : layout)
+    {
+        m_packed_offsets.push_back(totalSize);
+        totalSize += simd::packed_size(rowCount, padded_row(columnCount));
+    }
+
+    m_packed_weights.resize(totalSize);
+
+    /* the padding rows of the original are zero, so are the packed columns they turn into */
+    for(uint32_t layer = 0; layer < layout.size(); layer++)
+    {
+        const tensor_view layerWeights = layer_weights(layer);
+        simd::pack_weights(layerWeights.data(), &m_packed_weights[m_packed_offsets[layer]], layout[layer].first, layerWeights.rows, layerWeights.stride);
     }
+}
+
+void model::clear()
+{
+    layout.clear();
+    m_neuron_offsets.clear();
+    m_arena_offsets.clear();
+    m_bias_offsets.clear();
+    m_weight_offsets.clear();
+
+    m_bias_count = m_weight_count = 0;
+    m_biases = m_weights = nullptr;
+    m_layer_activations.clear();
+
+    m_file.reset();
+    m_parameters.clear();
+
+    m_int8_weights.clear();
+    m_int8_offsets.clear();
+    m_int8_scales.clear();
+    m_int8_row_sums.clear();
+
+    m_packed_weights.clear();
+    m_packed_offsets.clear();
+
+    m_stream_window.clear();
+    reset_stream();
+
+    /* the budget is kept, load sizes the slots again for the new layout */
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    m_cache_slots.clear();
+    m_cache_arenas.clear();
+}
+
+void model::infer_batch(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride)
+{
+    infer_batch(inputs, batch, outputs, arena, inputStride, get_precision());
+}
+
+void model::infer_batch(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride, model_precision precision)
+{
+    if(layout.empty() || !batch)
+        return;
+
+    copy_inputs(inputs, batch, arena, inputStride);
+
+    /* the padding columns are computed as well, so the next layer reads finite values there */
+    for(uint32_t layer = 0; layer < layout.size(); layer++)
+        forward_layer(layer, 0, padded_row(layout[layer].second), batch, arena, precision);
+
+    copy_outputs(batch, arena, outputs);
+}
+
+void model::infer_batch_parallel(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride)
+{
+    if(layout.empty() || !batch)
+        return;
+
+    /* read once, every layer of the batch has to run at the same precision */
+    const model_precision precision = get_precision();
+
+    /* the calling thread takes a share of the work as well */
+    const size_t taskCount = gs::system::get_worker_count() + 1;
+
+    if(!inputStride)
+        inputStride = input_count();
 
-    std::getline(csv_stream, line);
-    if(line != "biases")
+    /*------------------------------data-parallel---------------------------------*/
+    /* samples are independent, each task runs every layer over its own slice of the batch */
+    if(batch >= taskCount * s_min_samples_per_task)
     {
-        LOG(error, "failed to load ann model, bad biases");
-        layout.clear();
+        const size_t stride = arena_stride();
+        const size_t outputCount = output_count();
+
+        gs::system::parallel_for(0, batch, s_min_samples_per_task, [&](size_t first, size_t last)
+        {
+            infer_batch(&inputs[first * inputStride], last - first, outputs ? &outputs[first * outputCount] : nullptr, &arena[first * stride], inputStride, precision);
+        });
+
         return;
     }
 
-    std::getline(csv_stream, line);
-    stream.str(std::string());
-    stream.clear();
-    stream << line;
+    /*------------------------------column-parallel-------------------------------*/
+    /* too few samples to go around, split the output columns of each layer instead
+     * every layer depends on the whole previous one, so there is a join barrier per layer
+     */
+    copy_inputs(inputs, batch, arena, inputStride);
+
+    for(uint32_t layer = 0; layer < layout.size(); layer++)
+    {
+        const uint32_t rowCount = layout[layer].first, columnCount = padded_row(layout[layer].second);
+
+        /* narrow layers are not worth the synchronization */
+        if(size_t(rowCount) * columnCount * batch < s_min_weights_per_task * 2)
+        {
+            forward_layer(layer, 0, columnCount, batch, arena, precision);
+            continue;
+        }
+
+        /* whole packed panels, a task can not start in the middle of one */
+        const size_t panel = simd::packed_panel_width;
+        const size_t grain = ((s_min_weights_per_task / (size_t(rowCount) * batch)) + panel - 1) & ~(panel - 1);
+        const size_t blockCount = (columnCount + panel - 1) / panel;
+
+        gs::system::parallel_for(0, blockCount, std::max<size_t>(grain / panel, 1ULL), [&](size_t first, size_t last)
+        {
+            forward_layer(layer, first * panel, std::min<size_t>(last * panel, columnCount), batch, arena, precision);
+        });
+    }
+
+    copy_outputs(batch, arena, outputs);
+}
 
-    while(std::getline(stream, line, ','))
+void model::copy_inputs(const float* inputs, size_t batch, float* arena, size_t inputStride) const
+{
+    const size_t stride = arena_stride();
+    const size_t inputCount = layout[0].first;
+    const size_t padding = padded_row(inputCount) - inputCount;
+
+    if(!inputStride)
+        inputStride = inputCount;
+
+    /* the first layer runs over the padding too, it has to be zero (the weights there are, but 0 * nan is not) */
+    for(size_t b = 0; b < batch; b++)
     {
-        biases.push_back(std::stof(line));
+        memcpy(&arena[b * stride], &inputs[b * inputStride], inputCount * sizeof(float));
+        memset(&arena[b * stride + inputCount], 0, padding * sizeof(float));
     }
+}
 
-    std::getline(csv_stream, line);
-    if(line != "weights")
+void model::copy_outputs(size_t batch, const float* arena, float* outputs) const
+{
+    if(!outputs)
+        return;
+
+    const size_t stride = arena_stride();
+    const size_t outputCount = layout.back().second;
+    const size_t outputOffset = m_arena_offsets[layout.size()];
+
+    for(size_t b = 0; b < batch; b++)
+        memcpy(&outputs[b * outputCount], &arena[b * stride + outputOffset], outputCount * sizeof(float));
+}
+
+void model::forward_layer(uint32_t layer, uint32_t firstColumn, uint32_t lastColumn, size_t batch, float* arena, model_precision precision)
+{
+    if(precision == model_precision::int8)
     {
-        LOG(error, "failed to load ann model, bad weights");
-        layout.clear();
-        biases.clear();
+        forward_layer_int8(layer, firstColumn, lastColumn, batch, arena);
+        return;
+    }
+
+    const size_t stride = arena_stride();
+    const uint32_t rowCount = layout[layer].first;
+    const uint32_t columnCount = lastColumn - firstColumn;
+
+    const float* packedWeights = &m_packed_weights[m_packed_offsets[layer] + size_t(firstColumn) * rowCount];
+    const size_t outputOffset = m_arena_offsets[layer + 1] + firstColumn;
+
+    /* bias and activation are fused into the gemm, each output is stored once
+     * firstColumn is always on a panel boundary (see infer_batch_parallel) and only the real inputs are read
+     */
+    m_layer_activations[layer].mat_mat_mul_packed_bias_activation(&arena[m_arena_offsets[layer]], packedWeights, layer_biases(layer) + firstColumn, &arena[outputOffset],
+        rowCount, columnCount, batch, stride, stride);
+}
+
+void model::forward_layer_int8(uint32_t layer, uint32_t firstColumn, uint32_t lastColumn, size_t batch, float* arena)
+{
+    /* every thread quantizes the layer's inputs into its own scratch, the column-parallel path
+     * repeats that per task but it is one pass over rowCount floats against rowCount * columns weights
+     */
+    thread_local std::vector<uint8_t> s_quantized_inputs;
+    thread_local std::vector<simd::int8_input> s_input_params;
+
+    /* int8 layers only read each layer's real inputs, the padding columns are skipped */
+    lastColumn = std::min(lastColumn, layout[layer].second);
+    if(firstColumn >= lastColumn)
+        return;
+
+    const size_t stride = arena_stride();
+    const uint32_t rowCount = layout[layer].first;
+    const uint32_t columnCount = lastColumn - firstColumn;
+    const size_t paddedRow = simd::int8_padded_row(rowCount);
+
+    s_quantized_inputs.resize(batch * paddedRow);
+    s_input_params.resize(batch);
+
+    for(size_t b = 0; b < batch; b++)
+        s_input_params[b] = simd::quantize_input(&arena[b * stride + m_arena_offsets[layer]], &s_quantized_inputs[b * paddedRow], rowCount, paddedRow);
+
+    const size_t outputOffset = m_arena_offsets[layer + 1] + firstColumn;
+    const size_t channelOffset = m_bias_offsets[layer] + firstColumn;
+
+    simd::mat_mat_mul_i8(s_quantized_inputs.data(), s_input_params.data(), &m_int8_weights[m_int8_offsets[layer] + firstColumn * paddedRow],
+        &m_int8_scales[channelOffset], &m_int8_row_sums[channelOffset], &arena[outputOffset], paddedRow, columnCount, batch, stride);
+
+    for(size_t b = 0; b < batch; b++)
+        m_layer_activations[layer].add_bias_activation(&arena[b * stride + outputOffset], &m_biases[channelOffset], columnCount);
+}
+
+bool model::push_observation(float value, float* outputs, float* arena)
+{
+    if(layout.empty())
+        return false;
+
+    const uint32_t windowSize = input_count();
+    m_stream_window.resize(windowSize * 2);
+
+    /* the oldest observation is overwritten, the window now starts right after it */
+    m_stream_window[m_stream_head] = value;
+    m_stream_window[m_stream_head + windowSize] = value;
+    m_stream_head = (m_stream_head + 1) % windowSize;
+
+    m_stream_count = std::min(m_stream_count + 1, windowSize);
+    if(m_stream_count < windowSize)
+        return false;
+
+    infer_batch(&m_stream_window[m_stream_head], 1, outputs, arena);
+    return true;
+}
+
+void model::set_cache_budget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    m_cache_budget = budgetBytes;
+    m_cache_slots.clear();
+    m_cache_arenas.clear();
+
+    if(layout.empty())
         return;
+
+    const size_t slotBytes = arena_stride() * sizeof(float);
+
+    size_t slotCount = 0;
+    for(size_t count = 1; count * slotBytes <= budgetBytes; count *= 2)
+        slotCount = count;
+
+    if(!slotCount)
+        return;
+
+    m_cache_slots.resize(slotCount);
+    m_cache_arenas.resize(slotCount * arena_stride());
+}
+
+void model::clear_cache()
+{
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    for(auto& slot : m_cache_slots)
+        slot.valid = false;
+
+    m_cache_hits = m_cache_misses = 0;
+}
+
+inference_cache_stats model::cache_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+    inference_cache_stats stats;
+    stats.hits = m_cache_hits;
+    stats.misses = m_cache_misses;
+    stats.capacity = m_cache_slots.size();
+    stats.bytes = m_cache_arenas.size() * sizeof(float);
+
+    for(const auto& slot : m_cache_slots)
+        stats.entries += slot.valid ? 1 : 0;
+
+    return stats;
+}
+
+/* fnv-1a over the bytes of the inputs */
+static uint64_t hash_inputs(const float* inputs, size_t count)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(inputs);
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(size_t i = 0; i < count * sizeof(float); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    return hash;
+}
+
+bool model::infer_cached(const float* inputs, float* outputs, float* arena)
+{
+    if(layout.empty())
+        return false;
+
+    const model_precision precision = get_precision();
+    const size_t stride = arena_stride();
+    const size_t inputCount = input_count();
+    const uint64_t hash = hash_inputs(inputs, inputCount);
+
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+
+        if(!m_cache_slots.empty())
+        {
+            const size_t index = hash & (m_cache_slots.size() - 1);
+            const cache_slot& slot = m_cache_slots[index];
+            const float* cached = &m_cache_arenas[index * stride];
+
+            if(slot.valid && slot.hash == hash && slot.version == m_version && slot.precision == precision &&
+                memcmp(cached, inputs, inputCount * sizeof(float)) == 0)
+            {
+                memcpy(arena, cached, stride * sizeof(float));
+                m_cache_hits++;
+
+                copy_outputs(1, arena, outputs);
+                return true;
+            }
+
+            m_cache_misses++;
+        }
     }
 
-    std::getline(csv_stream, line);
-    stream.str(std::string());
-    stream.clear();
-    stream << line;
+    infer_batch(inputs, 1, outputs, arena, 0, precision);
+
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
 
-    while(std::getline(stream, line, ','))
+    /* the budget may have changed while the pass was running */
+    if(!m_cache_slots.empty())
     {
-        weights.push_back(std::stof(line));
+        const size_t index = hash & (m_cache_slots.size() - 1);
+
+        m_cache_slots[index] = { hash, m_version, precision, true };
+        memcpy(&m_cache_arenas[index * stride], arena, stride * sizeof(float));
     }
 
-    LOG(info, "layout:");
-    for(auto [input, output] : layout)
-        LOG(info, "[%u, %u]", input, output);
+    return false;
+}
 
-    LOG(info, "biases count == %zu, weights count == %zu", biases.size(), weights.size());
-}
\ No newline at end of file
+quantization_report model::measure_quantization_error(const float* inputs, size_t batch, size_t inputStride)
+{
+    quantization_report report;
+    if(layout.empty() || !batch)
+        return report;
+
+    const size_t outputCount = output_count();
+
+    aligned_buffer arena(batch_arena_size(batch));
+    std::vector<float> reference(batch * outputCount), quantized(batch * outputCount);
+
+    infer_batch(inputs, batch, reference.data(), arena.data(), inputStride, model_precision::fp32);
+    infer_batch(inputs, batch, quantized.data(), arena.data(), inputStride, model_precision::int8);
+
+    float low = reference[0], high = reference[0];
+    double errorSum = 0.0;
+
+    for(size_t i = 0; i < reference.size(); i++)
+    {
+        float error = std::abs(quantized[i] - reference[i]);
+
+        report.max_abs_error = std::max(report.max_abs_error, error);
+        errorSum += error;
+
+        low = std::min(low, reference[i]);
+        high = std::max(high, reference[i]);
+    }
+
+    report.samples = batch;
+    report.mean_abs_error = float(errorSum / double(reference.size()));
+    report.max_relative_error = high > low ? report.max_abs_error / (high - low) : 0.0f;
+
+    report.fp32_weight_bytes = m_weight_offsets.back() * sizeof(float);
+    report.int8_weight_bytes = m_int8_weights.size() + (m_int8_scales.size() * sizeof(float)) + (m_int8_row_sums.size() * sizeof(int32_t));
+
+    return report;
+}
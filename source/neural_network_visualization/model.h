@@ -1,32 +1,227 @@
 #pragma once
 
 #include "activation_functions.hpp"
+#include "model_format.h"
+#include "tensor.h"
 
 #include <gensou/core.h>
 #include <gensou/scene_actor.h>
 
+#include <atomic>
+#include <mutex>
+
+enum class model_precision : uint32_t { fp32 = 0, int8 };
+
+/* int8 outputs compared against fp32 over the same batch */
+struct quantization_report
+{
+	size_t samples = 0;
+	float max_abs_error = 0.0f, mean_abs_error = 0.0f;
+
+	/* max_abs_error over the range of the fp32 outputs */
+	float max_relative_error = 0.0f;
+
+	size_t fp32_weight_bytes = 0, int8_weight_bytes = 0;
+};
+
+struct inference_cache_stats
+{
+	size_t hits = 0, misses = 0;
+
+	/* slots in use out of capacity, and the bytes behind all of them */
+	size_t entries = 0, capacity = 0, bytes = 0;
+};
+
 class model : public gs::scene_actor
 {
 public:
 
 	virtual void on_init() override;
 
-	void load(const std::string& path);
+	/* accepts both the binary container (model_format.h) and the original csv text, each layer keeps the activation stored with it
+	 * accuracy picks how sigmoid and tanh layers are evaluated (see simd::activation_accuracy), the others are exact either way
+	 */
+	void load(const std::string& path, simd::activation_accuracy accuracy = simd::activation_accuracy::exact);
+	void load(const std::shared_ptr<gs::gensou_file>& gsData, simd::activation_accuracy accuracy = simd::activation_accuracy::exact);
+	simd::activation_accuracy activation_accuracy() const { return m_activation_accuracy; }
 
-	uint32_t neuron_count() { return biases.size(); }
-	uint32_t weights_count() { return weights.size(); }
-	uint32_t input_count() { return layout[0].first; }
-	uint32_t output_count() { return layout.back().second; }
+	uint32_t neuron_count() const { return m_bias_count; }
+	uint32_t weights_count() const { return m_weight_count; }
+	uint32_t input_count() const { return layout[0].first; }
+	uint32_t output_count() const { return layout.back().second; }
 
-	/* from layer 0 to layers.size + 1 for the output offset */
+	/* inputs + every neuron with each layer padded to padded_row, the per-sample stride of a batch arena */
+	uint32_t arena_stride() const { return m_arena_offsets.back(); }
+
+	/* floats required by infer_batch's arena for a given batch size */
+	size_t batch_arena_size(size_t batch) const { return batch * arena_stride(); }
+
+	/* runs the whole model over a batch of samples, one blocked gemm per layer
+	 * inputs: sample b starts at inputs[b * inputStride] (0 == input_count, use 1 to slide a window over a series)
+	 * outputs: batch * output_count floats, may be nullptr
+	 * arena: batch_arena_size(batch) floats, sample b's activations (inputs first) start at arena[b * arena_stride()]
+	 * and layer l's at get_arena_offset(l) from there, anything past a layer's neuron count is padding
+	 * an aligned_buffer keeps every layer of every sample on a cache line, any float array works though
+	 */
+	void infer_batch(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride = 0);
+
+	/* same contract as infer_batch, spread over the engine's thread pool
+	 * large batches are split by samples, small ones split each wide layer's output columns with a join barrier per layer
+	 * blocks until the whole batch is done, helping with pending pool tasks in the meantime
+	 */
+	void infer_batch_parallel(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride = 0);
+
+	/* int8 runs every layer on weights quantized at load time (symmetric, one scale per output channel)
+	 * inputs of each layer are quantized per sample on the fly, biases and activations stay in fp32
+	 * takes effect on the next infer_batch call, safe to flip while another thread is inferring
+	 */
+	void set_precision(model_precision precision) { m_precision.store(precision, std::memory_order_relaxed); }
+	model_precision get_precision() const { return m_precision.load(std::memory_order_relaxed); }
+
+	/* runs the batch at both precisions and compares the outputs, same input contract as infer_batch */
+	quantization_report measure_quantization_error(const float* inputs, size_t batch, size_t inputStride = 0);
+
+	/* streams a series one observation at a time, the window is always the last input_count() observations
+	 * returns false until the window has filled up, after that every push runs the model over the new window
+	 * (a batch of one, outputs and arena as in infer_batch). one stream per model, not thread-safe
+	 */
+	bool push_observation(float value, float* outputs, float* arena);
+	void reset_stream() { m_stream_head = 0; m_stream_count = 0; }
+
+	/* observations pushed since the last reset, saturates at input_count() */
+	uint32_t stream_size() const { return m_stream_count; }
+
+	/* direct-mapped cache of whole forward passes, one slot per window holding every layer's activations
+	 * keyed by a hash of the inputs plus the model version (bumped on every load) and the precision,
+	 * a hit is confirmed against the cached inputs so a hash collision is only ever a miss
+	 * the slot count is the largest power of two whose arenas fit in budgetBytes, 0 turns the cache off
+	 */
+	void set_cache_budget(size_t budgetBytes);
+	void clear_cache();
+	inference_cache_stats cache_stats() const;
+
+	/* infer_batch for a batch of one served from the cache when possible, same arguments, returns true on a hit
+	 * thread-safe against itself, a miss runs the forward pass outside the lock
+	 */
+	bool infer_cached(const float* inputs, float* outputs, float* arena);
+
+	/* from layer 0 to layers.size + 1 for the output offset, neurons numbered back to back */
 	uint32_t get_layer_offset(uint32_t layer) const { return m_neuron_offsets[layer]; }
 
-	std::vector<float> biases;
-	std::vector<float> weights;
+	/* same as get_layer_offset but into one sample of the arena, always a multiple of padded_row */
+	uint32_t get_arena_offset(uint32_t layer) const { return m_arena_offsets[layer]; }
+
+	/* one row per output neuron (padded_row(outputs) rows, the padding ones are zero), padded_row(inputs) stride
+	 * the layout of the file, for visualization and export. inference runs on a packed copy, see pack_weights
+	 */
+	tensor_view layer_weights(uint32_t layer) const;
+
+	/* padded_row(outputs) floats, zero past the layer's neuron count */
+	const float* layer_biases(uint32_t layer) const { return m_biases + m_bias_offsets[layer]; }
+
+	/* from layer 0 to layers.size for the totals, where layer_biases and layer_weights start in the padded blobs */
+	size_t get_bias_offset(uint32_t layer) const { return m_bias_offsets[layer]; }
+	size_t get_weight_offset(uint32_t layer) const { return m_weight_offsets[layer]; }
+
+	const layer_activation& get_layer_activation(uint32_t layer) const { return m_layer_activations[layer]; }
+
+	/* replaces every parameter, both blobs in the padded layout (get_bias_offset(layout.size()) biases and
+	 * get_weight_offset(layout.size()) weights, padding zero), how a trainer hands its weights back
+	 * repacks and requantizes them and bumps the version so no cached pass survives
+	 * the model is not readable while this runs, no inference may be in flight on another thread
+	 */
+	void assign_parameters(const float* biases, const float* weights);
 
 	std::vector<std::pair<uint32_t, uint32_t>> layout;
 	std::vector<uint32_t> m_neuron_offsets;
 
-	relu activation_fn;	
+private:
+	bool load_binary(const std::shared_ptr<gs::gensou_file>& gsData);
+	bool load_csv(const std::shared_ptr<gs::gensou_file>& gsData);
+
+	void set_layout(const uint32_t* layerSizes, uint32_t layerCount);
+	bool set_activations(const std::vector<model_layer_activation>& activations);
+	bool set_parameters(const float* biases, size_t biasCount, const float* weights, size_t weightCount, bool padded);
+	void quantize_weights();
+	void pack_weights();
+	void clear();
+
+	void infer_batch(const float* inputs, size_t batch, float* outputs, float* arena, size_t inputStride, model_precision precision);
+
+	void copy_inputs(const float* inputs, size_t batch, float* arena, size_t inputStride) const;
+	void copy_outputs(size_t batch, const float* arena, float* outputs) const;
+
+	/* columns [firstColumn, lastColumn) of one layer for the whole batch */
+	void forward_layer(uint32_t layer, uint32_t firstColumn, uint32_t lastColumn, size_t batch, float* arena, model_precision precision);
+	void forward_layer_int8(uint32_t layer, uint32_t firstColumn, uint32_t lastColumn, size_t batch, float* arena);
+
+private:
+	/* below these a task costs more to schedule than to run */
+	static constexpr size_t s_min_samples_per_task = 16;
+	static constexpr size_t s_min_weights_per_task = 16384;
+
+	/* per layer plus the total at the back, into the padded biases and weights */
+	std::vector<size_t> m_bias_offsets, m_weight_offsets;
+	std::vector<uint32_t> m_arena_offsets;
+
+	/* without the padding */
+	size_t m_bias_count = 0, m_weight_count = 0;
+
+	/* one per layer, the output layer included */
+	std::vector<layer_activation> m_layer_activations;
+
+private:
+	/* padded layout (see tensor.h), version 2 binaries that happen to be aligned in memory are used in place
+	 * and the file has to outlive the pointers, everything else is copied into m_parameters
+	 */
+	const float* m_biases = nullptr;
+	const float* m_weights = nullptr;
+
+	std::shared_ptr<gs::gensou_file> m_file;
+	aligned_buffer m_parameters;
+
+private:
+	std::atomic<model_precision> m_precision{ model_precision::fp32 };
+
+	/* rows padded to simd::int8_padded_row, per layer offsets in m_int8_offsets
+	 * scales and row sums are per output channel and share the biases' offsets
+	 */
+	std::vector<int8_t> m_int8_weights;
+	std::vector<size_t> m_int8_offsets;
+	std::vector<float> m_int8_scales;
+	std::vector<int32_t> m_int8_row_sums;
+
+private:
+	/* every layer's weights repacked at load time into panels of simd::packed_panel_width output columns
+	 * (see simd::pack_weights), only the real inputs are packed, padded_row(outputs) columns per layer
+	 * layer l starts at m_packed_offsets[l], always on a cache line
+	 */
+	aligned_buffer m_packed_weights;
+	std::vector<size_t> m_packed_offsets;
+
+private:
+	/* ring buffer of input_count() observations written twice, at head and head + input_count(),
+	 * so the window that starts at head is always contiguous and a push never shifts anything
+	 */
+	std::vector<float> m_stream_window;
+	uint32_t m_stream_head = 0, m_stream_count = 0;
+
+private:
+	struct cache_slot
+	{
+		uint64_t hash = 0;
+		uint32_t version = 0;
+		model_precision precision = model_precision::fp32;
+		bool valid = false;
+	};
+
+	/* m_cache_slots[i]'s arena is m_cache_arenas[i * arena_stride()], the inputs it was computed from come first */
+	std::vector<cache_slot> m_cache_slots;
+	aligned_buffer m_cache_arenas;
+	size_t m_cache_budget = 0, m_cache_hits = 0, m_cache_misses = 0;
+	mutable std::mutex m_cache_mutex;
+
+	uint32_t m_version = 0;
+	simd::activation_accuracy m_activation_accuracy = simd::activation_accuracy::exact;
 
 };
@@ -0,0 +1,381 @@
+#pragma once
+
+#include "tensor.h"
+
+#include <stdint.h>
+#include <cstring>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * binary model container, stored as the payload of a regular gensou file (after the 12-byte AOTO header)
+ *
+ * | model_binary_header                        | 64 bytes
+ * | uint32_t layer sizes[layer_count + 1]      | at layout_offset, inputs first
+ * | float biases[bias_count]                   | at biases_offset, 64-byte aligned in the file
+ * | float weights[weight_count]                | at weights_offset, 64-byte aligned in the file, row-major as in the csv (one row per output)
+ * | model_layer_activation[layer_count]        | at activations_offset, version 3 and up
+ *
+ * every offset is relative to the start of the payload, so the blobs can be used in place
+ * straight from the loaded (or mapped) file, without any parsing or copies
+ * the blobs are aligned relative to the start of the file though (payload offset + model_payload_offset), that is what
+ * lands on a page when the file is mapped and on archive_blob_alignment in a packed archive
+ *
+ * version 2 stores the blobs in the model's padded layout (tensor.h), zeros in the padding:
+ * each layer's biases take padded_row(outputs) floats and its weights padded_row(outputs) rows of padded_row(inputs) floats
+ * version 1 blobs are packed back to back and have to be copied into that layout when loading
+ * version 3 adds an activation per layer, before it header.activation applied to every layer (the output included)
+ */
+
+/* stored in the files, only ever append */
+enum class model_activation : uint32_t { relu = 0, leaky_relu, sigmoid, hyperbolic_tan, linear, count };
+
+struct model_layer_activation
+{
+	model_activation activation = model_activation::relu;
+
+	/* leaky_relu's slope below zero, ignored by the others */
+	float alpha = 0.01f;
+};
+
+static_assert(sizeof(model_layer_activation) == 8, "model_layer_activation is part of the file format");
+
+struct model_binary_header
+{
+	char magic[4] = { 'G', 'S', 'N', 'N' };
+	uint32_t version = 3;
+
+	uint32_t layer_count = 0;
+	model_activation activation = model_activation::relu;
+
+	uint64_t layout_offset = 0;
+	uint64_t biases_offset = 0, bias_count = 0;
+	uint64_t weights_offset = 0, weight_count = 0;
+
+	/* reserved (and zero) before version 3 */
+	uint64_t activations_offset = 0;
+};
+
+static_assert(sizeof(model_binary_header) == 64, "model_binary_header must stay 64 bytes");
+
+static constexpr uint32_t model_binary_version = 3;
+static constexpr uint64_t model_blob_alignment = 64;
+
+/* where the payload starts in its gensou file, past the AOTO magic and the uuid */
+static constexpr uint64_t model_payload_offset = 12;
+
+/* the most a model (binary or csv) can declare, within them every neuron, arena and bias offset of a model fits in 32 bits */
+static constexpr uint32_t model_max_layer_count = 1024;
+static constexpr uint32_t model_max_layer_size = 1u << 20;
+
+/* float counts of the biases and weights blobs, packed (version 1 and the csv) or padded (version 2) */
+inline void model_blob_sizes(const uint32_t* layerSizes, uint32_t layerCount, bool padded, size_t& outBiasCount, size_t& outWeightCount)
+{
+	outBiasCount = outWeightCount = 0;
+
+	for(uint32_t i = 0; i < layerCount; i++)
+	{
+		const size_t rows = padded ? padded_row(layerSizes[i + 1]) : layerSizes[i + 1];
+		const size_t columns = padded ? padded_row(layerSizes[i]) : layerSizes[i];
+
+		outBiasCount += rows;
+		outWeightCount += rows * columns;
+	}
+}
+
+inline const char* model_activation_name(model_activation activation)
+{
+	switch(activation)
+	{
+		case model_activation::leaky_relu:     return "leaky_relu";
+		case model_activation::sigmoid:        return "sigmoid";
+		case model_activation::hyperbolic_tan: return "tanh";
+		case model_activation::linear:         return "linear";
+		default:                               return "relu";
+	}
+}
+
+/* one of the names above, leaky_relu optionally followed by its slope (leaky_relu:0.1), false if it is none of them */
+inline bool parse_model_activation(std::string name, model_layer_activation& outActivation)
+{
+	name.erase(0, name.find_first_not_of(" \r"));
+	name.erase(name.find_last_not_of(" \r") + 1);
+
+	outActivation = model_layer_activation();
+
+	const size_t separator = name.find(':');
+	if(separator != std::string::npos)
+	{
+		if(name.compare(0, separator, "leaky_relu") != 0)
+			return false;
+
+		outActivation.alpha = std::strtof(name.c_str() + separator + 1, nullptr);
+		name.resize(separator);
+	}
+
+	for(uint32_t i = 0; i < uint32_t(model_activation::count); i++)
+	{
+		if(name == model_activation_name(model_activation(i)))
+		{
+			outActivation.activation = model_activation(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+inline bool is_model_binary(const uint8_t* data, size_t size)
+{
+	return size >= sizeof(model_binary_header) && memcmp(data, "GSNN", 4) == 0;
+}
+
+/* copies the header into outHeader, false if it is not a supported version, any blob falls outside of the data,
+ * the layout declares an empty or oversized layer or the blobs don't hold exactly what the layout needs
+ * the payload starts 12 bytes into its file, the header is copied out rather than read in place (it holds uint64s)
+ */
+inline bool validate_model_binary(const uint8_t* data, size_t size, model_binary_header& outHeader)
+{
+	if(!is_model_binary(data, size))
+		return false;
+
+	memcpy(&outHeader, data, sizeof(outHeader));
+	const model_binary_header& header = outHeader;
+
+	if(!header.version || header.version > model_binary_version || !header.layer_count || header.layer_count > model_max_layer_count)
+		return false;
+
+	/* counts are checked against the size before they are scaled, so the products can't wrap */
+	auto fits = [size](uint64_t offset, uint64_t count, uint64_t elementSize)
+	{
+		return count <= size / elementSize && offset <= size && count * elementSize <= size - offset;
+	};
+
+	if(!fits(header.layout_offset, uint64_t(header.layer_count) + 1, sizeof(uint32_t)) ||
+		!fits(header.biases_offset, header.bias_count, sizeof(float)) ||
+		!fits(header.weights_offset, header.weight_count, sizeof(float)))
+	{
+		return false;
+	}
+
+	/* the layout is read through memcpy, nothing asks layout_offset to be 4-byte aligned */
+	const bool padded = header.version >= 2;
+	uint64_t biasCount = 0, weightCount = 0;
+	uint32_t inputCount = 0;
+
+	for(uint32_t i = 0; i <= header.layer_count; i++)
+	{
+		uint32_t layerSize;
+		memcpy(&layerSize, data + header.layout_offset + i * sizeof(uint32_t), sizeof(layerSize));
+
+		if(!layerSize || layerSize > model_max_layer_size)
+			return false;
+
+		if(i)
+		{
+			const uint64_t rows = padded ? padded_row(layerSize) : layerSize;
+			const uint64_t columns = padded ? padded_row(inputCount) : inputCount;
+
+			biasCount += rows;
+			weightCount += rows * columns;
+		}
+
+		inputCount = layerSize;
+	}
+
+	if(biasCount != header.bias_count || weightCount != header.weight_count)
+		return false;
+
+	if(header.version < 3)
+		return header.activation < model_activation::count;
+
+	if(!fits(header.activations_offset, header.layer_count, sizeof(model_layer_activation)))
+		return false;
+
+	/* read through memcpy, the table only has to be 4-byte aligned in the file and nothing checks that */
+	for(uint32_t i = 0; i < header.layer_count; i++)
+	{
+		model_layer_activation activation;
+		memcpy(&activation, data + header.activations_offset + i * sizeof(model_layer_activation), sizeof(activation));
+
+		if(activation.activation >= model_activation::count)
+			return false;
+	}
+
+	return true;
+}
+
+/* the neuron count of every layer of a validated binary, inputs first */
+inline std::vector<uint32_t> model_binary_layout(const uint8_t* data, const model_binary_header& header)
+{
+	std::vector<uint32_t> layerSizes(header.layer_count + 1);
+	memcpy(layerSizes.data(), data + header.layout_offset, layerSizes.size() * sizeof(uint32_t));
+
+	return layerSizes;
+}
+
+/* the activation of every layer of a validated binary, header.activation repeated before version 3 */
+inline std::vector<model_layer_activation> model_binary_activations(const uint8_t* data, const model_binary_header& header)
+{
+	std::vector<model_layer_activation> activations(header.layer_count);
+
+	if(header.version < 3)
+	{
+		for(auto& activation : activations)
+			activation.activation = header.activation;
+	}
+	else
+	{
+		memcpy(activations.data(), data + header.activations_offset, header.layer_count * sizeof(model_layer_activation));
+	}
+
+	return activations;
+}
+
+/* copies packed biases and weights (as in the csv) into the padded layout, outBiases and outWeights must be zeroed and sized
+ * by model_blob_sizes(..., padded = true)
+ */
+inline void pad_model_blobs(const uint32_t* layerSizes, uint32_t layerCount, const float* biases, const float* weights, float* outBiases, float* outWeights)
+{
+	for(uint32_t layer = 0; layer < layerCount; layer++)
+	{
+		const size_t inputCount = layerSizes[layer], outputCount = layerSizes[layer + 1];
+		const size_t stride = padded_row(inputCount);
+
+		memcpy(outBiases, biases, outputCount * sizeof(float));
+
+		for(size_t i = 0; i < outputCount; i++)
+			memcpy(&outWeights[i * stride], &weights[i * inputCount], inputCount * sizeof(float));
+
+		biases += outputCount;
+		weights += outputCount * inputCount;
+
+		outBiases += padded_row(outputCount);
+		outWeights += padded_row(outputCount) * stride;
+	}
+}
+
+/* layerSizes holds the neuron count of every layer, inputs first, biases and weights are packed as in the csv
+ * activations has one entry per layer (layerSizes.size() - 1)
+ * always writes the current version, the blobs are padded on the way
+ */
+inline std::vector<uint8_t> serialize_model_binary(const std::vector<uint32_t>& layerSizes, const float* biases, const float* weights,
+	const std::vector<model_layer_activation>& activations)
+{
+	/* payload offsets whose position in the file is aligned */
+	auto align = [](uint64_t offset)
+	{
+		return ((offset + model_payload_offset + model_blob_alignment - 1) & ~(model_blob_alignment - 1)) - model_payload_offset;
+	};
+
+	model_binary_header header;
+	header.layer_count = uint32_t(layerSizes.size() - 1);
+
+	/* readers of version 3 ignore it, the hidden layers' activation for anyone looking at the header */
+	header.activation = activations.front().activation;
+
+	size_t biasCount = 0, weightCount = 0;
+	model_blob_sizes(layerSizes.data(), header.layer_count, true, biasCount, weightCount);
+
+	header.layout_offset = sizeof(model_binary_header);
+	header.biases_offset = align(header.layout_offset + layerSizes.size() * sizeof(uint32_t));
+	header.bias_count = biasCount;
+	header.weights_offset = align(header.biases_offset + biasCount * sizeof(float));
+	header.weight_count = weightCount;
+	header.activations_offset = header.weights_offset + weightCount * sizeof(float);
+
+	std::vector<uint8_t> outData(header.activations_offset + header.layer_count * sizeof(model_layer_activation), 0);
+
+	memcpy(outData.data(), &header, sizeof(header));
+	memcpy(&outData[header.layout_offset], layerSizes.data(), layerSizes.size() * sizeof(uint32_t));
+
+	pad_model_blobs(layerSizes.data(), header.layer_count, biases, weights,
+		(float*)&outData[header.biases_offset], (float*)&outData[header.weights_offset]);
+
+	memcpy(&outData[header.activations_offset], activations.data(), header.layer_count * sizeof(model_layer_activation));
+
+	return outData;
+}
+
+/* the original text format:
+ * layout\n 8, 64, 256, 64, 1\n biases\n b0, b1, ...\n weights\n w0, w1, ...
+ * optionally followed by one activation per layer (relu for all of them when it is missing):
+ * activations\n relu, relu, relu, linear
+ * returns nullptr on success or an error message
+ */
+inline const char* parse_model_csv(std::istream& csvStream, std::vector<uint32_t>& layerSizes, std::vector<float>& biases, std::vector<float>& weights,
+	std::vector<model_layer_activation>& activations)
+{
+	std::string line;
+	std::stringstream stream;
+
+	std::getline(csvStream, line);
+	if(line != "layout")
+		return "bad layout";
+
+	std::getline(csvStream, line);
+	stream << line;
+
+	while(std::getline(stream, line, ','))
+	{
+		if(line.find_first_not_of(" \r") == std::string::npos)
+			continue;
+
+		const unsigned long layerSize = std::stoul(line);
+		if(!layerSize || layerSize > model_max_layer_size)
+			return "bad layout";
+
+		layerSizes.push_back((uint32_t)layerSize);
+	}
+
+	if(layerSizes.size() < 2 || layerSizes.size() > model_max_layer_count + 1)
+		return "bad layout";
+
+	std::getline(csvStream, line);
+	if(line != "biases")
+		return "bad biases";
+
+	std::getline(csvStream, line);
+	stream.str(std::string());
+	stream.clear();
+	stream << line;
+
+	while(std::getline(stream, line, ','))
+		biases.push_back(std::stof(line));
+
+	std::getline(csvStream, line);
+	if(line != "weights")
+		return "bad weights";
+
+	std::getline(csvStream, line);
+	stream.str(std::string());
+	stream.clear();
+	stream << line;
+
+	while(std::getline(stream, line, ','))
+		weights.push_back(std::stof(line));
+
+	activations.assign(layerSizes.size() - 1, model_layer_activation());
+
+	if(!std::getline(csvStream, line) || line.find_first_not_of(" \r") == std::string::npos)
+		return nullptr;
+
+	if(line.compare(0, 11, "activations") != 0)
+		return "bad activations";
+
+	std::getline(csvStream, line);
+	stream.str(std::string());
+	stream.clear();
+	stream << line;
+
+	size_t layer = 0;
+	while(std::getline(stream, line, ','))
+	{
+		if(layer == activations.size() || !parse_model_activation(line, activations[layer++]))
+			return "bad activations";
+	}
+
+	return layer == activations.size() ? nullptr : "bad activations";
+}
@@ -1,232 +1,412 @@
 #pragma once
 
-#include <vector>
-
-#ifndef APP_ANDROID
-
-#include <immintrin.h>
+#include "simd_scalar.hpp"
+#include "simd_sse.hpp"
+#include "simd_avx2.hpp"
+#include "simd_avx512.hpp"
+#include "simd_neon.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
+/*
+ * every kernel exists once per instruction set (simd_scalar/sse/avx2/avx512/neon.hpp), each compiled for its own target,
+ * so the binary itself only requires the baseline of the platform. the best set the host supports is picked at startup
+ * through cpuid and bound into a table of function pointers, the functions below forward to it
+ * on aarch64 neon is part of the baseline, it is always picked unless scalar is asked for
+ *
+ * NNV_SIMD=scalar|sse4.2|avx2|avx512|neon in the environment caps the level (it never goes above what the host supports),
+ * set_isa does the same at runtime, both meant for benchmarking and for checking the kernels against each other
+ */
 namespace simd {
 
-    inline __m256 pow2_ps(__m256 m)
+    struct kernel_table
+    {
+        isa level;
+
+        float (*accumulate)(const float*, size_t);
+        void (*vec_mat_mul)(const float*, const float*, float*, size_t, size_t);
+        void (*mat_mat_mul)(const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*set_to_zero)(float*, size_t);
+        void (*set_range_value)(float*, size_t, float);
+        void (*scale_offset)(float*, size_t, float, float);
+
+        int8_input (*quantize_input)(const float*, uint8_t*, size_t, size_t);
+        void (*vec_mat_mul_i8)(const uint8_t*, int8_input, const int8_t*, const float*, const int32_t*, float*, size_t, size_t);
+        void (*mat_mat_mul_i8)(const uint8_t*, const int8_input*, const int8_t*, const float*, const int32_t*, float*, size_t, size_t, size_t, size_t);
+
+        /* sigmoid and tanh have one entry per activation_accuracy */
+        static constexpr size_t accuracy_count = size_t(activation_accuracy::count);
+
+        void (*add_bias_sigmoid[accuracy_count])(float*, const float*, size_t);
+        void (*add_bias_tanh[accuracy_count])(float*, const float*, size_t);
+        void (*add_bias_relu)(float*, const float*, size_t);
+        void (*add_bias_leaky_relu)(float*, const float*, size_t, float);
+        void (*add_bias_linear)(float*, const float*, size_t);
+
+        void (*mat_mat_mul_bias_sigmoid[accuracy_count])(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_bias_tanh[accuracy_count])(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_bias_relu)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_bias_leaky_relu)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t, float);
+        void (*mat_mat_mul_bias_linear)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+
+        void (*mat_mat_mul_packed)(const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_packed_bias_sigmoid[accuracy_count])(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_packed_bias_tanh[accuracy_count])(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_packed_bias_relu)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*mat_mat_mul_packed_bias_leaky_relu)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t, float);
+        void (*mat_mat_mul_packed_bias_linear)(const float*, const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+
+        void (*mat_t_mat_mul)(const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t);
+        void (*rank1_update)(const float*, const float*, float*, size_t, size_t, size_t);
+        void (*rank_k_update)(const float*, const float*, float*, size_t, size_t, size_t, size_t, size_t, size_t);
+        void (*accumulate_rows)(const float*, float*, size_t, size_t, size_t);
+        void (*mul_derivative_sigmoid)(float*, const float*, size_t);
+        void (*mul_derivative_tanh)(float*, const float*, size_t);
+        void (*mul_derivative_relu)(float*, const float*, size_t);
+        void (*mul_derivative_leaky_relu)(float*, const float*, size_t, float);
+    };
+
+/* the fused kernels bound through *_op<> take their ops from epi, only different for avx512 whose epilogues run on 8 lanes
+ * the backward kernels come from train, they only exist for avx2 (avx512 shares them) and scalar
+ */
+#define SIMD_KERNEL_TABLE(level_, fp32, int8, epi, train) kernel_table{ level_, \
+    fp32::accumulate, fp32::vec_mat_mul, fp32::mat_mat_mul, fp32::set_to_zero, fp32::set_range_value, fp32::scale_offset, \
+    int8::quantize_input, int8::vec_mat_mul_i8, int8::mat_mat_mul_i8, \
+    { fp32::add_bias_sigmoid, fp32::add_bias_op<fp32::sigmoid_poly_op>, fp32::add_bias_op<fp32::sigmoid_rational_op> }, \
+    { fp32::add_bias_tanh, fp32::add_bias_op<fp32::tanh_poly_op>, fp32::add_bias_op<fp32::tanh_rational_op> }, \
+    fp32::add_bias_relu, fp32::add_bias_leaky_relu, fp32::add_bias_op<fp32::linear_op>, \
+    { fp32::mat_mat_mul_bias_sigmoid, fp32::mat_mat_mul_bias_op<epi::sigmoid_poly_op>, fp32::mat_mat_mul_bias_op<epi::sigmoid_rational_op> }, \
+    { fp32::mat_mat_mul_bias_tanh, fp32::mat_mat_mul_bias_op<epi::tanh_poly_op>, fp32::mat_mat_mul_bias_op<epi::tanh_rational_op> }, \
+    fp32::mat_mat_mul_bias_relu, fp32::mat_mat_mul_bias_leaky_relu, fp32::mat_mat_mul_bias_op<epi::linear_op>, \
+    fp32::mat_mat_mul_packed, \
+    { fp32::mat_mat_mul_packed_bias_sigmoid, fp32::mat_mat_mul_packed_bias_op<epi::sigmoid_poly_op>, fp32::mat_mat_mul_packed_bias_op<epi::sigmoid_rational_op> }, \
+    { fp32::mat_mat_mul_packed_bias_tanh, fp32::mat_mat_mul_packed_bias_op<epi::tanh_poly_op>, fp32::mat_mat_mul_packed_bias_op<epi::tanh_rational_op> }, \
+    fp32::mat_mat_mul_packed_bias_relu, fp32::mat_mat_mul_packed_bias_leaky_relu, fp32::mat_mat_mul_packed_bias_op<epi::linear_op>, \
+    train::mat_t_mat_mul, train::rank1_update, train::rank_k_update, train::accumulate_rows, \
+    train::mul_derivative_sigmoid, train::mul_derivative_tanh, train::mul_derivative_relu, train::mul_derivative_leaky_relu }
+
+    /*------------------------------detection-------------------------------------*/
+#ifdef SIMD_X86
+    inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
     {
-        return _mm256_mul_ps(m, m);
+#if defined(_MSC_VER) && !defined(__clang__)
+        __cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
     }
 
-    inline float getf(__m256& vec, size_t index) { return *(((float*)&vec) + index); }
-
-    inline float accumulate(float* inVec, size_t count)
+    /* which register states the os saves on context switches */
+    inline uint64_t xgetbv0()
     {
-        __m256 temp = _mm256_setzero_ps();
-        size_t leftover = count % 8;
-
-        for (size_t i = 0; i < (count - leftover); i+=8)
-            temp = _mm256_add_ps(_mm256_loadu_ps(&inVec[i]), temp);
+#if defined(_MSC_VER) && !defined(__clang__)
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (uint64_t(edx) << 32) | eax;
+#endif
+    }
+#endif
 
-        __m128 temp128 = _mm_add_ps(_mm256_castps256_ps128(temp), _mm256_extractf128_ps(temp, 1));
-        __m128 high = _mm_movehl_ps(temp128, temp128);
+    /* the best level both the cpu and the os support */
+    inline isa detect_isa()
+    {
+#ifdef SIMD_X86
+        uint32_t regs[4] = { 0, 0, 0, 0 };
+
+        cpuid(0, 0, regs);
+        const uint32_t maxLeaf = regs[0];
+
+        cpuid(1, 0, regs);
+        const bool ssse3 = regs[2] & (1U << 9);
+        const bool fma = regs[2] & (1U << 12);
+        const bool sse41 = regs[2] & (1U << 19);
+        const bool sse42 = regs[2] & (1U << 20);
+        const bool osxsave = regs[2] & (1U << 27);
+
+        /* ymm (bits 1, 2) and zmm (bits 5, 6, 7) state */
+        const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+        const bool ymmState = (xcr0 & 0x6) == 0x6;
+        const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+        bool avx2 = false, avx512f = false;
+        if (maxLeaf >= 7)
+        {
+            cpuid(7, 0, regs);
+            avx2 = regs[1] & (1U << 5);
+            avx512f = regs[1] & (1U << 16);
+        }
 
-        temp128 = _mm_add_ps(temp128, high);
-        high =  _mm_shuffle_ps(temp128, temp128, 0x1);
+        if (avx512f && avx2 && fma && zmmState)
+            return isa::avx512;
 
-        float mValue = _mm_cvtss_f32(_mm_add_ps(temp128, high));
+        if (avx2 && fma && ymmState)
+            return isa::avx2;
 
-        if (leftover)
-        {
-            size_t offset = count - leftover;
-            for(size_t i = offset; i < count; i++)
-                mValue += inVec[i];
-        }
+        if (sse42 && sse41 && ssse3)
+            return isa::sse42;
+#elif defined(SIMD_NEON)
+        return isa::neon;
+#endif
+        return isa::scalar;
+    }
 
-        return mValue;
+    inline isa supported_isa()
+    {
+        static const isa level = detect_isa();
+        return level;
     }
 
-    inline float accumulate(__m256 inVec)
+    /* scalar always is, the x86 levels are supersets of the ones below them */
+    inline bool is_supported(isa level)
     {
-        __m128 temp128 = _mm_add_ps(_mm256_castps256_ps128(inVec), _mm256_extractf128_ps(inVec, 1));
-        __m128 high = _mm_movehl_ps(temp128, temp128);
+        const isa supported = supported_isa();
 
-        temp128 = _mm_add_ps(temp128, high);
-        high =  _mm_shuffle_ps(temp128, temp128, 0x1);
+        if (level == isa::scalar || level == supported)
+            return true;
 
-        return _mm_cvtss_f32(_mm_add_ps(temp128, high));
+        return supported != isa::neon && level != isa::neon && level < supported;
     }
 
-
-/* std::vector<__m256> will be alligned correctly, this warning does not help */
-#ifdef APP_COMPILER_GNUC
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wignored-attributes"
-#endif
-
-    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    /* the level asked for in NNV_SIMD, or the supported one */
+    inline isa requested_isa()
     {
-        /* n __m256s(8 floats per element) */
-        alignas(64ULL) std::vector<__m256> tempResults(n, _mm256_setzero_ps());
-
-        size_t nLeftover = n % 8;
-        size_t mLeftover = m % 8;
+        const char* value = std::getenv("NNV_SIMD");
+        if (!value)
+            return supported_isa();
 
-        for (size_t i = 0; i < n; i++)
+        for (uint32_t i = 0; i < uint32_t(isa::count); i++)
         {
-            for (size_t j = 0; j < (m - mLeftover); j+=8)
-            {
-                tempResults[i] = _mm256_fmadd_ps(_mm256_loadu_ps(&inVec[j]), _mm256_loadu_ps(&inMatrix[i * m + j]), tempResults[i]);
-            }
-
-            if(mLeftover)
-            {
-                /* fill an array of size 8 with the remaing values followed by 0s */
-                size_t offset = m - mLeftover;
+            if (std::strcmp(value, isa_name(isa(i))) == 0)
+                return is_supported(isa(i)) ? isa(i) : supported_isa();
+        }
 
-                float vecTemp[8] = { 0.0f };
-                float matTemp[8] = { 0.0f };
+        return supported_isa();
+    }
 
+    inline kernel_table make_kernel_table(isa level)
+    {
+#ifdef SIMD_X86
+        switch (level)
+        {
+            case isa::avx512: return SIMD_KERNEL_TABLE(isa::avx512, avx512, avx2, avx2, avx2);
+            case isa::avx2:   return SIMD_KERNEL_TABLE(isa::avx2, avx2, avx2, avx2, avx2);
+            case isa::sse42:  return SIMD_KERNEL_TABLE(isa::sse42, sse42, sse42, sse42, scalar);
+            default: break;
+        }
+#elif defined(SIMD_NEON)
+        if (level == isa::neon)
+            return SIMD_KERNEL_TABLE(isa::neon, neon, neon, neon, scalar);
+#endif
+        return SIMD_KERNEL_TABLE(isa::scalar, scalar, scalar, scalar, scalar);
+    }
 
-                for (size_t k = offset; k < m; k++)
-                {
-                    vecTemp[k - offset] = inVec[k];
-                    matTemp[k - offset] = inMatrix[i * m + k];
-                }
+#undef SIMD_KERNEL_TABLE
 
-                tempResults[i] = _mm256_fmadd_ps(_mm256_loadu_ps(vecTemp), _mm256_loadu_ps(matTemp), tempResults[i]);
-            }
-        }
+    inline kernel_table& kernels()
+    {
+        static kernel_table table = make_kernel_table(requested_isa());
+        return table;
+    }
 
-        for (size_t i = 0, count = 0; i < (n - nLeftover); i += 8, count++)
-        {
-            //reduce 8 to 4
-            __m256 vec_0(_mm256_add_ps(
-                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 1]), _mm256_castps256_ps128(tempResults[i + 0])),
-                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 1], 1), _mm256_extractf128_ps(tempResults[i + 0], 1))));
+    inline isa active_isa() { return kernels().level; }
 
-            __m256 vec_1(_mm256_add_ps(
-                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 3]), _mm256_castps256_ps128(tempResults[i + 2])),
-                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 3], 1), _mm256_extractf128_ps(tempResults[i + 2], 1))));
+    /* rebinds every kernel, returns false (and changes nothing) if the host does not support the level
+     * not thread-safe, only call it while nothing is running kernels
+     */
+    inline bool set_isa(isa level)
+    {
+        if (!is_supported(level))
+            return false;
 
-            __m256 vec_2(_mm256_add_ps(
-                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 5]), _mm256_castps256_ps128(tempResults[i + 4])),
-                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 5], 1), _mm256_extractf128_ps(tempResults[i + 4], 1))));
+        kernels() = make_kernel_table(level);
+        return true;
+    }
 
-            __m256 vec_3(_mm256_add_ps(
-                _mm256_set_m128(_mm256_castps256_ps128(tempResults[i + 7]), _mm256_castps256_ps128(tempResults[i + 6])),
-                _mm256_set_m128(_mm256_extractf128_ps(tempResults[i + 7], 1), _mm256_extractf128_ps(tempResults[i + 6], 1))));
+    /*------------------------------kernels---------------------------------------*/
+    inline float accumulate(const float* inVec, size_t count) { return kernels().accumulate(inVec, count); }
 
-            //reduce 4 to 2
-            __m256 vec_4(_mm256_add_ps(
-                _mm256_setr_ps(getf(vec_0, 0), getf(vec_0, 1), getf(vec_0, 4), getf(vec_0, 5), getf(vec_1, 0), getf(vec_1, 1), getf(vec_1, 4), getf(vec_1, 5)),
-                _mm256_setr_ps(getf(vec_0, 2), getf(vec_0, 3), getf(vec_0, 6), getf(vec_0, 7), getf(vec_1, 2), getf(vec_1, 3), getf(vec_1, 6), getf(vec_1, 7))));
+    /* inMatrix is n rows (one per output) of m weights each, outVec = inMatrix * inVec
+     * register tiled (8 columns per pass over the input) and cache blocked over m for very wide inputs
+     */
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        kernels().vec_mat_mul(inVec, inMatrix, outVec, m, n);
+    }
 
+    /* batched version of vec_mat_mul: outMat[b * outStride + i] = dot(inMat[b * inStride], inMatrix[i * m]) for every sample b
+     * columns are processed in panels that fit in L2, so each weight is read from memory once per batch instead of once per sample
+     */
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_mat_mul(inMat, inMatrix, outMat, m, n, batch, inStride, outStride);
+    }
 
-            __m256 vec_5(_mm256_add_ps(
-                _mm256_setr_ps(getf(vec_2, 0), getf(vec_2, 1), getf(vec_2, 4), getf(vec_2, 5), getf(vec_3, 0), getf(vec_3, 1), getf(vec_3, 4), getf(vec_3, 5)),
-                _mm256_setr_ps(getf(vec_2, 2), getf(vec_2, 3), getf(vec_2, 6), getf(vec_2, 7), getf(vec_3, 2), getf(vec_3, 3), getf(vec_3, 6), getf(vec_3, 7))));
+    inline void set_to_zero(float* inVec, size_t count) { kernels().set_to_zero(inVec, count); }
+    inline void set_range_value(float* inVec, size_t count, float value) { kernels().set_range_value(inVec, count, value); }
 
-            //final values
-             auto final_vector = _mm256_add_ps(
-                _mm256_setr_ps(getf(vec_4, 0), getf(vec_4, 2), getf(vec_4, 4), getf(vec_4, 6), getf(vec_5, 0), getf(vec_5, 2), getf(vec_5, 4), getf(vec_5, 6)),
-                _mm256_setr_ps(getf(vec_4, 1), getf(vec_4, 3), getf(vec_4, 5), getf(vec_4, 7), getf(vec_5, 1), getf(vec_5, 3), getf(vec_5, 5), getf(vec_5, 7)));
+    /* ioVec = ioVec * scale + offset, in place */
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset) { kernels().scale_offset(ioVec, count, scale, offset); }
 
-             _mm256_storeu_ps(&outVec[i], final_vector);
-        }
+    /* quantizes a float vector to 7-bit unsigned values, maddubs multiplies unsigned by signed bytes
+     * and with 7 bits a pair of products (127 * 127 * 2) can never saturate its int16 lane
+     * outVec is padded with zeros up to paddedM
+     */
+    inline int8_input quantize_input(const float* inVec, uint8_t* outVec, size_t m, size_t paddedM)
+    {
+        return kernels().quantize_input(inVec, outVec, m, paddedM);
+    }
 
-        if (nLeftover)
-        {
-            size_t offset = n - nLeftover;
-            for (size_t i = offset; i < n; i++)
-            {
-                outVec[i] = accumulate(tempResults[i]);
-            }
-        }
+    /* quantized vec_mat_mul, inVec comes from quantize_input and every row of inMatrix is paddedM bytes
+     * the dot products are exact in int32, then mapped back to fp32 with the input scale and each row's own scale
+     * rowSums[i] (the sum of row i) removes the input's zero point: dot(q - zp, w) == dot(q, w) - zp * sum(w)
+     */
+    inline void vec_mat_mul_i8(const uint8_t* inVec, int8_input inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outVec, size_t paddedM, size_t n)
+    {
+        kernels().vec_mat_mul_i8(inVec, inParams, inMatrix, rowScales, rowSums, outVec, paddedM, n);
     }
 
-#ifdef APP_COMPILER_GNUC
-#pragma GCC diagnostic pop
-#endif
+    /* batched vec_mat_mul_i8, sample b's quantized input starts at inMat[b * paddedM] and its parameters at inParams[b] */
+    inline void mat_mat_mul_i8(const uint8_t* inMat, const int8_input* inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outMat, size_t paddedM, size_t n, size_t batch, size_t outStride)
+    {
+        kernels().mat_mat_mul_i8(inMat, inParams, inMatrix, rowScales, rowSums, outMat, paddedM, n, batch, outStride);
+    }
 
+    /* outVec[i] = activation(outVec[i] + inBiases[i])
+     * sigmoid and tanh take an activation_accuracy (see simd_common.hpp), the approximations trade error for speed
+     */
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n, activation_accuracy accuracy = activation_accuracy::exact)
+    {
+        kernels().add_bias_sigmoid[size_t(accuracy)](outVec, inBiases, n);
+    }
 
-    inline void set_to_zero(float* inVec, size_t count)
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n, activation_accuracy accuracy = activation_accuracy::exact)
     {
-        size_t leftover = count % 8;
+        kernels().add_bias_tanh[size_t(accuracy)](outVec, inBiases, n);
+    }
 
-        for (size_t i = 0; i < (count - leftover); i+=8)
-            _mm256_storeu_ps(&inVec[i], _mm256_setzero_ps());
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n) { kernels().add_bias_relu(outVec, inBiases, n); }
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha) { kernels().add_bias_leaky_relu(outVec, inBiases, n, alpha); }
 
-        if (leftover)
-        {
-            size_t offset = count - leftover;
-            for (size_t i = offset; i < count; i++)
-                inVec[i] = 0.0f;
-        }
-    }
+    /* bias only, outVec[i] += inBiases[i] */
+    inline void add_bias_linear(float* outVec, const float* inBiases, size_t n) { kernels().add_bias_linear(outVec, inBiases, n); }
 
-    inline void set_range_value(float* inVec, size_t count, float value)
+    /* fused layer: outMat[b * outStride + i] = activation(dot(inMat[b * inStride], inMatrix[i * m]) + inBiases[i])
+     * same kernels as mat_mat_mul, the bias and activation are applied to the dot products in registers before the only store
+     * so a layer takes one pass over its outputs instead of three (gemm store, then load + store in add_bias_*)
+     */
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        activation_accuracy accuracy = activation_accuracy::exact)
     {
-        size_t leftover = count % 8;
-
-        __m256 mValue = _mm256_set1_ps(value);
+        kernels().mat_mat_mul_bias_sigmoid[size_t(accuracy)](inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-        for (size_t i = 0; i < (count - leftover); i+=8)
-            _mm256_storeu_ps(&inVec[i], mValue);
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        activation_accuracy accuracy = activation_accuracy::exact)
+    {
+        kernels().mat_mat_mul_bias_tanh[size_t(accuracy)](inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-        if (leftover)
-        {
-            size_t offset = count - leftover;
-            for (size_t i = offset; i < count; i++)
-                inVec[i] = value;
-        }
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_mat_mul_bias_relu(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
     }
 
-}
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        kernels().mat_mat_mul_bias_leaky_relu(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride, alpha);
+    }
 
-#include "vendor/avx_mathfun.h"
+    inline void mat_mat_mul_bias_linear(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_mat_mul_bias_linear(inMat, inMatrix, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-#if defined(APP_COMPILER_GNUC ) || defined(APP_COMPILER_CLANG)
+    /* mat_mat_mul over weights repacked by pack_weights (see simd_common.hpp), same result and output layout
+     * every input is broadcast against a panel of 16 columns, so there is no horizontal reduction and narrow layers
+     * (m of 8 or 16) keep every fma busy. firstColumn of a slice has to be a multiple of packed_panel_width,
+     * the slice's weights start at inPacked + firstColumn * m
+     */
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_mat_mul_packed(inMat, inPacked, outMat, m, n, batch, inStride, outStride);
+    }
 
-/* _mm256_pow_ps is an intel extension only available on intel and MSVC compilers */
-#define _mm256_pow_ps(a, b) pow_ps(a, b)
-#endif
+    /* fused layer over packed weights, activation(mat_mat_mul_packed + inBiases) */
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        activation_accuracy accuracy = activation_accuracy::exact)
+    {
+        kernels().mat_mat_mul_packed_bias_sigmoid[size_t(accuracy)](inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-#else
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        activation_accuracy accuracy = activation_accuracy::exact)
+    {
+        kernels().mat_mat_mul_packed_bias_tanh[size_t(accuracy)](inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-//TODO: implement NEON intrinsics. for now it will just be serial
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_mat_mul_packed_bias_relu(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-namespace simd {
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        kernels().mat_mat_mul_packed_bias_leaky_relu(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride, alpha);
+    }
 
-    inline float accumulate(float* inVec, size_t count)
+    inline void mat_mat_mul_packed_bias_linear(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
     {
-        float outValue = 0.0f;
-        for(size_t i = 0; i < count; i++)
-            outValue += inVec[i];
+        kernels().mat_mat_mul_packed_bias_linear(inMat, inPacked, inBiases, outMat, m, n, batch, inStride, outStride);
+    }
 
-        return outValue;
+    /*------------------------------backward--------------------------------------*/
+    /* the transposed product of mat_mat_mul over the same row major weights (n rows of m), outMat = inMat * inMatrix
+     * each of the batch rows of inMat holds n values (one per weight row), each row of outMat gets m, overwritten
+     * backpropagates the error of a layer to its inputs without building the transpose
+     */
+    inline void mat_t_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        kernels().mat_t_mat_mul(inMat, inMatrix, outMat, m, n, batch, inStride, outStride);
     }
 
-    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    /* outMatrix[i][j] += inX[i] * inY[j] for the n rows and m columns of a matrix with rows matrixStride apart */
+    inline void rank1_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t matrixStride)
     {
-        for (size_t i = 0; i < n; i++)
-        {
-            float result = 0.0f;
-            for (size_t j = 0; j < m; j++)
-            {
-                result += inVec[j] * inMatrix[i * m + j];
-            }
-            outVec[i] = result;
-        }
+        kernels().rank1_update(inX, inY, outMatrix, m, n, matrixStride);
     }
 
-    inline void set_to_zero(float* inVec, size_t count)
+    /* rank1_update summed over batch pairs of rows (inX + b * xStride, inY + b * yStride), the weight gradient of a minibatch
+     * register tiled over outMatrix, every tile is read and written once however large the batch
+     */
+    inline void rank_k_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t batch, size_t xStride, size_t yStride, size_t matrixStride)
     {
-        for (size_t i = 0; i < count; i++)
-            inVec[i] = 0.0f;
+        kernels().rank_k_update(inX, inY, outMatrix, m, n, batch, xStride, yStride, matrixStride);
     }
 
-    inline void set_range_value(float* inVec, size_t count, float value)
+    /* outVec[i] += sum of inMat[b * inStride + i] over the batch, the bias gradient of a minibatch */
+    inline void accumulate_rows(const float* inMat, float* outVec, size_t n, size_t batch, size_t inStride)
     {
-        for (size_t i = 0; i < count; i++)
-            inVec[i] = value;
+        kernels().accumulate_rows(inMat, outVec, n, batch, inStride);
     }
 
+    /* ioDelta *= f'(z), the derivative written in terms of the activation's cached output y = f(z) */
+    inline void mul_derivative_sigmoid(float* ioDelta, const float* inOutputs, size_t n) { kernels().mul_derivative_sigmoid(ioDelta, inOutputs, n); }
+    inline void mul_derivative_tanh(float* ioDelta, const float* inOutputs, size_t n) { kernels().mul_derivative_tanh(ioDelta, inOutputs, n); }
+    inline void mul_derivative_relu(float* ioDelta, const float* inOutputs, size_t n) { kernels().mul_derivative_relu(ioDelta, inOutputs, n); }
+    inline void mul_derivative_leaky_relu(float* ioDelta, const float* inOutputs, size_t n, float alpha) { kernels().mul_derivative_leaky_relu(ioDelta, inOutputs, n, alpha); }
 }
-
-#endif
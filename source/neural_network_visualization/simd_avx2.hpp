@@ -0,0 +1,1257 @@
+#pragma once
+
+#include "simd_common.hpp"
+
+#ifdef SIMD_X86
+
+#include <immintrin.h>
+
+/* everything in here is compiled for avx2 + fma regardless of the global compiler flags,
+ * the kernel table in simd.hpp only hands these out after cpuid says the host supports them
+ */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "vendor/avx_mathfun.h"
+
+#if defined(APP_COMPILER_GNUC ) || defined(APP_COMPILER_CLANG)
+
+/* _mm256_pow_ps is an intel extension only available on intel and MSVC compilers */
+#define _mm256_pow_ps(a, b) pow_ps(a, b)
+#endif
+
+namespace simd::avx2 {
+
+    inline __m256 pow2_ps(__m256 m)
+    {
+        return _mm256_mul_ps(m, m);
+    }
+
+    inline float getf(__m256& vec, size_t index) { return *(((float*)&vec) + index); }
+
+    inline float accumulate(const float* inVec, size_t count)
+    {
+        __m256 temp = _mm256_setzero_ps();
+        size_t leftover = count % 8;
+
+        for (size_t i = 0; i < (count - leftover); i+=8)
+            temp = _mm256_add_ps(_mm256_loadu_ps(&inVec[i]), temp);
+
+        __m128 temp128 = _mm_add_ps(_mm256_castps256_ps128(temp), _mm256_extractf128_ps(temp, 1));
+        __m128 high = _mm_movehl_ps(temp128, temp128);
+
+        temp128 = _mm_add_ps(temp128, high);
+        high =  _mm_shuffle_ps(temp128, temp128, 0x1);
+
+        float mValue = _mm_cvtss_f32(_mm_add_ps(temp128, high));
+
+        if (leftover)
+        {
+            size_t offset = count - leftover;
+            for(size_t i = offset; i < count; i++)
+                mValue += inVec[i];
+        }
+
+        return mValue;
+    }
+
+    inline float accumulate(__m256 inVec)
+    {
+        __m128 temp128 = _mm_add_ps(_mm256_castps256_ps128(inVec), _mm256_extractf128_ps(inVec, 1));
+        __m128 high = _mm_movehl_ps(temp128, temp128);
+
+        temp128 = _mm_add_ps(temp128, high);
+        high =  _mm_shuffle_ps(temp128, temp128, 0x1);
+
+        return _mm_cvtss_f32(_mm_add_ps(temp128, high));
+    }
+
+
+    /* lanes [0, count) set, the rest cleared. used with maskload/maskstore for the tails */
+    inline __m256i tail_mask(size_t count)
+    {
+        alignas(32) static const int32_t maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+        return _mm256_loadu_si256((const __m256i*)(&maskTable[8 - count]));
+    }
+
+    /* horizontal sum of 4 accumulators, lane i of the result holds the sum of a_i */
+    inline __m128 reduce_4x8(__m256 a0, __m256 a1, __m256 a2, __m256 a3)
+    {
+        __m256 sum = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));
+        return _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    }
+
+    /* horizontal sum of 8 accumulators, lane i of the result holds the sum of a_i */
+    inline __m256 reduce_8x8(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 a4, __m256 a5, __m256 a6, __m256 a7)
+    {
+        /* [a0..a3 low halves | a0..a3 high halves] and the same for a4..a7 */
+        __m256 sum0 = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));
+        __m256 sum1 = _mm256_hadd_ps(_mm256_hadd_ps(a4, a5), _mm256_hadd_ps(a6, a7));
+
+        return _mm256_add_ps(_mm256_permute2f128_ps(sum0, sum1, 0x20), _mm256_permute2f128_ps(sum0, sum1, 0x31));
+    }
+
+    /*------------------------------activation ops--------------------------------*/
+    /* functors rather than lambdas, gcc does not apply the target pragma to lambdas */
+    struct sigmoid_op
+    {
+        __m256 operator()(__m256 x) const
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            return _mm256_div_ps(one, _mm256_add_ps(one, exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+        }
+    };
+
+    /* tanh(x) == (exp(2x) - 1) / (exp(2x) + 1) */
+    struct tanh_op
+    {
+        __m256 operator()(__m256 x) const
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 e = exp256_ps(_mm256_add_ps(x, x));
+            return _mm256_div_ps(_mm256_sub_ps(e, one), _mm256_add_ps(e, one));
+        }
+    };
+
+    struct relu_op
+    {
+        __m256 operator()(__m256 x) const { return _mm256_max_ps(x, _mm256_setzero_ps()); }
+    };
+
+    /* bias only, regression outputs */
+    struct linear_op
+    {
+        __m256 operator()(__m256 x) const { return x; }
+    };
+
+    /* branch free, max(x, 0) + alpha * min(x, 0) */
+    struct leaky_relu_op
+    {
+        __m256 alpha;
+
+        __m256 operator()(__m256 x) const
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            return _mm256_fmadd_ps(alpha, _mm256_min_ps(x, zero), _mm256_max_ps(x, zero));
+        }
+    };
+
+    /*------------------------------approximate activation ops--------------------*/
+    /* 1 / d from the 12 bit estimate and one newton step, r + r * (1 - d * r), in place of the division */
+    inline __m256 rcp_nr_ps(__m256 d)
+    {
+        const __m256 r = _mm256_rcp_ps(d);
+        return _mm256_fmadd_ps(r, _mm256_fnmadd_ps(d, r, _mm256_set1_ps(1.0f)), r);
+    }
+
+    /* see exp_poly in simd_scalar.hpp, 2^round(t) is added straight into the exponent field */
+    inline __m256 exp_poly_ps(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(exp_poly_low)), _mm256_set1_ps(exp_poly_high));
+
+        const __m256 t = _mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f));
+        const __m256 n = _mm256_round_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m256 f = _mm256_sub_ps(t, n);
+
+        __m256 p = _mm256_fmadd_ps(_mm256_set1_ps(exp2_poly[3]), f, _mm256_set1_ps(exp2_poly[2]));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(exp2_poly[1]));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(exp2_poly[0]));
+
+        return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23)));
+    }
+
+    inline __m256 tanh_rational_ps(__m256 x)
+    {
+        const __m256 clamp = _mm256_set1_ps(tanh_rational_clamp);
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_sub_ps(_mm256_setzero_ps(), clamp)), clamp);
+
+        const __m256 x2 = _mm256_mul_ps(x, x);
+
+        __m256 p = _mm256_set1_ps(tanh_rational_p[6]);
+        for (int i = 5; i >= 0; i--)
+            p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(tanh_rational_p[i]));
+
+        __m256 q = _mm256_set1_ps(tanh_rational_q[3]);
+        for (int i = 2; i >= 0; i--)
+            q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(tanh_rational_q[i]));
+
+        return _mm256_mul_ps(_mm256_mul_ps(x, p), rcp_nr_ps(q));
+    }
+
+    struct sigmoid_poly_op
+    {
+        __m256 operator()(__m256 x) const
+        {
+            return rcp_nr_ps(_mm256_add_ps(_mm256_set1_ps(1.0f), exp_poly_ps(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+        }
+    };
+
+    /* tanh(x) == 1 - 2 / (exp(2x) + 1) */
+    struct tanh_poly_op
+    {
+        __m256 operator()(__m256 x) const
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            return _mm256_fnmadd_ps(_mm256_set1_ps(2.0f), rcp_nr_ps(_mm256_add_ps(one, exp_poly_ps(_mm256_add_ps(x, x)))), one);
+        }
+    };
+
+    /* sigmoid(x) == 0.5 + 0.5 * tanh(x / 2) */
+    struct sigmoid_rational_op
+    {
+        __m256 operator()(__m256 x) const
+        {
+            const __m256 half = _mm256_set1_ps(0.5f);
+            return _mm256_fmadd_ps(half, tanh_rational_ps(_mm256_mul_ps(half, x)), half);
+        }
+    };
+
+    struct tanh_rational_op
+    {
+        __m256 operator()(__m256 x) const { return tanh_rational_ps(x); }
+    };
+
+    /*------------------------------epilogues-------------------------------------*/
+    /* what the gemv/gemm kernels do to the finished dot products of columns [i, i + lanes) right before storing them */
+    struct no_epilogue
+    {
+        __m256 operator()(__m256 x, size_t) const { return x; }
+        __m128 operator()(__m128 x, size_t) const { return x; }
+        float operator()(float x, size_t) const { return x; }
+    };
+
+    /* bias and activation in registers, so a layer is written once instead of written, read back and written again
+     * the 4 and 1 column tails are broadcast into a full register and the extra lanes discarded
+     */
+    template<typename Op>
+    struct bias_epilogue
+    {
+        const float* biases;
+        Op op;
+
+        __m256 operator()(__m256 x, size_t i) const { return op(_mm256_add_ps(x, _mm256_loadu_ps(&biases[i]))); }
+
+        __m128 operator()(__m128 x, size_t i) const
+        {
+            x = _mm_add_ps(x, _mm_loadu_ps(&biases[i]));
+            return _mm256_castps256_ps128(op(_mm256_set_m128(x, x)));
+        }
+
+        float operator()(float x, size_t i) const { return _mm256_cvtss_f32(op(_mm256_set1_ps(x + biases[i]))); }
+    };
+
+    /* outVec[i] (+)= dot(inVec, inMatrix[i * m]) for the columns [0, n) over the inputs [0, count), then epilogue */
+    template<typename Epilogue = no_epilogue>
+    inline void vec_mat_mul_block(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, size_t count, bool accumulateOutput,
+        Epilogue epilogue = Epilogue{})
+    {
+        const size_t leftover = count % 8;
+        const size_t end = count - leftover;
+        const __m256i mask = tail_mask(leftover);
+
+        size_t i = 0;
+
+        /* 8 columns per pass, every input load feeds 8 fmas */
+        for (; i + 8 <= n; i += 8)
+        {
+            const float* w = &inMatrix[i * m];
+
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+            __m256 acc4 = _mm256_setzero_ps(), acc5 = _mm256_setzero_ps(), acc6 = _mm256_setzero_ps(), acc7 = _mm256_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 8)
+            {
+                const __m256 x = _mm256_loadu_ps(&inVec[j]);
+                acc0 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[0 * m + j]), acc0);
+                acc1 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[1 * m + j]), acc1);
+                acc2 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[2 * m + j]), acc2);
+                acc3 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[3 * m + j]), acc3);
+                acc4 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[4 * m + j]), acc4);
+                acc5 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[5 * m + j]), acc5);
+                acc6 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[6 * m + j]), acc6);
+                acc7 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[7 * m + j]), acc7);
+            }
+
+            if (leftover)
+            {
+                const __m256 x = _mm256_maskload_ps(&inVec[end], mask);
+                acc0 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[0 * m + end], mask), acc0);
+                acc1 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[1 * m + end], mask), acc1);
+                acc2 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[2 * m + end], mask), acc2);
+                acc3 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[3 * m + end], mask), acc3);
+                acc4 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[4 * m + end], mask), acc4);
+                acc5 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[5 * m + end], mask), acc5);
+                acc6 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[6 * m + end], mask), acc6);
+                acc7 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[7 * m + end], mask), acc7);
+            }
+
+            __m256 result = reduce_8x8(acc0, acc1, acc2, acc3, acc4, acc5, acc6, acc7);
+
+            if (accumulateOutput)
+                result = _mm256_add_ps(result, _mm256_loadu_ps(&outVec[i]));
+
+            _mm256_storeu_ps(&outVec[i], epilogue(result, i));
+        }
+
+        /* 4 columns */
+        for (; i + 4 <= n; i += 4)
+        {
+            const float* w = &inMatrix[i * m];
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 8)
+            {
+                const __m256 x = _mm256_loadu_ps(&inVec[j]);
+                acc0 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[0 * m + j]), acc0);
+                acc1 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[1 * m + j]), acc1);
+                acc2 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[2 * m + j]), acc2);
+                acc3 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&w[3 * m + j]), acc3);
+            }
+
+            if (leftover)
+            {
+                const __m256 x = _mm256_maskload_ps(&inVec[end], mask);
+                acc0 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[0 * m + end], mask), acc0);
+                acc1 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[1 * m + end], mask), acc1);
+                acc2 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[2 * m + end], mask), acc2);
+                acc3 = _mm256_fmadd_ps(x, _mm256_maskload_ps(&w[3 * m + end], mask), acc3);
+            }
+
+            __m128 result = reduce_4x8(acc0, acc1, acc2, acc3);
+
+            if (accumulateOutput)
+                result = _mm_add_ps(result, _mm_loadu_ps(&outVec[i]));
+
+            _mm_storeu_ps(&outVec[i], epilogue(result, i));
+        }
+
+        /* remaining 1 to 3 columns */
+        for (; i < n; i++)
+        {
+            const float* w = &inMatrix[i * m];
+            __m256 acc = _mm256_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 8)
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(&inVec[j]), _mm256_loadu_ps(&w[j]), acc);
+
+            if (leftover)
+                acc = _mm256_fmadd_ps(_mm256_maskload_ps(&inVec[end], mask), _mm256_maskload_ps(&w[end], mask), acc);
+
+            float result = accumulate(acc);
+            outVec[i] = epilogue(accumulateOutput ? outVec[i] + result : result, i);
+        }
+    }
+
+    /* the epilogue only runs with the last block, once the dot products are complete */
+    template<typename Epilogue>
+    inline void vec_mat_mul_apply(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, Epilogue epilogue)
+    {
+        for (size_t k = 0; k < m; k += gemv_block_size)
+        {
+            size_t count = std::min(gemv_block_size, m - k);
+
+            if (k + count == m)
+                vec_mat_mul_block(&inVec[k], &inMatrix[k], outVec, m, n, count, k != 0, epilogue);
+            else
+                vec_mat_mul_block(&inVec[k], &inMatrix[k], outVec, m, n, count, k != 0);
+        }
+    }
+
+    /* inMatrix is n rows (one per output) of m weights each, outVec = inMatrix * inVec
+     * register tiled (8 columns per pass over the input) and cache blocked over m for very wide inputs
+     */
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, no_epilogue{});
+    }
+
+    /* one sample against 4 columns, returns the 4 dot products */
+    inline __m128 dot_1x4(const float* x, const float* w, size_t m, size_t end, size_t leftover, __m256i mask)
+    {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+        for (size_t j = 0; j < end; j += 8)
+        {
+            const __m256 in = _mm256_loadu_ps(&x[j]);
+            acc0 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[0 * m + j]), acc0);
+            acc1 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[1 * m + j]), acc1);
+            acc2 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[2 * m + j]), acc2);
+            acc3 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[3 * m + j]), acc3);
+        }
+
+        if (leftover)
+        {
+            const __m256 in = _mm256_maskload_ps(&x[end], mask);
+            acc0 = _mm256_fmadd_ps(in, _mm256_maskload_ps(&w[0 * m + end], mask), acc0);
+            acc1 = _mm256_fmadd_ps(in, _mm256_maskload_ps(&w[1 * m + end], mask), acc1);
+            acc2 = _mm256_fmadd_ps(in, _mm256_maskload_ps(&w[2 * m + end], mask), acc2);
+            acc3 = _mm256_fmadd_ps(in, _mm256_maskload_ps(&w[3 * m + end], mask), acc3);
+        }
+
+        return reduce_4x8(acc0, acc1, acc2, acc3);
+    }
+
+    /* one sample against one column */
+    inline float dot_1x1(const float* x, const float* w, size_t end, size_t leftover, __m256i mask)
+    {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (size_t j = 0; j < end; j += 8)
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(&x[j]), _mm256_loadu_ps(&w[j]), acc);
+
+        if (leftover)
+            acc = _mm256_fmadd_ps(_mm256_maskload_ps(&x[end], mask), _mm256_maskload_ps(&w[end], mask), acc);
+
+        return accumulate(acc);
+    }
+
+    /* batched version of vec_mat_mul: outMat[b * outStride + i] = dot(inMat[b * inStride], inMatrix[i * m]) for every sample b
+     * columns are processed in panels that fit in L2, so each weight is read from memory once per batch instead of once per sample
+     * the micro kernel computes 2 samples x 4 columns per pass (8 accumulators, every weight load feeds 2 fmas)
+     * a single sample goes through the gemv kernel instead, its 8 column tile does better without a second sample to share the loads
+     */
+    template<typename Epilogue>
+    inline void mat_mat_mul_apply(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        if (batch == 1)
+        {
+            vec_mat_mul_apply(inMat, inMatrix, outMat, m, n, epilogue);
+            return;
+        }
+
+        const size_t leftover = m % 8;
+        const size_t end = m - leftover;
+        const __m256i mask = tail_mask(leftover);
+
+        const size_t panelColumns = std::max<size_t>(4ULL, (gemm_panel_size / std::max<size_t>(m, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t panelEnd = std::min(n, p + panelColumns);
+
+            size_t b = 0;
+            for (; b + 2 <= batch; b += 2)
+            {
+                const float* x0 = &inMat[b * inStride];
+                const float* x1 = &inMat[(b + 1) * inStride];
+                float* out0 = &outMat[b * outStride];
+                float* out1 = &outMat[(b + 1) * outStride];
+
+                size_t i = p;
+                for (; i + 4 <= panelEnd; i += 4)
+                {
+                    const float* w = &inMatrix[i * m];
+
+                    __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a02 = _mm256_setzero_ps(), a03 = _mm256_setzero_ps();
+                    __m256 a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps(), a12 = _mm256_setzero_ps(), a13 = _mm256_setzero_ps();
+
+                    for (size_t j = 0; j < end; j += 8)
+                    {
+                        const __m256 in0 = _mm256_loadu_ps(&x0[j]);
+                        const __m256 in1 = _mm256_loadu_ps(&x1[j]);
+
+                        __m256 wv = _mm256_loadu_ps(&w[0 * m + j]);
+                        a00 = _mm256_fmadd_ps(in0, wv, a00); a10 = _mm256_fmadd_ps(in1, wv, a10);
+
+                        wv = _mm256_loadu_ps(&w[1 * m + j]);
+                        a01 = _mm256_fmadd_ps(in0, wv, a01); a11 = _mm256_fmadd_ps(in1, wv, a11);
+
+                        wv = _mm256_loadu_ps(&w[2 * m + j]);
+                        a02 = _mm256_fmadd_ps(in0, wv, a02); a12 = _mm256_fmadd_ps(in1, wv, a12);
+
+                        wv = _mm256_loadu_ps(&w[3 * m + j]);
+                        a03 = _mm256_fmadd_ps(in0, wv, a03); a13 = _mm256_fmadd_ps(in1, wv, a13);
+                    }
+
+                    if (leftover)
+                    {
+                        const __m256 in0 = _mm256_maskload_ps(&x0[end], mask);
+                        const __m256 in1 = _mm256_maskload_ps(&x1[end], mask);
+
+                        __m256 wv = _mm256_maskload_ps(&w[0 * m + end], mask);
+                        a00 = _mm256_fmadd_ps(in0, wv, a00); a10 = _mm256_fmadd_ps(in1, wv, a10);
+
+                        wv = _mm256_maskload_ps(&w[1 * m + end], mask);
+                        a01 = _mm256_fmadd_ps(in0, wv, a01); a11 = _mm256_fmadd_ps(in1, wv, a11);
+
+                        wv = _mm256_maskload_ps(&w[2 * m + end], mask);
+                        a02 = _mm256_fmadd_ps(in0, wv, a02); a12 = _mm256_fmadd_ps(in1, wv, a12);
+
+                        wv = _mm256_maskload_ps(&w[3 * m + end], mask);
+                        a03 = _mm256_fmadd_ps(in0, wv, a03); a13 = _mm256_fmadd_ps(in1, wv, a13);
+                    }
+
+                    _mm_storeu_ps(&out0[i], epilogue(reduce_4x8(a00, a01, a02, a03), i));
+                    _mm_storeu_ps(&out1[i], epilogue(reduce_4x8(a10, a11, a12, a13), i));
+                }
+
+                for (; i < panelEnd; i++)
+                {
+                    out0[i] = epilogue(dot_1x1(x0, &inMatrix[i * m], end, leftover, mask), i);
+                    out1[i] = epilogue(dot_1x1(x1, &inMatrix[i * m], end, leftover, mask), i);
+                }
+            }
+
+            /* odd sample */
+            if (b < batch)
+            {
+                const float* x = &inMat[b * inStride];
+                float* out = &outMat[b * outStride];
+
+                size_t i = p;
+                for (; i + 4 <= panelEnd; i += 4)
+                    _mm_storeu_ps(&out[i], epilogue(dot_1x4(x, &inMatrix[i * m], m, end, leftover, mask), i));
+
+                for (; i < panelEnd; i++)
+                    out[i] = epilogue(dot_1x1(x, &inMatrix[i * m], end, leftover, mask), i);
+            }
+        }
+    }
+
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    /*------------------------------packed weights--------------------------------*/
+    /* the 16 results of one panel into outVec[i, i + 16), the last panel of a layer that is not a whole number of panels
+     * goes through the epilogue column by column, it must not read biases past n
+     */
+    template<typename Epilogue>
+    inline void store_panel(float* outVec, __m256 lo, __m256 hi, size_t i, size_t n, Epilogue epilogue)
+    {
+        if (i + packed_panel_width <= n)
+        {
+            _mm256_storeu_ps(&outVec[i], epilogue(lo, i));
+            _mm256_storeu_ps(&outVec[i + 8], epilogue(hi, i + 8));
+            return;
+        }
+
+        alignas(32) float tile[packed_panel_width];
+        _mm256_store_ps(tile, lo);
+        _mm256_store_ps(tile + 8, hi);
+
+        for (size_t c = 0; c < n - i; c++)
+            outVec[i + c] = epilogue(tile[c], i + c);
+    }
+
+    /* 6 samples against the panel starting at column i (12 accumulators, the 2 weight registers and a broadcast make 15)
+     * every weight load feeds 6 fmas and there is nothing to reduce at the end
+     */
+    template<typename Epilogue>
+    inline void packed_6x1(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t i, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+
+        __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+        __m256 a20 = _mm256_setzero_ps(), a21 = _mm256_setzero_ps(), a30 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+        __m256 a40 = _mm256_setzero_ps(), a41 = _mm256_setzero_ps(), a50 = _mm256_setzero_ps(), a51 = _mm256_setzero_ps();
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const __m256 w0 = _mm256_loadu_ps(&w[j * packed_panel_width]);
+            const __m256 w1 = _mm256_loadu_ps(&w[j * packed_panel_width + 8]);
+            const float* x = &inMat[j];
+
+            __m256 in = _mm256_broadcast_ss(&x[0 * inStride]);
+            a00 = _mm256_fmadd_ps(in, w0, a00); a01 = _mm256_fmadd_ps(in, w1, a01);
+
+            in = _mm256_broadcast_ss(&x[1 * inStride]);
+            a10 = _mm256_fmadd_ps(in, w0, a10); a11 = _mm256_fmadd_ps(in, w1, a11);
+
+            in = _mm256_broadcast_ss(&x[2 * inStride]);
+            a20 = _mm256_fmadd_ps(in, w0, a20); a21 = _mm256_fmadd_ps(in, w1, a21);
+
+            in = _mm256_broadcast_ss(&x[3 * inStride]);
+            a30 = _mm256_fmadd_ps(in, w0, a30); a31 = _mm256_fmadd_ps(in, w1, a31);
+
+            in = _mm256_broadcast_ss(&x[4 * inStride]);
+            a40 = _mm256_fmadd_ps(in, w0, a40); a41 = _mm256_fmadd_ps(in, w1, a41);
+
+            in = _mm256_broadcast_ss(&x[5 * inStride]);
+            a50 = _mm256_fmadd_ps(in, w0, a50); a51 = _mm256_fmadd_ps(in, w1, a51);
+        }
+
+        store_panel(&outMat[0 * outStride], a00, a01, i, n, epilogue);
+        store_panel(&outMat[1 * outStride], a10, a11, i, n, epilogue);
+        store_panel(&outMat[2 * outStride], a20, a21, i, n, epilogue);
+        store_panel(&outMat[3 * outStride], a30, a31, i, n, epilogue);
+        store_panel(&outMat[4 * outStride], a40, a41, i, n, epilogue);
+        store_panel(&outMat[5 * outStride], a50, a51, i, n, epilogue);
+    }
+
+    /* one sample against the 4 whole panels starting at column i, every input broadcast feeds 8 fmas */
+    template<typename Epilogue>
+    inline void packed_1x4(const float* inVec, const float* inPacked, float* outVec, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w0 = &inPacked[i * m];
+        const float* w1 = w0 + m * packed_panel_width;
+        const float* w2 = w1 + m * packed_panel_width;
+        const float* w3 = w2 + m * packed_panel_width;
+
+        __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+        __m256 a20 = _mm256_setzero_ps(), a21 = _mm256_setzero_ps(), a30 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const __m256 in = _mm256_broadcast_ss(&inVec[j]);
+            const size_t k = j * packed_panel_width;
+
+            a00 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w0[k]), a00); a01 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w0[k + 8]), a01);
+            a10 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w1[k]), a10); a11 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w1[k + 8]), a11);
+            a20 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w2[k]), a20); a21 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w2[k + 8]), a21);
+            a30 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w3[k]), a30); a31 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w3[k + 8]), a31);
+        }
+
+        store_panel(outVec, a00, a01, i, n, epilogue);
+        store_panel(outVec, a10, a11, i + 1 * packed_panel_width, n, epilogue);
+        store_panel(outVec, a20, a21, i + 2 * packed_panel_width, n, epilogue);
+        store_panel(outVec, a30, a31, i + 3 * packed_panel_width, n, epilogue);
+    }
+
+    /* one sample against one panel, even and odd inputs go to separate accumulators to keep 4 fma chains in flight */
+    template<typename Epilogue>
+    inline void packed_1x1(const float* inVec, const float* inPacked, float* outVec, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+
+        __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+
+        size_t j = 0;
+        for (; j + 2 <= m; j += 2)
+        {
+            const __m256 in0 = _mm256_broadcast_ss(&inVec[j]);
+            const __m256 in1 = _mm256_broadcast_ss(&inVec[j + 1]);
+            const size_t k = j * packed_panel_width;
+
+            a00 = _mm256_fmadd_ps(in0, _mm256_loadu_ps(&w[k]), a00);
+            a01 = _mm256_fmadd_ps(in0, _mm256_loadu_ps(&w[k + 8]), a01);
+            a10 = _mm256_fmadd_ps(in1, _mm256_loadu_ps(&w[k + 16]), a10);
+            a11 = _mm256_fmadd_ps(in1, _mm256_loadu_ps(&w[k + 24]), a11);
+        }
+
+        if (j < m)
+        {
+            const __m256 in = _mm256_broadcast_ss(&inVec[j]);
+            a00 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[j * packed_panel_width]), a00);
+            a01 = _mm256_fmadd_ps(in, _mm256_loadu_ps(&w[j * packed_panel_width + 8]), a01);
+        }
+
+        store_panel(outVec, _mm256_add_ps(a00, a10), _mm256_add_ps(a01, a11), i, n, epilogue);
+    }
+
+    /* same contract as mat_mat_mul with inPacked from pack_weights
+     * groups of 6 samples go through every panel while it is in cache (m * 64 bytes), the rest of the batch one sample at a time
+     */
+    template<typename Epilogue>
+    inline void mat_mat_mul_packed_apply(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const size_t groupEnd = batch - batch % 6;
+
+        for (size_t i = 0; i < n && groupEnd; i += packed_panel_width)
+        {
+            for (size_t b = 0; b < groupEnd; b += 6)
+                packed_6x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, inStride, outStride, epilogue);
+        }
+
+        for (size_t b = groupEnd; b < batch; b++)
+        {
+            const float* x = &inMat[b * inStride];
+            float* out = &outMat[b * outStride];
+
+            size_t i = 0;
+            for (; i + 4 * packed_panel_width <= n; i += 4 * packed_panel_width)
+                packed_1x4(x, inPacked, out, m, n, i, epilogue);
+
+            for (; i < n; i += packed_panel_width)
+                packed_1x1(x, inPacked, out, m, n, i, epilogue);
+        }
+    }
+
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    /*------------------------------int8------------------------------------------*/
+    inline int8_input quantize_input(const float* inVec, uint8_t* outVec, size_t m, size_t paddedM)
+    {
+        const size_t leftover = m % 8;
+        const size_t end = m - leftover;
+
+        __m256 minValue = _mm256_setzero_ps(), maxValue = _mm256_setzero_ps();
+        for (size_t j = 0; j < end; j += 8)
+        {
+            const __m256 in = _mm256_loadu_ps(&inVec[j]);
+            minValue = _mm256_min_ps(minValue, in);
+            maxValue = _mm256_max_ps(maxValue, in);
+        }
+
+        float low = 0.0f, high = 0.0f;
+        for (size_t j = 0; j < 8; j++)
+        {
+            low = std::min(low, getf(minValue, j));
+            high = std::max(high, getf(maxValue, j));
+        }
+
+        for (size_t j = end; j < m; j++)
+        {
+            low = std::min(low, inVec[j]);
+            high = std::max(high, inVec[j]);
+        }
+
+        int8_input params = int8_input_params(low, high);
+
+        const float inverseScale = 1.0f / params.scale;
+        const __m256 mInverseScale = _mm256_set1_ps(inverseScale);
+        const __m256i zeroPoint = _mm256_set1_epi32(params.zero_point);
+        const __m256i minQ = _mm256_setzero_si256(), maxQ = _mm256_set1_epi32(127);
+
+        for (size_t j = 0; j < end; j += 8)
+        {
+            /* round to nearest, shift and clamp, then narrow 8 int32 down to 8 bytes */
+            __m256i q = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inVec[j]), mInverseScale)), zeroPoint);
+            q = _mm256_min_epi32(_mm256_max_epi32(q, minQ), maxQ);
+
+            __m128i q16 = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+            _mm_storel_epi64((__m128i*)&outVec[j], _mm_packus_epi16(q16, q16));
+        }
+
+        for (size_t j = end; j < m; j++)
+            outVec[j] = quantize_value(inVec[j], inverseScale, params.zero_point);
+
+        for (size_t j = m; j < paddedM; j++)
+            outVec[j] = 0;
+
+        return params;
+    }
+
+    /* 32 unsigned x 32 signed bytes, summed pairwise into int16 by maddubs then into 8 int32 lanes by madd */
+    inline __m256i dot_i8(__m256i x, const int8_t* w, __m256i acc)
+    {
+        const __m256i products = _mm256_maddubs_epi16(x, _mm256_loadu_si256((const __m256i*)w));
+        return _mm256_add_epi32(acc, _mm256_madd_epi16(products, _mm256_set1_epi16(1)));
+    }
+
+    inline void vec_mat_mul_i8(const uint8_t* inVec, int8_input inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outVec, size_t paddedM, size_t n)
+    {
+        const __m128 inScale = _mm_set1_ps(inParams.scale);
+        const __m128i zeroPoint = _mm_set1_epi32(inParams.zero_point);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const int8_t* w = &inMatrix[i * paddedM];
+            __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256(), acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+
+            for (size_t j = 0; j < paddedM; j += 32)
+            {
+                const __m256i x = _mm256_loadu_si256((const __m256i*)&inVec[j]);
+                acc0 = dot_i8(x, &w[0 * paddedM + j], acc0);
+                acc1 = dot_i8(x, &w[1 * paddedM + j], acc1);
+                acc2 = dot_i8(x, &w[2 * paddedM + j], acc2);
+                acc3 = dot_i8(x, &w[3 * paddedM + j], acc3);
+            }
+
+            /* same shuffle as reduce_4x8, one int32 total per column */
+            __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(acc0, acc1), _mm256_hadd_epi32(acc2, acc3));
+            __m128i dots = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+            dots = _mm_sub_epi32(dots, _mm_mullo_epi32(zeroPoint, _mm_loadu_si128((const __m128i*)&rowSums[i])));
+
+            __m128 scales = _mm_mul_ps(_mm_loadu_ps(&rowScales[i]), inScale);
+            _mm_storeu_ps(&outVec[i], _mm_mul_ps(_mm_cvtepi32_ps(dots), scales));
+        }
+
+        for (; i < n; i++)
+        {
+            const int8_t* w = &inMatrix[i * paddedM];
+            __m256i acc = _mm256_setzero_si256();
+
+            for (size_t j = 0; j < paddedM; j += 32)
+                acc = dot_i8(_mm256_loadu_si256((const __m256i*)&inVec[j]), &w[j], acc);
+
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum = _mm_hadd_epi32(sum, sum);
+            sum = _mm_hadd_epi32(sum, sum);
+
+            int32_t dot = _mm_cvtsi128_si32(sum) - inParams.zero_point * rowSums[i];
+            outVec[i] = float(dot) * inParams.scale * rowScales[i];
+        }
+    }
+
+    /* batched vec_mat_mul_i8, sample b's quantized input starts at inMat[b * paddedM] and its parameters at inParams[b] */
+    inline void mat_mat_mul_i8(const uint8_t* inMat, const int8_input* inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outMat, size_t paddedM, size_t n, size_t batch, size_t outStride)
+    {
+        const size_t panelColumns = std::max<size_t>(4ULL, (int8_panel_size / std::max<size_t>(paddedM, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t count = std::min(n - p, panelColumns);
+
+            for (size_t b = 0; b < batch; b++)
+                vec_mat_mul_i8(&inMat[b * paddedM], inParams[b], &inMatrix[p * paddedM], &rowScales[p], &rowSums[p], &outMat[b * outStride + p], paddedM, count);
+        }
+    }
+
+    inline void set_to_zero(float* inVec, size_t count)
+    {
+        size_t leftover = count % 8;
+
+        for (size_t i = 0; i < (count - leftover); i+=8)
+            _mm256_storeu_ps(&inVec[i], _mm256_setzero_ps());
+
+        if (leftover)
+        {
+            size_t offset = count - leftover;
+            for (size_t i = offset; i < count; i++)
+                inVec[i] = 0.0f;
+        }
+    }
+
+    inline void set_range_value(float* inVec, size_t count, float value)
+    {
+        size_t leftover = count % 8;
+
+        __m256 mValue = _mm256_set1_ps(value);
+
+        for (size_t i = 0; i < (count - leftover); i+=8)
+            _mm256_storeu_ps(&inVec[i], mValue);
+
+        if (leftover)
+        {
+            size_t offset = count - leftover;
+            for (size_t i = offset; i < count; i++)
+                inVec[i] = value;
+        }
+    }
+
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset)
+    {
+        const size_t leftover = count % 8;
+        const __m256 mScale = _mm256_set1_ps(scale), mOffset = _mm256_set1_ps(offset);
+
+        for (size_t i = 0; i < (count - leftover); i+=8)
+            _mm256_storeu_ps(&ioVec[i], _mm256_fmadd_ps(_mm256_loadu_ps(&ioVec[i]), mScale, mOffset));
+
+        if (leftover)
+        {
+            const size_t tail = count - leftover;
+            const __m256i mask = tail_mask(leftover);
+            _mm256_maskstore_ps(&ioVec[tail], mask, _mm256_fmadd_ps(_mm256_maskload_ps(&ioVec[tail], mask), mScale, mOffset));
+        }
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    /* applies op to outVec + inBiases 8 lanes at a time, the tail with masked loads and stores */
+    template<typename Op>
+    inline void add_bias_apply(float* outVec, const float* inBiases, size_t n, Op op)
+    {
+        const size_t leftover = n % 8;
+
+        for (size_t i = 0; i < (n - leftover); i+=8)
+            _mm256_storeu_ps(&outVec[i], op(_mm256_add_ps(_mm256_loadu_ps(&outVec[i]), _mm256_loadu_ps(&inBiases[i]))));
+
+        if (leftover)
+        {
+            const size_t offset = n - leftover;
+            const __m256i mask = tail_mask(leftover);
+
+            __m256 sum = _mm256_add_ps(_mm256_maskload_ps(&outVec[offset], mask), _mm256_maskload_ps(&inBiases[offset], mask));
+            _mm256_maskstore_ps(&outVec[offset], mask, op(sum));
+        }
+    }
+
+    /* the tails go through the same ops with masked loads and stores, so every lane computes the same function */
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, sigmoid_op{}); }
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, tanh_op{}); }
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, relu_op{}); }
+
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha)
+    {
+        add_bias_apply(outVec, inBiases, n, leaky_relu_op{ _mm256_set1_ps(alpha) });
+    }
+
+    /* add_bias_* for any stateless op, how the kernel table binds the approximate sigmoid and tanh */
+    template<typename Op>
+    inline void add_bias_op(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, Op{}); }
+
+    /*------------------------------fused layer-----------------------------------*/
+    /* outMat = activation(inMat * inMatrix + inBiases), see mat_mat_mul for the layout */
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { _mm256_set1_ps(alpha) } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_bias_op(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------fused layer, packed weights-------------------*/
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { _mm256_set1_ps(alpha) } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_packed_bias_op(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------backward--------------------------------------*/
+    /* whole registers with plain loads and stores, the columns past the end of a row with masked ones */
+    template<bool Tail>
+    inline __m256 load_columns(const float* inVec, __m256i mask)
+    {
+        if constexpr (Tail)
+            return _mm256_maskload_ps(inVec, mask);
+        else
+            return _mm256_loadu_ps(inVec);
+    }
+
+    template<bool Tail>
+    inline void store_columns(float* outVec, __m256i mask, __m256 value)
+    {
+        if constexpr (Tail)
+            _mm256_maskstore_ps(outVec, mask, value);
+        else
+            _mm256_storeu_ps(outVec, value);
+    }
+
+    /* 4 samples against columns [j, j + 16) of the output (8 accumulators), the tile stays in registers while i runs over all of n
+     * every weight load feeds 4 fmas and inMatrix is walked row after row, the transpose is never built
+     */
+    template<bool Tail>
+    inline void mat_t_4x16(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t j, size_t inStride, size_t outStride,
+        __m256i mask0, __m256i mask1)
+    {
+        __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+        __m256 a20 = _mm256_setzero_ps(), a21 = _mm256_setzero_ps(), a30 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const float* w = &inMatrix[i * m + j];
+            const __m256 w0 = load_columns<Tail>(w, mask0);
+            const __m256 w1 = load_columns<Tail>(w + 8, mask1);
+            const float* x = &inMat[i];
+
+            __m256 in = _mm256_broadcast_ss(&x[0 * inStride]);
+            a00 = _mm256_fmadd_ps(in, w0, a00); a01 = _mm256_fmadd_ps(in, w1, a01);
+
+            in = _mm256_broadcast_ss(&x[1 * inStride]);
+            a10 = _mm256_fmadd_ps(in, w0, a10); a11 = _mm256_fmadd_ps(in, w1, a11);
+
+            in = _mm256_broadcast_ss(&x[2 * inStride]);
+            a20 = _mm256_fmadd_ps(in, w0, a20); a21 = _mm256_fmadd_ps(in, w1, a21);
+
+            in = _mm256_broadcast_ss(&x[3 * inStride]);
+            a30 = _mm256_fmadd_ps(in, w0, a30); a31 = _mm256_fmadd_ps(in, w1, a31);
+        }
+
+        store_columns<Tail>(&outMat[0 * outStride + j], mask0, a00); store_columns<Tail>(&outMat[0 * outStride + j + 8], mask1, a01);
+        store_columns<Tail>(&outMat[1 * outStride + j], mask0, a10); store_columns<Tail>(&outMat[1 * outStride + j + 8], mask1, a11);
+        store_columns<Tail>(&outMat[2 * outStride + j], mask0, a20); store_columns<Tail>(&outMat[2 * outStride + j + 8], mask1, a21);
+        store_columns<Tail>(&outMat[3 * outStride + j], mask0, a30); store_columns<Tail>(&outMat[3 * outStride + j + 8], mask1, a31);
+    }
+
+    /* one sample against columns [j, j + 16), even and odd rows go to separate accumulators to keep 4 fma chains in flight */
+    template<bool Tail>
+    inline void mat_t_1x16(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, size_t j, __m256i mask0, __m256i mask1)
+    {
+        __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2)
+        {
+            const float* w = &inMatrix[i * m + j];
+            const __m256 in0 = _mm256_broadcast_ss(&inVec[i]);
+            const __m256 in1 = _mm256_broadcast_ss(&inVec[i + 1]);
+
+            a00 = _mm256_fmadd_ps(in0, load_columns<Tail>(w, mask0), a00);
+            a01 = _mm256_fmadd_ps(in0, load_columns<Tail>(w + 8, mask1), a01);
+            a10 = _mm256_fmadd_ps(in1, load_columns<Tail>(w + m, mask0), a10);
+            a11 = _mm256_fmadd_ps(in1, load_columns<Tail>(w + m + 8, mask1), a11);
+        }
+
+        if (i < n)
+        {
+            const float* w = &inMatrix[i * m + j];
+            const __m256 in = _mm256_broadcast_ss(&inVec[i]);
+
+            a00 = _mm256_fmadd_ps(in, load_columns<Tail>(w, mask0), a00);
+            a01 = _mm256_fmadd_ps(in, load_columns<Tail>(w + 8, mask1), a01);
+        }
+
+        store_columns<Tail>(&outVec[j], mask0, _mm256_add_ps(a00, a10));
+        store_columns<Tail>(&outVec[j + 8], mask1, _mm256_add_ps(a01, a11));
+    }
+
+    /* groups of 4 samples go through every 16 column strip of the output, the rest of the batch one sample at a time
+     * the last strip of a row that is not a whole number of them is masked
+     */
+    inline void mat_t_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        const size_t groupEnd = batch - batch % 4;
+        const size_t stripEnd = m - m % 16;
+        const size_t tail = m - stripEnd;
+
+        const __m256i full = _mm256_set1_epi32(-1);
+        const __m256i tail0 = tail_mask(std::min<size_t>(tail, 8)), tail1 = tail_mask(tail > 8 ? tail - 8 : 0);
+
+        for (size_t b = 0; b < groupEnd; b += 4)
+        {
+            const float* x = &inMat[b * inStride];
+            float* out = &outMat[b * outStride];
+
+            for (size_t j = 0; j < stripEnd; j += 16)
+                mat_t_4x16<false>(x, inMatrix, out, m, n, j, inStride, outStride, full, full);
+
+            if (tail)
+                mat_t_4x16<true>(x, inMatrix, out, m, n, stripEnd, inStride, outStride, tail0, tail1);
+        }
+
+        for (size_t b = groupEnd; b < batch; b++)
+        {
+            const float* x = &inMat[b * inStride];
+            float* out = &outMat[b * outStride];
+
+            for (size_t j = 0; j < stripEnd; j += 16)
+                mat_t_1x16<false>(x, inMatrix, out, m, n, j, full, full);
+
+            if (tail)
+                mat_t_1x16<true>(x, inMatrix, out, m, n, stripEnd, tail0, tail1);
+        }
+    }
+
+    /* rows [i, i + 4) x columns [j, j + 16) of outMatrix (8 accumulators) are loaded once, every sample adds
+     * 4 broadcasts of inX times its 2 registers of inY to them, and they are stored once at the end
+     */
+    template<bool Tail>
+    inline void rank_k_4x16(const float* inX, const float* inY, float* outMatrix, size_t i, size_t j, size_t batch, size_t xStride, size_t yStride,
+        size_t matrixStride, __m256i mask0, __m256i mask1)
+    {
+        float* o0 = &outMatrix[i * matrixStride + j];
+        float* o1 = o0 + matrixStride;
+        float* o2 = o1 + matrixStride;
+        float* o3 = o2 + matrixStride;
+
+        __m256 a00 = load_columns<Tail>(o0, mask0), a01 = load_columns<Tail>(o0 + 8, mask1);
+        __m256 a10 = load_columns<Tail>(o1, mask0), a11 = load_columns<Tail>(o1 + 8, mask1);
+        __m256 a20 = load_columns<Tail>(o2, mask0), a21 = load_columns<Tail>(o2 + 8, mask1);
+        __m256 a30 = load_columns<Tail>(o3, mask0), a31 = load_columns<Tail>(o3 + 8, mask1);
+
+        for (size_t b = 0; b < batch; b++)
+        {
+            const float* y = &inY[b * yStride + j];
+            const float* x = &inX[b * xStride + i];
+
+            const __m256 y0 = load_columns<Tail>(y, mask0);
+            const __m256 y1 = load_columns<Tail>(y + 8, mask1);
+
+            __m256 in = _mm256_broadcast_ss(&x[0]);
+            a00 = _mm256_fmadd_ps(in, y0, a00); a01 = _mm256_fmadd_ps(in, y1, a01);
+
+            in = _mm256_broadcast_ss(&x[1]);
+            a10 = _mm256_fmadd_ps(in, y0, a10); a11 = _mm256_fmadd_ps(in, y1, a11);
+
+            in = _mm256_broadcast_ss(&x[2]);
+            a20 = _mm256_fmadd_ps(in, y0, a20); a21 = _mm256_fmadd_ps(in, y1, a21);
+
+            in = _mm256_broadcast_ss(&x[3]);
+            a30 = _mm256_fmadd_ps(in, y0, a30); a31 = _mm256_fmadd_ps(in, y1, a31);
+        }
+
+        store_columns<Tail>(o0, mask0, a00); store_columns<Tail>(o0 + 8, mask1, a01);
+        store_columns<Tail>(o1, mask0, a10); store_columns<Tail>(o1 + 8, mask1, a11);
+        store_columns<Tail>(o2, mask0, a20); store_columns<Tail>(o2 + 8, mask1, a21);
+        store_columns<Tail>(o3, mask0, a30); store_columns<Tail>(o3 + 8, mask1, a31);
+    }
+
+    /* one row of outMatrix, columns [j, j + 16) */
+    template<bool Tail>
+    inline void rank_k_1x16(const float* inX, const float* inY, float* outMatrix, size_t i, size_t j, size_t batch, size_t xStride, size_t yStride,
+        size_t matrixStride, __m256i mask0, __m256i mask1)
+    {
+        float* o = &outMatrix[i * matrixStride + j];
+        __m256 a0 = load_columns<Tail>(o, mask0), a1 = load_columns<Tail>(o + 8, mask1);
+
+        for (size_t b = 0; b < batch; b++)
+        {
+            const float* y = &inY[b * yStride + j];
+            const __m256 in = _mm256_broadcast_ss(&inX[b * xStride + i]);
+
+            a0 = _mm256_fmadd_ps(in, load_columns<Tail>(y, mask0), a0);
+            a1 = _mm256_fmadd_ps(in, load_columns<Tail>(y + 8, mask1), a1);
+        }
+
+        store_columns<Tail>(o, mask0, a0);
+        store_columns<Tail>(o + 8, mask1, a1);
+    }
+
+    /* groups of 4 rows go through every 16 column strip, each tile of outMatrix is read and written once per call
+     * whatever the batch, inY is re-read once per group of rows (a shard of activations stays in L1)
+     */
+    inline void rank_k_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t batch, size_t xStride, size_t yStride, size_t matrixStride)
+    {
+        const size_t groupEnd = n - n % 4;
+        const size_t stripEnd = m - m % 16;
+        const size_t tail = m - stripEnd;
+
+        const __m256i full = _mm256_set1_epi32(-1);
+        const __m256i tail0 = tail_mask(std::min<size_t>(tail, 8)), tail1 = tail_mask(tail > 8 ? tail - 8 : 0);
+
+        for (size_t i = 0; i < groupEnd; i += 4)
+        {
+            for (size_t j = 0; j < stripEnd; j += 16)
+                rank_k_4x16<false>(inX, inY, outMatrix, i, j, batch, xStride, yStride, matrixStride, full, full);
+
+            if (tail)
+                rank_k_4x16<true>(inX, inY, outMatrix, i, stripEnd, batch, xStride, yStride, matrixStride, tail0, tail1);
+        }
+
+        for (size_t i = groupEnd; i < n; i++)
+        {
+            for (size_t j = 0; j < stripEnd; j += 16)
+                rank_k_1x16<false>(inX, inY, outMatrix, i, j, batch, xStride, yStride, matrixStride, full, full);
+
+            if (tail)
+                rank_k_1x16<true>(inX, inY, outMatrix, i, stripEnd, batch, xStride, yStride, matrixStride, tail0, tail1);
+        }
+    }
+
+    inline void rank1_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t matrixStride)
+    {
+        rank_k_update(inX, inY, outMatrix, m, n, 1, 0, 0, matrixStride);
+    }
+
+    inline void accumulate_rows(const float* inMat, float* outVec, size_t n, size_t batch, size_t inStride)
+    {
+        const size_t leftover = n % 8;
+
+        for (size_t i = 0; i < (n - leftover); i += 8)
+        {
+            __m256 sum = _mm256_loadu_ps(&outVec[i]);
+            for (size_t b = 0; b < batch; b++)
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(&inMat[b * inStride + i]));
+
+            _mm256_storeu_ps(&outVec[i], sum);
+        }
+
+        if (leftover)
+        {
+            const size_t offset = n - leftover;
+            const __m256i mask = tail_mask(leftover);
+
+            __m256 sum = _mm256_maskload_ps(&outVec[offset], mask);
+            for (size_t b = 0; b < batch; b++)
+                sum = _mm256_add_ps(sum, _mm256_maskload_ps(&inMat[b * inStride + offset], mask));
+
+            _mm256_maskstore_ps(&outVec[offset], mask, sum);
+        }
+    }
+
+    /* derivatives from the activation's output, delta * f'(y) */
+    struct sigmoid_derivative_op
+    {
+        /* y * (1 - y) == y - y * y */
+        __m256 operator()(__m256 delta, __m256 y) const { return _mm256_mul_ps(delta, _mm256_fnmadd_ps(y, y, y)); }
+    };
+
+    struct tanh_derivative_op
+    {
+        __m256 operator()(__m256 delta, __m256 y) const { return _mm256_mul_ps(delta, _mm256_fnmadd_ps(y, y, _mm256_set1_ps(1.0f))); }
+    };
+
+    struct relu_derivative_op
+    {
+        __m256 operator()(__m256 delta, __m256 y) const { return _mm256_and_ps(delta, _mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_GT_OQ)); }
+    };
+
+    struct leaky_relu_derivative_op
+    {
+        __m256 alpha;
+
+        __m256 operator()(__m256 delta, __m256 y) const
+        {
+            return _mm256_blendv_ps(_mm256_mul_ps(delta, alpha), delta, _mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_GT_OQ));
+        }
+    };
+
+    template<typename Op>
+    inline void mul_derivative_apply(float* ioDelta, const float* inOutputs, size_t n, Op op)
+    {
+        const size_t leftover = n % 8;
+
+        for (size_t i = 0; i < (n - leftover); i += 8)
+            _mm256_storeu_ps(&ioDelta[i], op(_mm256_loadu_ps(&ioDelta[i]), _mm256_loadu_ps(&inOutputs[i])));
+
+        if (leftover)
+        {
+            const size_t offset = n - leftover;
+            const __m256i mask = tail_mask(leftover);
+
+            _mm256_maskstore_ps(&ioDelta[offset], mask, op(_mm256_maskload_ps(&ioDelta[offset], mask), _mm256_maskload_ps(&inOutputs[offset], mask)));
+        }
+    }
+
+    inline void mul_derivative_sigmoid(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, sigmoid_derivative_op{}); }
+    inline void mul_derivative_tanh(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, tanh_derivative_op{}); }
+    inline void mul_derivative_relu(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, relu_derivative_op{}); }
+
+    inline void mul_derivative_leaky_relu(float* ioDelta, const float* inOutputs, size_t n, float alpha)
+    {
+        mul_derivative_apply(ioDelta, inOutputs, n, leaky_relu_derivative_op{ _mm256_set1_ps(alpha) });
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,651 @@
+#pragma once
+
+#include "simd_avx2.hpp"
+
+#ifdef SIMD_X86
+
+#include <immintrin.h>
+
+/* 16-wide kernels, compiled for avx512f regardless of the global compiler flags
+ * only avx512f is required, the int8 kernels would need avx512bw so this level keeps the avx2 ones
+ */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+
+namespace simd::avx512 {
+
+    /* lanes [0, count) */
+    inline __mmask16 tail_mask(size_t count) { return __mmask16((1U << count) - 1U); }
+
+    /* 16 lanes folded into 8, to reuse the avx2 reductions */
+    inline __m256 fold(__m512 inVec)
+    {
+        return _mm256_add_ps(_mm512_castps512_ps256(inVec), _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(inVec), 1)));
+    }
+
+    inline float accumulate(const float* inVec, size_t count)
+    {
+        const size_t leftover = count % 16;
+        __m512 temp = _mm512_setzero_ps();
+
+        for (size_t i = 0; i < (count - leftover); i+=16)
+            temp = _mm512_add_ps(_mm512_loadu_ps(&inVec[i]), temp);
+
+        if (leftover)
+            temp = _mm512_add_ps(_mm512_maskz_loadu_ps(tail_mask(leftover), &inVec[count - leftover]), temp);
+
+        return _mm512_reduce_add_ps(temp);
+    }
+
+    /* outVec[i] (+)= dot(inVec, inMatrix[i * m]) for the columns [0, n) over the inputs [0, count), then epilogue
+     * the dot products are reduced to 8 lanes before they are stored, so the avx2 epilogues apply as they are
+     * (which is also why the calls below are qualified, adl would find the avx2 kernels through them)
+     */
+    template<typename Epilogue = avx2::no_epilogue>
+    inline void vec_mat_mul_block(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, size_t count, bool accumulateOutput,
+        Epilogue epilogue = Epilogue{})
+    {
+        const size_t leftover = count % 16;
+        const size_t end = count - leftover;
+        const __mmask16 mask = tail_mask(leftover);
+
+        size_t i = 0;
+
+        /* 8 columns per pass, every input load feeds 8 fmas */
+        for (; i + 8 <= n; i += 8)
+        {
+            const float* w = &inMatrix[i * m];
+
+            __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps(), acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+            __m512 acc4 = _mm512_setzero_ps(), acc5 = _mm512_setzero_ps(), acc6 = _mm512_setzero_ps(), acc7 = _mm512_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 16)
+            {
+                const __m512 x = _mm512_loadu_ps(&inVec[j]);
+                acc0 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[0 * m + j]), acc0);
+                acc1 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[1 * m + j]), acc1);
+                acc2 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[2 * m + j]), acc2);
+                acc3 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[3 * m + j]), acc3);
+                acc4 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[4 * m + j]), acc4);
+                acc5 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[5 * m + j]), acc5);
+                acc6 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[6 * m + j]), acc6);
+                acc7 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[7 * m + j]), acc7);
+            }
+
+            if (leftover)
+            {
+                const __m512 x = _mm512_maskz_loadu_ps(mask, &inVec[end]);
+                acc0 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[0 * m + end]), acc0);
+                acc1 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[1 * m + end]), acc1);
+                acc2 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[2 * m + end]), acc2);
+                acc3 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[3 * m + end]), acc3);
+                acc4 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[4 * m + end]), acc4);
+                acc5 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[5 * m + end]), acc5);
+                acc6 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[6 * m + end]), acc6);
+                acc7 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[7 * m + end]), acc7);
+            }
+
+            __m256 result = avx2::reduce_8x8(fold(acc0), fold(acc1), fold(acc2), fold(acc3), fold(acc4), fold(acc5), fold(acc6), fold(acc7));
+
+            if (accumulateOutput)
+                result = _mm256_add_ps(result, _mm256_loadu_ps(&outVec[i]));
+
+            _mm256_storeu_ps(&outVec[i], epilogue(result, i));
+        }
+
+        /* 4 columns */
+        for (; i + 4 <= n; i += 4)
+        {
+            const float* w = &inMatrix[i * m];
+            __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps(), acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 16)
+            {
+                const __m512 x = _mm512_loadu_ps(&inVec[j]);
+                acc0 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[0 * m + j]), acc0);
+                acc1 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[1 * m + j]), acc1);
+                acc2 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[2 * m + j]), acc2);
+                acc3 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&w[3 * m + j]), acc3);
+            }
+
+            if (leftover)
+            {
+                const __m512 x = _mm512_maskz_loadu_ps(mask, &inVec[end]);
+                acc0 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[0 * m + end]), acc0);
+                acc1 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[1 * m + end]), acc1);
+                acc2 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[2 * m + end]), acc2);
+                acc3 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, &w[3 * m + end]), acc3);
+            }
+
+            __m128 result = avx2::reduce_4x8(fold(acc0), fold(acc1), fold(acc2), fold(acc3));
+
+            if (accumulateOutput)
+                result = _mm_add_ps(result, _mm_loadu_ps(&outVec[i]));
+
+            _mm_storeu_ps(&outVec[i], epilogue(result, i));
+        }
+
+        /* remaining 1 to 3 columns */
+        for (; i < n; i++)
+        {
+            const float* w = &inMatrix[i * m];
+            __m512 acc = _mm512_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 16)
+                acc = _mm512_fmadd_ps(_mm512_loadu_ps(&inVec[j]), _mm512_loadu_ps(&w[j]), acc);
+
+            if (leftover)
+                acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &inVec[end]), _mm512_maskz_loadu_ps(mask, &w[end]), acc);
+
+            float result = _mm512_reduce_add_ps(acc);
+            outVec[i] = epilogue(accumulateOutput ? outVec[i] + result : result, i);
+        }
+    }
+
+    template<typename Epilogue>
+    inline void vec_mat_mul_apply(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, Epilogue epilogue)
+    {
+        /* rows narrower than a register would run every load masked, the 8-wide kernel does better there */
+        if (m < 16)
+        {
+            avx2::vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, epilogue);
+            return;
+        }
+
+        for (size_t k = 0; k < m; k += gemv_block_size)
+        {
+            size_t count = std::min(gemv_block_size, m - k);
+
+            if (k + count == m)
+                avx512::vec_mat_mul_block(&inVec[k], &inMatrix[k], outVec, m, n, count, k != 0, epilogue);
+            else
+                avx512::vec_mat_mul_block(&inVec[k], &inMatrix[k], outVec, m, n, count, k != 0);
+        }
+    }
+
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        avx512::vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, avx2::no_epilogue{});
+    }
+
+    inline float dot_1x1(const float* x, const float* w, size_t end, size_t leftover, __mmask16 mask)
+    {
+        __m512 acc = _mm512_setzero_ps();
+
+        for (size_t j = 0; j < end; j += 16)
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(&x[j]), _mm512_loadu_ps(&w[j]), acc);
+
+        if (leftover)
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &x[end]), _mm512_maskz_loadu_ps(mask, &w[end]), acc);
+
+        return _mm512_reduce_add_ps(acc);
+    }
+
+    /* same panels and 2 samples x 4 columns micro kernel as the avx2 version, twice as wide */
+    template<typename Epilogue>
+    inline void mat_mat_mul_apply(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        if (m < 16)
+        {
+            avx2::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, epilogue);
+            return;
+        }
+
+        if (batch == 1)
+        {
+            avx512::vec_mat_mul_apply(inMat, inMatrix, outMat, m, n, epilogue);
+            return;
+        }
+
+        const size_t leftover = m % 16;
+        const size_t end = m - leftover;
+        const __mmask16 mask = tail_mask(leftover);
+
+        const size_t panelColumns = std::max<size_t>(4ULL, (gemm_panel_size / std::max<size_t>(m, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t panelEnd = std::min(n, p + panelColumns);
+
+            size_t b = 0;
+            for (; b + 2 <= batch; b += 2)
+            {
+                const float* x0 = &inMat[b * inStride];
+                const float* x1 = &inMat[(b + 1) * inStride];
+                float* out0 = &outMat[b * outStride];
+                float* out1 = &outMat[(b + 1) * outStride];
+
+                size_t i = p;
+                for (; i + 4 <= panelEnd; i += 4)
+                {
+                    const float* w = &inMatrix[i * m];
+
+                    __m512 a00 = _mm512_setzero_ps(), a01 = _mm512_setzero_ps(), a02 = _mm512_setzero_ps(), a03 = _mm512_setzero_ps();
+                    __m512 a10 = _mm512_setzero_ps(), a11 = _mm512_setzero_ps(), a12 = _mm512_setzero_ps(), a13 = _mm512_setzero_ps();
+
+                    for (size_t j = 0; j < end; j += 16)
+                    {
+                        const __m512 in0 = _mm512_loadu_ps(&x0[j]);
+                        const __m512 in1 = _mm512_loadu_ps(&x1[j]);
+
+                        __m512 wv = _mm512_loadu_ps(&w[0 * m + j]);
+                        a00 = _mm512_fmadd_ps(in0, wv, a00); a10 = _mm512_fmadd_ps(in1, wv, a10);
+
+                        wv = _mm512_loadu_ps(&w[1 * m + j]);
+                        a01 = _mm512_fmadd_ps(in0, wv, a01); a11 = _mm512_fmadd_ps(in1, wv, a11);
+
+                        wv = _mm512_loadu_ps(&w[2 * m + j]);
+                        a02 = _mm512_fmadd_ps(in0, wv, a02); a12 = _mm512_fmadd_ps(in1, wv, a12);
+
+                        wv = _mm512_loadu_ps(&w[3 * m + j]);
+                        a03 = _mm512_fmadd_ps(in0, wv, a03); a13 = _mm512_fmadd_ps(in1, wv, a13);
+                    }
+
+                    if (leftover)
+                    {
+                        const __m512 in0 = _mm512_maskz_loadu_ps(mask, &x0[end]);
+                        const __m512 in1 = _mm512_maskz_loadu_ps(mask, &x1[end]);
+
+                        __m512 wv = _mm512_maskz_loadu_ps(mask, &w[0 * m + end]);
+                        a00 = _mm512_fmadd_ps(in0, wv, a00); a10 = _mm512_fmadd_ps(in1, wv, a10);
+
+                        wv = _mm512_maskz_loadu_ps(mask, &w[1 * m + end]);
+                        a01 = _mm512_fmadd_ps(in0, wv, a01); a11 = _mm512_fmadd_ps(in1, wv, a11);
+
+                        wv = _mm512_maskz_loadu_ps(mask, &w[2 * m + end]);
+                        a02 = _mm512_fmadd_ps(in0, wv, a02); a12 = _mm512_fmadd_ps(in1, wv, a12);
+
+                        wv = _mm512_maskz_loadu_ps(mask, &w[3 * m + end]);
+                        a03 = _mm512_fmadd_ps(in0, wv, a03); a13 = _mm512_fmadd_ps(in1, wv, a13);
+                    }
+
+                    _mm_storeu_ps(&out0[i], epilogue(avx2::reduce_4x8(fold(a00), fold(a01), fold(a02), fold(a03)), i));
+                    _mm_storeu_ps(&out1[i], epilogue(avx2::reduce_4x8(fold(a10), fold(a11), fold(a12), fold(a13)), i));
+                }
+
+                for (; i < panelEnd; i++)
+                {
+                    out0[i] = epilogue(dot_1x1(x0, &inMatrix[i * m], end, leftover, mask), i);
+                    out1[i] = epilogue(dot_1x1(x1, &inMatrix[i * m], end, leftover, mask), i);
+                }
+            }
+
+            /* odd sample */
+            if (b < batch)
+            {
+                const float* x = &inMat[b * inStride];
+                float* out = &outMat[b * outStride];
+
+                for (size_t i = p; i < panelEnd; i++)
+                    out[i] = epilogue(dot_1x1(x, &inMatrix[i * m], end, leftover, mask), i);
+            }
+        }
+    }
+
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::no_epilogue{});
+    }
+
+    /*------------------------------packed weights--------------------------------*/
+    /* a panel is exactly one zmm, split in two so the avx2 epilogues and the partial last panel of avx2::store_panel apply */
+    template<typename Epilogue>
+    inline void store_panel(float* outVec, __m512 acc, size_t i, size_t n, Epilogue epilogue)
+    {
+        avx2::store_panel(outVec, _mm512_castps512_ps256(acc), _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(acc), 1)), i, n, epilogue);
+    }
+
+    /* 12 samples against the panel starting at column i, one weight load feeds 12 fmas */
+    template<typename Epilogue>
+    inline void packed_12x1(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t i, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+
+        __m512 acc[12];
+        for (size_t s = 0; s < 12; s++)
+            acc[s] = _mm512_setzero_ps();
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const __m512 wv = _mm512_loadu_ps(&w[j * packed_panel_width]);
+            const float* x = &inMat[j];
+
+            for (size_t s = 0; s < 12; s++)
+                acc[s] = _mm512_fmadd_ps(_mm512_set1_ps(x[s * inStride]), wv, acc[s]);
+        }
+
+        for (size_t s = 0; s < 12; s++)
+            avx512::store_panel(&outMat[s * outStride], acc[s], i, n, epilogue);
+    }
+
+    /* one sample against one panel, 4 interleaved accumulators so the fma latency is hidden */
+    template<typename Epilogue>
+    inline void packed_1x1(const float* inVec, const float* inPacked, float* outVec, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+        __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+
+        size_t j = 0;
+        for (; j + 4 <= m; j += 4)
+        {
+            const float* wj = &w[j * packed_panel_width];
+            a0 = _mm512_fmadd_ps(_mm512_set1_ps(inVec[j + 0]), _mm512_loadu_ps(&wj[0 * packed_panel_width]), a0);
+            a1 = _mm512_fmadd_ps(_mm512_set1_ps(inVec[j + 1]), _mm512_loadu_ps(&wj[1 * packed_panel_width]), a1);
+            a2 = _mm512_fmadd_ps(_mm512_set1_ps(inVec[j + 2]), _mm512_loadu_ps(&wj[2 * packed_panel_width]), a2);
+            a3 = _mm512_fmadd_ps(_mm512_set1_ps(inVec[j + 3]), _mm512_loadu_ps(&wj[3 * packed_panel_width]), a3);
+        }
+
+        for (; j < m; j++)
+            a0 = _mm512_fmadd_ps(_mm512_set1_ps(inVec[j]), _mm512_loadu_ps(&w[j * packed_panel_width]), a0);
+
+        avx512::store_panel(outVec, _mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)), i, n, epilogue);
+    }
+
+    /* same contract as mat_mat_mul with inPacked from pack_weights
+     * groups of 12 samples go through every panel while it is in cache, the rest of the batch one sample at a time
+     */
+    template<typename Epilogue>
+    inline void mat_mat_mul_packed_apply(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const size_t groupEnd = batch - batch % 12;
+
+        for (size_t i = 0; i < n; i += packed_panel_width)
+        {
+            for (size_t b = 0; b < groupEnd; b += 12)
+                packed_12x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, inStride, outStride, epilogue);
+
+            for (size_t b = groupEnd; b < batch; b++)
+                avx512::packed_1x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, epilogue);
+        }
+    }
+
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::no_epilogue{});
+    }
+
+    inline void set_to_zero(float* inVec, size_t count)
+    {
+        const size_t leftover = count % 16;
+
+        for (size_t i = 0; i < (count - leftover); i+=16)
+            _mm512_storeu_ps(&inVec[i], _mm512_setzero_ps());
+
+        if (leftover)
+            _mm512_mask_storeu_ps(&inVec[count - leftover], tail_mask(leftover), _mm512_setzero_ps());
+    }
+
+    inline void set_range_value(float* inVec, size_t count, float value)
+    {
+        const size_t leftover = count % 16;
+        const __m512 mValue = _mm512_set1_ps(value);
+
+        for (size_t i = 0; i < (count - leftover); i+=16)
+            _mm512_storeu_ps(&inVec[i], mValue);
+
+        if (leftover)
+            _mm512_mask_storeu_ps(&inVec[count - leftover], tail_mask(leftover), mValue);
+    }
+
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset)
+    {
+        const size_t leftover = count % 16;
+        const __m512 mScale = _mm512_set1_ps(scale), mOffset = _mm512_set1_ps(offset);
+
+        for (size_t i = 0; i < (count - leftover); i+=16)
+            _mm512_storeu_ps(&ioVec[i], _mm512_fmadd_ps(_mm512_loadu_ps(&ioVec[i]), mScale, mOffset));
+
+        if (leftover)
+        {
+            const __mmask16 mask = tail_mask(leftover);
+            const size_t tail = count - leftover;
+            _mm512_mask_storeu_ps(&ioVec[tail], mask, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &ioVec[tail]), mScale, mOffset));
+        }
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    /* cephes exp, the same polynomial as exp256_ps in vendor/avx_mathfun.h */
+    inline __m512 exp512_ps(__m512 x)
+    {
+        x = _mm512_min_ps(x, _mm512_set1_ps(88.3762626647949f));
+        x = _mm512_max_ps(x, _mm512_set1_ps(-88.3762626647949f));
+
+        /* express exp(x) as exp(g + n * log(2)) */
+        __m512 fx = _mm512_fmadd_ps(x, _mm512_set1_ps(1.44269504088896341f), _mm512_set1_ps(0.5f));
+        fx = _mm512_roundscale_ps(fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+
+        x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(0.693359375f), x);
+        x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(-2.12194440e-4f), x);
+
+        const __m512 z = _mm512_mul_ps(x, x);
+
+        __m512 y = _mm512_set1_ps(1.9875691500E-4f);
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507E-3f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073E-3f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894E-2f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459E-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201E-1f));
+        y = _mm512_fmadd_ps(y, z, x);
+        y = _mm512_add_ps(y, _mm512_set1_ps(1.0f));
+
+        /* build 2^n */
+        __m512i imm0 = _mm512_add_epi32(_mm512_cvttps_epi32(fx), _mm512_set1_epi32(0x7f));
+        imm0 = _mm512_slli_epi32(imm0, 23);
+
+        return _mm512_mul_ps(y, _mm512_castsi512_ps(imm0));
+    }
+
+    /* applies op to outVec + inBiases 16 lanes at a time, the tail with masked loads and stores */
+    template<typename Op>
+    inline void add_bias_apply(float* outVec, const float* inBiases, size_t n, Op op)
+    {
+        const size_t leftover = n % 16;
+
+        for (size_t i = 0; i < (n - leftover); i+=16)
+            _mm512_storeu_ps(&outVec[i], op(_mm512_add_ps(_mm512_loadu_ps(&outVec[i]), _mm512_loadu_ps(&inBiases[i]))));
+
+        if (leftover)
+        {
+            const size_t offset = n - leftover;
+            const __mmask16 mask = tail_mask(leftover);
+
+            __m512 sum = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, &outVec[offset]), _mm512_maskz_loadu_ps(mask, &inBiases[offset]));
+            _mm512_mask_storeu_ps(&outVec[offset], mask, op(sum));
+        }
+    }
+
+    /* functors rather than lambdas, gcc does not apply the target pragma to lambdas */
+    struct sigmoid_op
+    {
+        __m512 operator()(__m512 x) const
+        {
+            const __m512 one = _mm512_set1_ps(1.0f);
+            return _mm512_div_ps(one, _mm512_add_ps(one, exp512_ps(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+        }
+    };
+
+    /* tanh(x) == (exp(2x) - 1) / (exp(2x) + 1) */
+    struct tanh_op
+    {
+        __m512 operator()(__m512 x) const
+        {
+            const __m512 one = _mm512_set1_ps(1.0f);
+            const __m512 e = exp512_ps(_mm512_add_ps(x, x));
+            return _mm512_div_ps(_mm512_sub_ps(e, one), _mm512_add_ps(e, one));
+        }
+    };
+
+    struct relu_op
+    {
+        __m512 operator()(__m512 x) const { return _mm512_max_ps(x, _mm512_setzero_ps()); }
+    };
+
+    struct linear_op
+    {
+        __m512 operator()(__m512 x) const { return x; }
+    };
+
+    /* multiplies only the lanes that are not positive */
+    struct leaky_relu_op
+    {
+        __m512 alpha;
+        __m512 operator()(__m512 x) const { return _mm512_mask_mul_ps(x, _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LE_OQ), x, alpha); }
+    };
+
+    /* the activation_accuracy approximations, see simd_avx2.hpp. the estimate has 14 bits here and scalef applies 2^n */
+    inline __m512 rcp_nr_ps(__m512 d)
+    {
+        const __m512 r = _mm512_rcp14_ps(d);
+        return _mm512_fmadd_ps(r, _mm512_fnmadd_ps(d, r, _mm512_set1_ps(1.0f)), r);
+    }
+
+    inline __m512 exp_poly_ps(__m512 x)
+    {
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(exp_poly_low)), _mm512_set1_ps(exp_poly_high));
+
+        const __m512 t = _mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f));
+        const __m512 n = _mm512_roundscale_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m512 f = _mm512_sub_ps(t, n);
+
+        __m512 p = _mm512_fmadd_ps(_mm512_set1_ps(exp2_poly[3]), f, _mm512_set1_ps(exp2_poly[2]));
+        p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(exp2_poly[1]));
+        p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(exp2_poly[0]));
+
+        return _mm512_scalef_ps(p, n);
+    }
+
+    inline __m512 tanh_rational_ps(__m512 x)
+    {
+        const __m512 clamp = _mm512_set1_ps(tanh_rational_clamp);
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_sub_ps(_mm512_setzero_ps(), clamp)), clamp);
+
+        const __m512 x2 = _mm512_mul_ps(x, x);
+
+        __m512 p = _mm512_set1_ps(tanh_rational_p[6]);
+        for (int i = 5; i >= 0; i--)
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(tanh_rational_p[i]));
+
+        __m512 q = _mm512_set1_ps(tanh_rational_q[3]);
+        for (int i = 2; i >= 0; i--)
+            q = _mm512_fmadd_ps(q, x2, _mm512_set1_ps(tanh_rational_q[i]));
+
+        return _mm512_mul_ps(_mm512_mul_ps(x, p), rcp_nr_ps(q));
+    }
+
+    struct sigmoid_poly_op
+    {
+        __m512 operator()(__m512 x) const
+        {
+            return rcp_nr_ps(_mm512_add_ps(_mm512_set1_ps(1.0f), exp_poly_ps(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+        }
+    };
+
+    struct tanh_poly_op
+    {
+        __m512 operator()(__m512 x) const
+        {
+            const __m512 one = _mm512_set1_ps(1.0f);
+            return _mm512_fnmadd_ps(_mm512_set1_ps(2.0f), rcp_nr_ps(_mm512_add_ps(one, exp_poly_ps(_mm512_add_ps(x, x)))), one);
+        }
+    };
+
+    struct sigmoid_rational_op
+    {
+        __m512 operator()(__m512 x) const
+        {
+            const __m512 half = _mm512_set1_ps(0.5f);
+            return _mm512_fmadd_ps(half, tanh_rational_ps(_mm512_mul_ps(half, x)), half);
+        }
+    };
+
+    struct tanh_rational_op
+    {
+        __m512 operator()(__m512 x) const { return tanh_rational_ps(x); }
+    };
+
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, sigmoid_op{}); }
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, tanh_op{}); }
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, relu_op{}); }
+
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha)
+    {
+        add_bias_apply(outVec, inBiases, n, leaky_relu_op{ _mm512_set1_ps(alpha) });
+    }
+
+    /* add_bias_* for any stateless op, how the kernel table binds the approximate sigmoid and tanh */
+    template<typename Op>
+    inline void add_bias_op(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, Op{}); }
+
+    /*------------------------------fused layer-----------------------------------*/
+    /* the epilogue runs on 8 lanes here as well, see vec_mat_mul_block */
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::leaky_relu_op>{ inBiases, { _mm256_set1_ps(alpha) } });
+    }
+
+    /* Op is the avx2 op, like the ones above */
+    template<typename Op>
+    inline void mat_mat_mul_bias_op(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------fused layer, packed weights-------------------*/
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<avx2::leaky_relu_op>{ inBiases, { _mm256_set1_ps(alpha) } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_packed_bias_op(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        avx512::mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, avx2::bias_epilogue<Op>{ inBiases, {} });
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#endif
+
+namespace simd {
+
+    /* instruction sets a kernel table can be built for, the x86 ones in order of preference
+     * neon is the only aarch64 level and is never compared against them, see is_supported in simd.hpp
+     */
+    enum class isa : uint32_t { scalar = 0, sse42, avx2, avx512, neon, count };
+
+    inline const char* isa_name(isa level)
+    {
+        switch (level)
+        {
+            case isa::sse42:  return "sse4.2";
+            case isa::avx2:   return "avx2";
+            case isa::avx512: return "avx512";
+            case isa::neon:   return "neon";
+            default:          return "scalar";
+        }
+    }
+
+    /* inputs per cache block, the input slice (16KiB) stays in L1 while every column streams through it */
+    static constexpr size_t gemv_block_size = 4096ULL;
+
+    /* weights per cache panel (128KiB), a panel of columns stays resident while the whole batch streams through it */
+    static constexpr size_t gemm_panel_size = 32768ULL;
+
+    /*------------------------------packed weights--------------------------------*/
+    /* columns per packed panel: one zmm, two ymm or four xmm/q registers of outputs, the same on every isa
+     * so packed weights stay valid across set_isa
+     */
+    static constexpr size_t packed_panel_width = 16ULL;
+
+    /* floats pack_weights writes for n columns of m weights, n is rounded up to whole panels */
+    inline size_t packed_size(size_t m, size_t n) { return ((n + packed_panel_width - 1) / packed_panel_width) * packed_panel_width * m; }
+
+    /* repacks n rows (one per output, row i at inMatrix[i * inStride]) of m weights into panels of packed_panel_width columns
+     * a panel stores input j of all its columns next to each other, so one broadcast input feeds a whole register of outputs:
+     * outPacked[(p * m + j) * 16 + c] == inMatrix[(p * 16 + c) * inStride + j], columns past n are zero
+     */
+    inline void pack_weights(const float* inMatrix, float* outPacked, size_t m, size_t n, size_t inStride)
+    {
+        for (size_t p = 0; p < n; p += packed_panel_width)
+        {
+            float* panel = &outPacked[p * m];
+            const size_t columns = std::min(packed_panel_width, n - p);
+
+            for (size_t j = 0; j < m; j++)
+            {
+                for (size_t c = 0; c < packed_panel_width; c++)
+                    panel[j * packed_panel_width + c] = c < columns ? inMatrix[(p + c) * inStride + j] : 0.0f;
+            }
+        }
+    }
+
+    /*------------------------------activation accuracy---------------------------*/
+    /* how sigmoid and tanh are evaluated, relu and leaky relu are exact at every level
+     * exact:      exp (avx_mathfun, neon_mathfun or libm) and a true division
+     * polynomial: exp(x) == 2^round(t) * p(t - round(t)) with t == x * log2(e) and p a degree 3 minimax fit,
+     *             the division replaced by a reciprocal estimate plus one newton step, within ~4e-5
+     * rational:   tanh(x) == x * p(x^2) / q(x^2), a 13/6 minimax fit without any exp, the same reciprocal,
+     *             sigmoid(x) == 0.5 + 0.5 * tanh(x / 2), within a few 1e-7
+     * errors are absolute, kernel_bench --compare measures them (and the ulp) next to the speed of each level
+     */
+    enum class activation_accuracy : uint32_t { exact = 0, polynomial, rational, count };
+
+    inline const char* activation_accuracy_name(activation_accuracy accuracy)
+    {
+        switch (accuracy)
+        {
+            case activation_accuracy::polynomial: return "polynomial";
+            case activation_accuracy::rational:   return "rational";
+            default:                              return "exact";
+        }
+    }
+
+    /* 2^f for f in [-0.5, 0.5], lowest degree first, relative error 7.5e-5 */
+    static constexpr float exp2_poly[4] = { 9.999280696e-01f, 6.932610307e-01f, 2.426112107e-01f, 5.517137654e-02f };
+
+    /* exp_poly clamps its input to this range, 2^round(t) stays a normal float and the result finite */
+    static constexpr float exp_poly_low = -86.0f;
+    static constexpr float exp_poly_high = 88.0f;
+
+    /* odd numerator and even denominator of the rational tanh, lowest degree first
+     * past tanh_rational_clamp tanh(x) rounds to +-1 in fp32, so the input is clamped to it
+     */
+    static constexpr float tanh_rational_p[7] = { 4.89352455891786e-03f, 6.37261928875436e-04f, 1.48572235717979e-05f, 5.12229709037114e-08f,
+        -8.60467152213735e-11f, 2.00018790482477e-13f, -2.76076847742355e-16f };
+
+    static constexpr float tanh_rational_q[4] = { 4.89352518554385e-03f, 2.26843463243900e-03f, 1.18534705686654e-04f, 1.19825839466702e-06f };
+    static constexpr float tanh_rational_clamp = 7.90531110763549805f;
+
+    /*------------------------------int8------------------------------------------*/
+    /* quantized weight rows are padded with zeros to a whole number of these, one maddubs per step */
+    static constexpr size_t int8_row_alignment = 32ULL;
+
+    /* bytes of quantized weights per cache panel, 4x the columns of the fp32 panel for the same footprint */
+    static constexpr size_t int8_panel_size = 131072ULL;
+
+    inline size_t int8_padded_row(size_t m) { return (m + int8_row_alignment - 1) & ~(int8_row_alignment - 1); }
+
+    /* how one quantized input vector maps back to floats: x == (q - zero_point) * scale */
+    struct int8_input
+    {
+        float scale = 1.0f;
+        int32_t zero_point = 0;
+    };
+
+    /* the range half of quantize_input, shared by every implementation
+     * non-negative vectors (anything after relu) use [0, 127], the others are offset by 64 and use [1, 127]
+     */
+    inline int8_input int8_input_params(float low, float high)
+    {
+        int8_input params;
+        int32_t levels = 127;
+
+        if (low < 0.0f)
+        {
+            params.zero_point = 64;
+            levels = 63;
+            high = std::max(high, -low);
+        }
+
+        params.scale = high > 0.0f ? high / float(levels) : 1.0f;
+        return params;
+    }
+
+    inline uint8_t quantize_value(float value, float inverseScale, int32_t zeroPoint)
+    {
+        int32_t q = int32_t(std::nearbyint(value * inverseScale)) + zeroPoint;
+        return uint8_t(std::clamp(q, 0, 127));
+    }
+}
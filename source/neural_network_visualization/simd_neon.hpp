@@ -0,0 +1,552 @@
+#pragma once
+
+#include "simd_scalar.hpp"
+
+#ifdef SIMD_NEON
+
+#include <arm_neon.h>
+
+/* aarch64 kernels, neon is part of the baseline there so there is nothing to detect */
+namespace simd::neon {
+
+    /* horizontal sum of 4 accumulators, lane i of the result holds the sum of a_i */
+    inline float32x4_t reduce_4x4(float32x4_t a0, float32x4_t a1, float32x4_t a2, float32x4_t a3)
+    {
+        return vpaddq_f32(vpaddq_f32(a0, a1), vpaddq_f32(a2, a3));
+    }
+
+    inline float accumulate(const float* inVec, size_t count)
+    {
+        float32x4_t temp = vdupq_n_f32(0.0f);
+        size_t leftover = count % 4;
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            temp = vaddq_f32(vld1q_f32(&inVec[i]), temp);
+
+        float mValue = vaddvq_f32(temp);
+
+        for (size_t i = count - leftover; i < count; i++)
+            mValue += inVec[i];
+
+        return mValue;
+    }
+
+    /* cephes exp, the same polynomial as exp256_ps in vendor/avx_mathfun.h */
+    inline float32x4_t exp_ps(float32x4_t x)
+    {
+        x = vminq_f32(x, vdupq_n_f32(88.3762626647949f));
+        x = vmaxq_f32(x, vdupq_n_f32(-88.3762626647949f));
+
+        /* express exp(x) as exp(g + n * log(2)) */
+        float32x4_t fx = vfmaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f));
+        fx = vrndmq_f32(fx);
+
+        x = vfmsq_f32(x, fx, vdupq_n_f32(0.693359375f));
+        x = vfmsq_f32(x, fx, vdupq_n_f32(-2.12194440e-4f));
+
+        const float32x4_t z = vmulq_f32(x, x);
+
+        float32x4_t y = vdupq_n_f32(1.9875691500E-4f);
+        y = vfmaq_f32(vdupq_n_f32(1.3981999507E-3f), y, x);
+        y = vfmaq_f32(vdupq_n_f32(8.3334519073E-3f), y, x);
+        y = vfmaq_f32(vdupq_n_f32(4.1665795894E-2f), y, x);
+        y = vfmaq_f32(vdupq_n_f32(1.6666665459E-1f), y, x);
+        y = vfmaq_f32(vdupq_n_f32(5.0000001201E-1f), y, x);
+        y = vfmaq_f32(x, y, z);
+        y = vaddq_f32(y, vdupq_n_f32(1.0f));
+
+        /* build 2^n */
+        int32x4_t imm0 = vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(0x7f));
+        imm0 = vshlq_n_s32(imm0, 23);
+
+        return vmulq_f32(y, vreinterpretq_f32_s32(imm0));
+    }
+
+    /*------------------------------activation ops--------------------------------*/
+    struct sigmoid_op
+    {
+        float32x4_t operator()(float32x4_t x) const
+        {
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            return vdivq_f32(one, vaddq_f32(one, exp_ps(vnegq_f32(x))));
+        }
+    };
+
+    /* tanh(x) == (exp(2x) - 1) / (exp(2x) + 1) */
+    struct tanh_op
+    {
+        float32x4_t operator()(float32x4_t x) const
+        {
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            const float32x4_t e = exp_ps(vaddq_f32(x, x));
+            return vdivq_f32(vsubq_f32(e, one), vaddq_f32(e, one));
+        }
+    };
+
+    struct relu_op
+    {
+        float32x4_t operator()(float32x4_t x) const { return vmaxq_f32(x, vdupq_n_f32(0.0f)); }
+    };
+
+    /* bias only, regression outputs */
+    struct linear_op
+    {
+        float32x4_t operator()(float32x4_t x) const { return x; }
+    };
+
+    /* branch free, picks x where it is positive and alpha * x everywhere else */
+    struct leaky_relu_op
+    {
+        float32x4_t alpha;
+        float32x4_t operator()(float32x4_t x) const { return vbslq_f32(vcgtq_f32(x, vdupq_n_f32(0.0f)), x, vmulq_f32(x, alpha)); }
+    };
+
+    /* the activation_accuracy approximations, see simd_avx2.hpp. the estimate only has 8 bits here, two newton steps */
+    inline float32x4_t rcp_nr_ps(float32x4_t d)
+    {
+        float32x4_t r = vrecpeq_f32(d);
+        r = vmulq_f32(r, vrecpsq_f32(d, r));
+        return vmulq_f32(r, vrecpsq_f32(d, r));
+    }
+
+    inline float32x4_t exp_poly_ps(float32x4_t x)
+    {
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(exp_poly_low)), vdupq_n_f32(exp_poly_high));
+
+        const float32x4_t t = vmulq_f32(x, vdupq_n_f32(1.44269504088896341f));
+        const float32x4_t n = vrndnq_f32(t);
+        const float32x4_t f = vsubq_f32(t, n);
+
+        float32x4_t p = vfmaq_f32(vdupq_n_f32(exp2_poly[2]), vdupq_n_f32(exp2_poly[3]), f);
+        p = vfmaq_f32(vdupq_n_f32(exp2_poly[1]), p, f);
+        p = vfmaq_f32(vdupq_n_f32(exp2_poly[0]), p, f);
+
+        return vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(p), vshlq_n_s32(vcvtq_s32_f32(n), 23)));
+    }
+
+    inline float32x4_t tanh_rational_ps(float32x4_t x)
+    {
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-tanh_rational_clamp)), vdupq_n_f32(tanh_rational_clamp));
+
+        const float32x4_t x2 = vmulq_f32(x, x);
+
+        float32x4_t p = vdupq_n_f32(tanh_rational_p[6]);
+        for (int i = 5; i >= 0; i--)
+            p = vfmaq_f32(vdupq_n_f32(tanh_rational_p[i]), p, x2);
+
+        float32x4_t q = vdupq_n_f32(tanh_rational_q[3]);
+        for (int i = 2; i >= 0; i--)
+            q = vfmaq_f32(vdupq_n_f32(tanh_rational_q[i]), q, x2);
+
+        return vmulq_f32(vmulq_f32(x, p), rcp_nr_ps(q));
+    }
+
+    struct sigmoid_poly_op
+    {
+        float32x4_t operator()(float32x4_t x) const { return rcp_nr_ps(vaddq_f32(vdupq_n_f32(1.0f), exp_poly_ps(vnegq_f32(x)))); }
+    };
+
+    struct tanh_poly_op
+    {
+        float32x4_t operator()(float32x4_t x) const
+        {
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            return vfmsq_f32(one, vdupq_n_f32(2.0f), rcp_nr_ps(vaddq_f32(one, exp_poly_ps(vaddq_f32(x, x)))));
+        }
+    };
+
+    struct sigmoid_rational_op
+    {
+        float32x4_t operator()(float32x4_t x) const
+        {
+            const float32x4_t half = vdupq_n_f32(0.5f);
+            return vfmaq_f32(half, half, tanh_rational_ps(vmulq_f32(half, x)));
+        }
+    };
+
+    struct tanh_rational_op
+    {
+        float32x4_t operator()(float32x4_t x) const { return tanh_rational_ps(x); }
+    };
+
+    /*------------------------------epilogues-------------------------------------*/
+    /* see simd_avx2.hpp, at() rebases the biases onto a column panel */
+    struct no_epilogue
+    {
+        float32x4_t operator()(float32x4_t x, size_t) const { return x; }
+        float operator()(float x, size_t) const { return x; }
+        no_epilogue at(size_t) const { return *this; }
+    };
+
+    template<typename Op>
+    struct bias_epilogue
+    {
+        const float* biases;
+        Op op;
+
+        float32x4_t operator()(float32x4_t x, size_t i) const { return op(vaddq_f32(x, vld1q_f32(&biases[i]))); }
+        float operator()(float x, size_t i) const { return vgetq_lane_f32(op(vdupq_n_f32(x + biases[i])), 0); }
+        bias_epilogue at(size_t first) const { return { &biases[first], op }; }
+    };
+
+    /* 4 columns per pass over the input, each input load feeds 4 fmas */
+    template<typename Epilogue>
+    inline void vec_mat_mul_apply(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, Epilogue epilogue)
+    {
+        const size_t leftover = m % 4;
+        const size_t end = m - leftover;
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const float* w = &inMatrix[i * m];
+            float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f), acc2 = vdupq_n_f32(0.0f), acc3 = vdupq_n_f32(0.0f);
+
+            for (size_t j = 0; j < end; j += 4)
+            {
+                const float32x4_t x = vld1q_f32(&inVec[j]);
+                acc0 = vfmaq_f32(acc0, x, vld1q_f32(&w[0 * m + j]));
+                acc1 = vfmaq_f32(acc1, x, vld1q_f32(&w[1 * m + j]));
+                acc2 = vfmaq_f32(acc2, x, vld1q_f32(&w[2 * m + j]));
+                acc3 = vfmaq_f32(acc3, x, vld1q_f32(&w[3 * m + j]));
+            }
+
+            float32x4_t result = reduce_4x4(acc0, acc1, acc2, acc3);
+
+            if (leftover)
+            {
+                float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (size_t c = 0; c < 4; c++)
+                    for (size_t j = end; j < m; j++)
+                        tail[c] += inVec[j] * w[c * m + j];
+
+                result = vaddq_f32(result, vld1q_f32(tail));
+            }
+
+            vst1q_f32(&outVec[i], epilogue(result, i));
+        }
+
+        for (; i < n; i++)
+        {
+            const float* w = &inMatrix[i * m];
+            float32x4_t acc = vdupq_n_f32(0.0f);
+
+            for (size_t j = 0; j < end; j += 4)
+                acc = vfmaq_f32(acc, vld1q_f32(&inVec[j]), vld1q_f32(&w[j]));
+
+            float result = vaddvq_f32(acc);
+            for (size_t j = end; j < m; j++)
+                result += inVec[j] * w[j];
+
+            outVec[i] = epilogue(result, i);
+        }
+    }
+
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, no_epilogue{});
+    }
+
+    /* column panels that fit in L2, the whole batch goes through a panel before moving on */
+    template<typename Epilogue>
+    inline void mat_mat_mul_apply(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const size_t panelColumns = std::max<size_t>(4ULL, (gemm_panel_size / std::max<size_t>(m, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t count = std::min(n - p, panelColumns);
+
+            for (size_t b = 0; b < batch; b++)
+                vec_mat_mul_apply(&inMat[b * inStride], &inMatrix[p * m], &outMat[b * outStride + p], m, count, epilogue.at(p));
+        }
+    }
+
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    /*------------------------------packed weights--------------------------------*/
+    /* the 16 results of one panel (4 q registers) into outVec[i, i + 16), see the avx2 version for the partial last panel */
+    template<typename Epilogue>
+    inline void store_panel(float* outVec, float32x4_t a0, float32x4_t a1, float32x4_t a2, float32x4_t a3, size_t i, size_t n, Epilogue epilogue)
+    {
+        if (i + packed_panel_width <= n)
+        {
+            vst1q_f32(&outVec[i], epilogue(a0, i));
+            vst1q_f32(&outVec[i + 4], epilogue(a1, i + 4));
+            vst1q_f32(&outVec[i + 8], epilogue(a2, i + 8));
+            vst1q_f32(&outVec[i + 12], epilogue(a3, i + 12));
+            return;
+        }
+
+        float tile[packed_panel_width];
+        vst1q_f32(tile, a0);
+        vst1q_f32(tile + 4, a1);
+        vst1q_f32(tile + 8, a2);
+        vst1q_f32(tile + 12, a3);
+
+        for (size_t c = 0; c < n - i; c++)
+            outVec[i + c] = epilogue(tile[c], i + c);
+    }
+
+    /* 4 samples against the panel starting at column i, 16 accumulators and 4 weight registers out of 32
+     * the inputs are multiplied by lane so there is no broadcast per sample
+     */
+    template<typename Epilogue>
+    inline void packed_4x1(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t i, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+        const float* x0 = &inMat[0 * inStride];
+        const float* x1 = &inMat[1 * inStride];
+        const float* x2 = &inMat[2 * inStride];
+        const float* x3 = &inMat[3 * inStride];
+
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t a00 = zero, a01 = zero, a02 = zero, a03 = zero, a10 = zero, a11 = zero, a12 = zero, a13 = zero;
+        float32x4_t a20 = zero, a21 = zero, a22 = zero, a23 = zero, a30 = zero, a31 = zero, a32 = zero, a33 = zero;
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const float* wj = &w[j * packed_panel_width];
+            const float32x4_t w0 = vld1q_f32(&wj[0]), w1 = vld1q_f32(&wj[4]), w2 = vld1q_f32(&wj[8]), w3 = vld1q_f32(&wj[12]);
+
+            /* input j of the 4 samples in one register */
+            float32x4_t in = vdupq_n_f32(x0[j]);
+            in = vsetq_lane_f32(x1[j], in, 1);
+            in = vsetq_lane_f32(x2[j], in, 2);
+            in = vsetq_lane_f32(x3[j], in, 3);
+
+            a00 = vfmaq_laneq_f32(a00, w0, in, 0); a01 = vfmaq_laneq_f32(a01, w1, in, 0); a02 = vfmaq_laneq_f32(a02, w2, in, 0); a03 = vfmaq_laneq_f32(a03, w3, in, 0);
+            a10 = vfmaq_laneq_f32(a10, w0, in, 1); a11 = vfmaq_laneq_f32(a11, w1, in, 1); a12 = vfmaq_laneq_f32(a12, w2, in, 1); a13 = vfmaq_laneq_f32(a13, w3, in, 1);
+            a20 = vfmaq_laneq_f32(a20, w0, in, 2); a21 = vfmaq_laneq_f32(a21, w1, in, 2); a22 = vfmaq_laneq_f32(a22, w2, in, 2); a23 = vfmaq_laneq_f32(a23, w3, in, 2);
+            a30 = vfmaq_laneq_f32(a30, w0, in, 3); a31 = vfmaq_laneq_f32(a31, w1, in, 3); a32 = vfmaq_laneq_f32(a32, w2, in, 3); a33 = vfmaq_laneq_f32(a33, w3, in, 3);
+        }
+
+        store_panel(&outMat[0 * outStride], a00, a01, a02, a03, i, n, epilogue);
+        store_panel(&outMat[1 * outStride], a10, a11, a12, a13, i, n, epilogue);
+        store_panel(&outMat[2 * outStride], a20, a21, a22, a23, i, n, epilogue);
+        store_panel(&outMat[3 * outStride], a30, a31, a32, a33, i, n, epilogue);
+    }
+
+    template<typename Epilogue>
+    inline void packed_1x1(const float* inVec, const float* inPacked, float* outVec, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t a0 = zero, a1 = zero, a2 = zero, a3 = zero;
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const float* wj = &w[j * packed_panel_width];
+            const float32x4_t in = vdupq_n_f32(inVec[j]);
+
+            a0 = vfmaq_f32(a0, in, vld1q_f32(&wj[0]));
+            a1 = vfmaq_f32(a1, in, vld1q_f32(&wj[4]));
+            a2 = vfmaq_f32(a2, in, vld1q_f32(&wj[8]));
+            a3 = vfmaq_f32(a3, in, vld1q_f32(&wj[12]));
+        }
+
+        store_panel(outVec, a0, a1, a2, a3, i, n, epilogue);
+    }
+
+    /* same contract as mat_mat_mul with inPacked from pack_weights, the whole batch goes through a panel before moving on */
+    template<typename Epilogue>
+    inline void mat_mat_mul_packed_apply(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        for (size_t i = 0; i < n; i += packed_panel_width)
+        {
+            size_t b = 0;
+            for (; b + 4 <= batch; b += 4)
+                packed_4x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, inStride, outStride, epilogue);
+
+            for (; b < batch; b++)
+                packed_1x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, epilogue);
+        }
+    }
+
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    inline void set_to_zero(float* inVec, size_t count)
+    {
+        size_t leftover = count % 4;
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            vst1q_f32(&inVec[i], vdupq_n_f32(0.0f));
+
+        for (size_t i = count - leftover; i < count; i++)
+            inVec[i] = 0.0f;
+    }
+
+    inline void set_range_value(float* inVec, size_t count, float value)
+    {
+        size_t leftover = count % 4;
+        const float32x4_t mValue = vdupq_n_f32(value);
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            vst1q_f32(&inVec[i], mValue);
+
+        for (size_t i = count - leftover; i < count; i++)
+            inVec[i] = value;
+    }
+
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset)
+    {
+        size_t leftover = count % 4;
+        const float32x4_t mScale = vdupq_n_f32(scale), mOffset = vdupq_n_f32(offset);
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            vst1q_f32(&ioVec[i], vfmaq_f32(mOffset, vld1q_f32(&ioVec[i]), mScale));
+
+        for (size_t i = count - leftover; i < count; i++)
+            ioVec[i] = ioVec[i] * scale + offset;
+    }
+
+    /*------------------------------int8------------------------------------------*/
+    inline int8_input quantize_input(const float* inVec, uint8_t* outVec, size_t m, size_t paddedM) { return scalar::quantize_input(inVec, outVec, m, paddedM); }
+
+    /* quantized inputs never go above 127, so they can be reinterpreted as signed
+     * and use the plain signed widening multiply, pairwise accumulated into int32
+     */
+    inline int32x4_t dot_i8(uint8x16_t x, const int8_t* w, int32x4_t acc)
+    {
+        const int8x16_t sx = vreinterpretq_s8_u8(x);
+        const int8x16_t sw = vld1q_s8(w);
+
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(sx), vget_low_s8(sw)));
+        return vpadalq_s16(acc, vmull_high_s8(sx, sw));
+    }
+
+    inline void vec_mat_mul_i8(const uint8_t* inVec, int8_input inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outVec, size_t paddedM, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const int8_t* w = &inMatrix[i * paddedM];
+            int32x4_t acc = vdupq_n_s32(0);
+
+            for (size_t j = 0; j < paddedM; j += 16)
+                acc = dot_i8(vld1q_u8(&inVec[j]), &w[j], acc);
+
+            int32_t dot = vaddvq_s32(acc) - inParams.zero_point * rowSums[i];
+            outVec[i] = float(dot) * inParams.scale * rowScales[i];
+        }
+    }
+
+    inline void mat_mat_mul_i8(const uint8_t* inMat, const int8_input* inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outMat, size_t paddedM, size_t n, size_t batch, size_t outStride)
+    {
+        const size_t panelColumns = std::max<size_t>(4ULL, (int8_panel_size / std::max<size_t>(paddedM, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t count = std::min(n - p, panelColumns);
+
+            for (size_t b = 0; b < batch; b++)
+                vec_mat_mul_i8(&inMat[b * paddedM], inParams[b], &inMatrix[p * paddedM], &rowScales[p], &rowSums[p], &outMat[b * outStride + p], paddedM, count);
+        }
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    /* applies op to outVec + inBiases 4 lanes at a time, the tail goes through a zero padded copy */
+    template<typename Op>
+    inline void add_bias_apply(float* outVec, const float* inBiases, size_t n, Op op)
+    {
+        const size_t leftover = n % 4;
+        const size_t end = n - leftover;
+
+        for (size_t i = 0; i < end; i+=4)
+            vst1q_f32(&outVec[i], op(vaddq_f32(vld1q_f32(&outVec[i]), vld1q_f32(&inBiases[i]))));
+
+        if (leftover)
+        {
+            float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (size_t i = 0; i < leftover; i++)
+                tail[i] = outVec[end + i] + inBiases[end + i];
+
+            vst1q_f32(tail, op(vld1q_f32(tail)));
+
+            for (size_t i = 0; i < leftover; i++)
+                outVec[end + i] = tail[i];
+        }
+    }
+
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, sigmoid_op{}); }
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, tanh_op{}); }
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, relu_op{}); }
+
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha)
+    {
+        add_bias_apply(outVec, inBiases, n, leaky_relu_op{ vdupq_n_f32(alpha) });
+    }
+
+    /* add_bias_* for any stateless op, how the kernel table binds the approximate sigmoid and tanh */
+    template<typename Op>
+    inline void add_bias_op(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, Op{}); }
+
+    /*------------------------------fused layer-----------------------------------*/
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { vdupq_n_f32(alpha) } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_bias_op(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------fused layer, packed weights-------------------*/
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { vdupq_n_f32(alpha) } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_packed_bias_op(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+}
+
+#endif
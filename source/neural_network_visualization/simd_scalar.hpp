@@ -0,0 +1,406 @@
+#pragma once
+
+#include "simd_common.hpp"
+
+#include <cstring>
+
+/* portable reference kernels, the fallback on every target and what the simd versions are checked against */
+namespace simd::scalar {
+
+    inline float accumulate(const float* inVec, size_t count)
+    {
+        float outValue = 0.0f;
+        for (size_t i = 0; i < count; i++)
+            outValue += inVec[i];
+
+        return outValue;
+    }
+
+    /*------------------------------activation ops--------------------------------*/
+    struct sigmoid_op
+    {
+        float operator()(float x) const { return 1.0f / (1.0f + (std::exp(-1.0f * x))); }
+    };
+
+    struct tanh_op
+    {
+        float operator()(float x) const { return std::tanh(x); }
+    };
+
+    struct relu_op
+    {
+        float operator()(float x) const { return std::max(x, 0.0f); }
+    };
+
+    /* bias only, regression outputs */
+    struct linear_op
+    {
+        float operator()(float x) const { return x; }
+    };
+
+    struct leaky_relu_op
+    {
+        float alpha;
+        float operator()(float x) const { return x > 0.0f ? x : x * alpha; }
+    };
+
+    /* the activation_accuracy approximations (see simd_common.hpp), the same formulas as the simd versions
+     * with a true division instead of the reciprocal estimate
+     */
+    inline float exp_poly(float x)
+    {
+        const float t = std::clamp(x, exp_poly_low, exp_poly_high) * 1.44269504088896341f;
+
+        /* halves round away from zero here, either way f stays within [-0.5, 0.5] */
+        const int32_t n = int32_t(t < 0.0f ? t - 0.5f : t + 0.5f);
+        const float f = t - float(n);
+
+        const float p = ((exp2_poly[3] * f + exp2_poly[2]) * f + exp2_poly[1]) * f + exp2_poly[0];
+
+        uint32_t bits;
+        std::memcpy(&bits, &p, sizeof(bits));
+        bits += uint32_t(n) << 23;
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    inline float tanh_rational(float x)
+    {
+        x = std::clamp(x, -tanh_rational_clamp, tanh_rational_clamp);
+        const float x2 = x * x;
+
+        float p = tanh_rational_p[6];
+        for (int i = 5; i >= 0; i--)
+            p = p * x2 + tanh_rational_p[i];
+
+        float q = tanh_rational_q[3];
+        for (int i = 2; i >= 0; i--)
+            q = q * x2 + tanh_rational_q[i];
+
+        return x * p / q;
+    }
+
+    struct sigmoid_poly_op
+    {
+        float operator()(float x) const { return 1.0f / (1.0f + exp_poly(-x)); }
+    };
+
+    /* tanh(x) == 1 - 2 / (exp(2x) + 1), saturates cleanly at both ends */
+    struct tanh_poly_op
+    {
+        float operator()(float x) const { return 1.0f - 2.0f / (1.0f + exp_poly(x + x)); }
+    };
+
+    struct sigmoid_rational_op
+    {
+        float operator()(float x) const { return 0.5f + 0.5f * tanh_rational(0.5f * x); }
+    };
+
+    struct tanh_rational_op
+    {
+        float operator()(float x) const { return tanh_rational(x); }
+    };
+
+    /* what the gemv/gemm kernels do to a finished dot product before storing it, see simd_avx2.hpp */
+    struct no_epilogue
+    {
+        float operator()(float x, size_t) const { return x; }
+    };
+
+    template<typename Op>
+    struct bias_epilogue
+    {
+        const float* biases;
+        Op op;
+
+        float operator()(float x, size_t i) const { return op(x + biases[i]); }
+    };
+
+    template<typename Epilogue>
+    inline void vec_mat_mul_apply(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, Epilogue epilogue)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            float result = 0.0f;
+            for (size_t j = 0; j < m; j++)
+            {
+                result += inVec[j] * inMatrix[i * m + j];
+            }
+            outVec[i] = epilogue(result, i);
+        }
+    }
+
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, no_epilogue{});
+    }
+
+    template<typename Epilogue>
+    inline void mat_mat_mul_apply(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        for (size_t b = 0; b < batch; b++)
+            vec_mat_mul_apply(&inMat[b * inStride], inMatrix, &outMat[b * outStride], m, n, epilogue);
+    }
+
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    /* panels from pack_weights, one sample at a time against packed_panel_width columns */
+    template<typename Epilogue>
+    inline void mat_mat_mul_packed_apply(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        for (size_t p = 0; p < n; p += packed_panel_width)
+        {
+            const float* panel = &inPacked[p * m];
+            const size_t columns = std::min(packed_panel_width, n - p);
+
+            for (size_t b = 0; b < batch; b++)
+            {
+                const float* x = &inMat[b * inStride];
+                float acc[packed_panel_width] = {};
+
+                for (size_t j = 0; j < m; j++)
+                {
+                    for (size_t c = 0; c < packed_panel_width; c++)
+                        acc[c] += x[j] * panel[j * packed_panel_width + c];
+                }
+
+                for (size_t c = 0; c < columns; c++)
+                    outMat[b * outStride + p + c] = epilogue(acc[c], p + c);
+            }
+        }
+    }
+
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    inline void set_to_zero(float* inVec, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            inVec[i] = 0.0f;
+    }
+
+    inline void set_range_value(float* inVec, size_t count, float value)
+    {
+        for (size_t i = 0; i < count; i++)
+            inVec[i] = value;
+    }
+
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset)
+    {
+        for (size_t i = 0; i < count; i++)
+            ioVec[i] = ioVec[i] * scale + offset;
+    }
+
+    /*------------------------------int8------------------------------------------*/
+    inline int8_input quantize_input(const float* inVec, uint8_t* outVec, size_t m, size_t paddedM)
+    {
+        float low = 0.0f, high = 0.0f;
+        for (size_t j = 0; j < m; j++)
+        {
+            low = std::min(low, inVec[j]);
+            high = std::max(high, inVec[j]);
+        }
+
+        int8_input params = int8_input_params(low, high);
+        const float inverseScale = 1.0f / params.scale;
+
+        for (size_t j = 0; j < m; j++)
+            outVec[j] = quantize_value(inVec[j], inverseScale, params.zero_point);
+
+        for (size_t j = m; j < paddedM; j++)
+            outVec[j] = 0;
+
+        return params;
+    }
+
+    inline void vec_mat_mul_i8(const uint8_t* inVec, int8_input inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outVec, size_t paddedM, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            int32_t dot = 0;
+            for (size_t j = 0; j < paddedM; j++)
+                dot += int32_t(inVec[j]) * int32_t(inMatrix[i * paddedM + j]);
+
+            dot -= inParams.zero_point * rowSums[i];
+            outVec[i] = float(dot) * inParams.scale * rowScales[i];
+        }
+    }
+
+    inline void mat_mat_mul_i8(const uint8_t* inMat, const int8_input* inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outMat, size_t paddedM, size_t n, size_t batch, size_t outStride)
+    {
+        for (size_t b = 0; b < batch; b++)
+            vec_mat_mul_i8(&inMat[b * paddedM], inParams[b], inMatrix, rowScales, rowSums, &outMat[b * outStride], paddedM, n);
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    template<typename Op>
+    inline void add_bias_apply(float* outVec, const float* inBiases, size_t n, Op op)
+    {
+        for (size_t i = 0; i < n; i++)
+            outVec[i] = op(outVec[i] + inBiases[i]);
+    }
+
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, sigmoid_op{}); }
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, tanh_op{}); }
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, relu_op{}); }
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha) { add_bias_apply(outVec, inBiases, n, leaky_relu_op{ alpha }); }
+
+    /* add_bias_* for any stateless op, how the kernel table binds the approximate sigmoid and tanh */
+    template<typename Op>
+    inline void add_bias_op(float* outVec, const float* inBiases, size_t n) { add_bias_apply(outVec, inBiases, n, Op{}); }
+
+    /*------------------------------fused layer-----------------------------------*/
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { alpha } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_bias_op(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------fused layer, packed weights-------------------*/
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { alpha } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_packed_bias_op(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------backward--------------------------------------*/
+    inline void mat_t_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        for (size_t b = 0; b < batch; b++)
+        {
+            const float* x = &inMat[b * inStride];
+            float* out = &outMat[b * outStride];
+
+            for (size_t j = 0; j < m; j++)
+                out[j] = 0.0f;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                for (size_t j = 0; j < m; j++)
+                    out[j] += x[i] * inMatrix[i * m + j];
+            }
+        }
+    }
+
+    inline void rank_k_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t batch, size_t xStride, size_t yStride, size_t matrixStride)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            float* row = &outMatrix[i * matrixStride];
+
+            for (size_t b = 0; b < batch; b++)
+            {
+                const float x = inX[b * xStride + i];
+                const float* y = &inY[b * yStride];
+
+                for (size_t j = 0; j < m; j++)
+                    row[j] += x * y[j];
+            }
+        }
+    }
+
+    inline void rank1_update(const float* inX, const float* inY, float* outMatrix, size_t m, size_t n, size_t matrixStride)
+    {
+        rank_k_update(inX, inY, outMatrix, m, n, 1, 0, 0, matrixStride);
+    }
+
+    inline void accumulate_rows(const float* inMat, float* outVec, size_t n, size_t batch, size_t inStride)
+    {
+        for (size_t b = 0; b < batch; b++)
+        {
+            for (size_t i = 0; i < n; i++)
+                outVec[i] += inMat[b * inStride + i];
+        }
+    }
+
+    /* derivatives from the activation's output, the same formulas as activation_functions.hpp */
+    struct sigmoid_derivative_op
+    {
+        float operator()(float delta, float y) const { return delta * y * (1.0f - y); }
+    };
+
+    struct tanh_derivative_op
+    {
+        float operator()(float delta, float y) const { return delta * (1.0f - y * y); }
+    };
+
+    struct relu_derivative_op
+    {
+        float operator()(float delta, float y) const { return y > 0.0f ? delta : 0.0f; }
+    };
+
+    struct leaky_relu_derivative_op
+    {
+        float alpha;
+        float operator()(float delta, float y) const { return y > 0.0f ? delta : delta * alpha; }
+    };
+
+    template<typename Op>
+    inline void mul_derivative_apply(float* ioDelta, const float* inOutputs, size_t n, Op op)
+    {
+        for (size_t i = 0; i < n; i++)
+            ioDelta[i] = op(ioDelta[i], inOutputs[i]);
+    }
+
+    inline void mul_derivative_sigmoid(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, sigmoid_derivative_op{}); }
+    inline void mul_derivative_tanh(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, tanh_derivative_op{}); }
+    inline void mul_derivative_relu(float* ioDelta, const float* inOutputs, size_t n) { mul_derivative_apply(ioDelta, inOutputs, n, relu_derivative_op{}); }
+
+    inline void mul_derivative_leaky_relu(float* ioDelta, const float* inOutputs, size_t n, float alpha)
+    {
+        mul_derivative_apply(ioDelta, inOutputs, n, leaky_relu_derivative_op{ alpha });
+    }
+}
@@ -0,0 +1,562 @@
+#pragma once
+
+#include "simd_scalar.hpp"
+
+#ifdef SIMD_X86
+
+#include <immintrin.h>
+
+/* 4-wide kernels for hosts without avx2/fma, compiled for sse4.2 regardless of the global compiler flags */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.2"))), apply_to = function)
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+
+namespace simd::sse42 {
+
+    inline float accumulate(__m128 inVec)
+    {
+        __m128 high = _mm_movehl_ps(inVec, inVec);
+        inVec = _mm_add_ps(inVec, high);
+        high = _mm_shuffle_ps(inVec, inVec, 0x1);
+
+        return _mm_cvtss_f32(_mm_add_ps(inVec, high));
+    }
+
+    inline float accumulate(const float* inVec, size_t count)
+    {
+        __m128 temp = _mm_setzero_ps();
+        size_t leftover = count % 4;
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            temp = _mm_add_ps(_mm_loadu_ps(&inVec[i]), temp);
+
+        float mValue = accumulate(temp);
+
+        for (size_t i = count - leftover; i < count; i++)
+            mValue += inVec[i];
+
+        return mValue;
+    }
+
+    /* horizontal sum of 4 accumulators, lane i of the result holds the sum of a_i */
+    inline __m128 reduce_4x4(__m128 a0, __m128 a1, __m128 a2, __m128 a3)
+    {
+        return _mm_hadd_ps(_mm_hadd_ps(a0, a1), _mm_hadd_ps(a2, a3));
+    }
+
+    /*------------------------------activation ops--------------------------------*/
+    /* no vectorized exp at this level, lane by lane through the scalar definitions */
+    template<typename Op>
+    inline __m128 per_lane(__m128 x, Op op)
+    {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, x);
+
+        for (size_t i = 0; i < 4; i++)
+            lanes[i] = op(lanes[i]);
+
+        return _mm_load_ps(lanes);
+    }
+
+    struct sigmoid_op
+    {
+        __m128 operator()(__m128 x) const { return per_lane(x, scalar::sigmoid_op{}); }
+        float operator()(float x) const { return scalar::sigmoid_op{}(x); }
+    };
+
+    struct tanh_op
+    {
+        __m128 operator()(__m128 x) const { return per_lane(x, scalar::tanh_op{}); }
+        float operator()(float x) const { return scalar::tanh_op{}(x); }
+    };
+
+    struct relu_op
+    {
+        __m128 operator()(__m128 x) const { return _mm_max_ps(x, _mm_setzero_ps()); }
+        float operator()(float x) const { return std::max(x, 0.0f); }
+    };
+
+    struct linear_op
+    {
+        __m128 operator()(__m128 x) const { return x; }
+        float operator()(float x) const { return x; }
+    };
+
+    struct leaky_relu_op
+    {
+        float alpha;
+
+        __m128 operator()(__m128 x) const { return _mm_blendv_ps(_mm_mul_ps(x, _mm_set1_ps(alpha)), x, _mm_cmpgt_ps(x, _mm_setzero_ps())); }
+        float operator()(float x) const { return x > 0.0f ? x : x * alpha; }
+    };
+
+    /* the activation_accuracy approximations are vectorized here, see simd_avx2.hpp, no fma so every step is a mul and an add
+     * the float overloads (tails of the fused kernels) are the scalar definitions
+     */
+    inline __m128 rcp_nr_ps(__m128 d)
+    {
+        const __m128 r = _mm_rcp_ps(d);
+        return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(d, r)));
+    }
+
+    inline __m128 exp_poly_ps(__m128 x)
+    {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(exp_poly_low)), _mm_set1_ps(exp_poly_high));
+
+        const __m128 t = _mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f));
+        const __m128 n = _mm_round_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m128 f = _mm_sub_ps(t, n);
+
+        __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(exp2_poly[3]), f), _mm_set1_ps(exp2_poly[2]));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(exp2_poly[1]));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(exp2_poly[0]));
+
+        return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(_mm_cvtps_epi32(n), 23)));
+    }
+
+    inline __m128 tanh_rational_ps(__m128 x)
+    {
+        const __m128 clamp = _mm_set1_ps(tanh_rational_clamp);
+        x = _mm_min_ps(_mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), clamp)), clamp);
+
+        const __m128 x2 = _mm_mul_ps(x, x);
+
+        __m128 p = _mm_set1_ps(tanh_rational_p[6]);
+        for (int i = 5; i >= 0; i--)
+            p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(tanh_rational_p[i]));
+
+        __m128 q = _mm_set1_ps(tanh_rational_q[3]);
+        for (int i = 2; i >= 0; i--)
+            q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(tanh_rational_q[i]));
+
+        return _mm_mul_ps(_mm_mul_ps(x, p), rcp_nr_ps(q));
+    }
+
+    struct sigmoid_poly_op
+    {
+        __m128 operator()(__m128 x) const { return rcp_nr_ps(_mm_add_ps(_mm_set1_ps(1.0f), exp_poly_ps(_mm_sub_ps(_mm_setzero_ps(), x)))); }
+        float operator()(float x) const { return scalar::sigmoid_poly_op{}(x); }
+    };
+
+    struct tanh_poly_op
+    {
+        __m128 operator()(__m128 x) const
+        {
+            const __m128 one = _mm_set1_ps(1.0f);
+            return _mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(2.0f), rcp_nr_ps(_mm_add_ps(one, exp_poly_ps(_mm_add_ps(x, x))))));
+        }
+
+        float operator()(float x) const { return scalar::tanh_poly_op{}(x); }
+    };
+
+    struct sigmoid_rational_op
+    {
+        __m128 operator()(__m128 x) const
+        {
+            const __m128 half = _mm_set1_ps(0.5f);
+            return _mm_add_ps(_mm_mul_ps(half, tanh_rational_ps(_mm_mul_ps(half, x))), half);
+        }
+
+        float operator()(float x) const { return scalar::sigmoid_rational_op{}(x); }
+    };
+
+    struct tanh_rational_op
+    {
+        __m128 operator()(__m128 x) const { return tanh_rational_ps(x); }
+        float operator()(float x) const { return scalar::tanh_rational_op{}(x); }
+    };
+
+    /*------------------------------epilogues-------------------------------------*/
+    /* see simd_avx2.hpp, at() rebases the biases onto a column panel */
+    struct no_epilogue
+    {
+        __m128 operator()(__m128 x, size_t) const { return x; }
+        float operator()(float x, size_t) const { return x; }
+        no_epilogue at(size_t) const { return *this; }
+    };
+
+    template<typename Op>
+    struct bias_epilogue
+    {
+        const float* biases;
+        Op op;
+
+        __m128 operator()(__m128 x, size_t i) const { return op(_mm_add_ps(x, _mm_loadu_ps(&biases[i]))); }
+        float operator()(float x, size_t i) const { return op(x + biases[i]); }
+        bias_epilogue at(size_t first) const { return { &biases[first], op }; }
+    };
+
+    /* same contract as the avx2 version, 4 columns per pass over the input */
+    template<typename Epilogue>
+    inline void vec_mat_mul_apply(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n, Epilogue epilogue)
+    {
+        const size_t leftover = m % 4;
+        const size_t end = m - leftover;
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const float* w = &inMatrix[i * m];
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 4)
+            {
+                const __m128 x = _mm_loadu_ps(&inVec[j]);
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(x, _mm_loadu_ps(&w[0 * m + j])));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(x, _mm_loadu_ps(&w[1 * m + j])));
+                acc2 = _mm_add_ps(acc2, _mm_mul_ps(x, _mm_loadu_ps(&w[2 * m + j])));
+                acc3 = _mm_add_ps(acc3, _mm_mul_ps(x, _mm_loadu_ps(&w[3 * m + j])));
+            }
+
+            __m128 result = reduce_4x4(acc0, acc1, acc2, acc3);
+
+            if (leftover)
+            {
+                alignas(16) float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (size_t c = 0; c < 4; c++)
+                    for (size_t j = end; j < m; j++)
+                        tail[c] += inVec[j] * w[c * m + j];
+
+                result = _mm_add_ps(result, _mm_load_ps(tail));
+            }
+
+            _mm_storeu_ps(&outVec[i], epilogue(result, i));
+        }
+
+        for (; i < n; i++)
+        {
+            const float* w = &inMatrix[i * m];
+            __m128 acc = _mm_setzero_ps();
+
+            for (size_t j = 0; j < end; j += 4)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(&inVec[j]), _mm_loadu_ps(&w[j])));
+
+            float result = accumulate(acc);
+            for (size_t j = end; j < m; j++)
+                result += inVec[j] * w[j];
+
+            outVec[i] = epilogue(result, i);
+        }
+    }
+
+    inline void vec_mat_mul(const float* inVec, const float* inMatrix, float* outVec, size_t m, size_t n)
+    {
+        vec_mat_mul_apply(inVec, inMatrix, outVec, m, n, no_epilogue{});
+    }
+
+    /* column panels that fit in L2, the whole batch goes through a panel before moving on */
+    template<typename Epilogue>
+    inline void mat_mat_mul_apply(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        const size_t panelColumns = std::max<size_t>(4ULL, (gemm_panel_size / std::max<size_t>(m, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t count = std::min(n - p, panelColumns);
+
+            for (size_t b = 0; b < batch; b++)
+                vec_mat_mul_apply(&inMat[b * inStride], &inMatrix[p * m], &outMat[b * outStride + p], m, count, epilogue.at(p));
+        }
+    }
+
+    inline void mat_mat_mul(const float* inMat, const float* inMatrix, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    /*------------------------------packed weights--------------------------------*/
+    /* the 16 results of one panel (4 registers) into outVec[i, i + 16), see the avx2 version for the partial last panel */
+    template<typename Epilogue>
+    inline void store_panel(float* outVec, __m128 a0, __m128 a1, __m128 a2, __m128 a3, size_t i, size_t n, Epilogue epilogue)
+    {
+        if (i + packed_panel_width <= n)
+        {
+            _mm_storeu_ps(&outVec[i], epilogue(a0, i));
+            _mm_storeu_ps(&outVec[i + 4], epilogue(a1, i + 4));
+            _mm_storeu_ps(&outVec[i + 8], epilogue(a2, i + 8));
+            _mm_storeu_ps(&outVec[i + 12], epilogue(a3, i + 12));
+            return;
+        }
+
+        alignas(16) float tile[packed_panel_width];
+        _mm_store_ps(tile, a0);
+        _mm_store_ps(tile + 4, a1);
+        _mm_store_ps(tile + 8, a2);
+        _mm_store_ps(tile + 12, a3);
+
+        for (size_t c = 0; c < n - i; c++)
+            outVec[i + c] = epilogue(tile[c], i + c);
+    }
+
+    /* 2 samples against the panel starting at column i, 8 accumulators and the 4 weight registers out of 16 */
+    template<typename Epilogue>
+    inline void packed_2x1(const float* x0, const float* x1, const float* inPacked, float* out0, float* out1, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+
+        __m128 a00 = _mm_setzero_ps(), a01 = _mm_setzero_ps(), a02 = _mm_setzero_ps(), a03 = _mm_setzero_ps();
+        __m128 a10 = _mm_setzero_ps(), a11 = _mm_setzero_ps(), a12 = _mm_setzero_ps(), a13 = _mm_setzero_ps();
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const float* wj = &w[j * packed_panel_width];
+            const __m128 w0 = _mm_loadu_ps(&wj[0]), w1 = _mm_loadu_ps(&wj[4]), w2 = _mm_loadu_ps(&wj[8]), w3 = _mm_loadu_ps(&wj[12]);
+
+            const __m128 in0 = _mm_set1_ps(x0[j]);
+            a00 = _mm_add_ps(a00, _mm_mul_ps(in0, w0)); a01 = _mm_add_ps(a01, _mm_mul_ps(in0, w1));
+            a02 = _mm_add_ps(a02, _mm_mul_ps(in0, w2)); a03 = _mm_add_ps(a03, _mm_mul_ps(in0, w3));
+
+            const __m128 in1 = _mm_set1_ps(x1[j]);
+            a10 = _mm_add_ps(a10, _mm_mul_ps(in1, w0)); a11 = _mm_add_ps(a11, _mm_mul_ps(in1, w1));
+            a12 = _mm_add_ps(a12, _mm_mul_ps(in1, w2)); a13 = _mm_add_ps(a13, _mm_mul_ps(in1, w3));
+        }
+
+        store_panel(out0, a00, a01, a02, a03, i, n, epilogue);
+        store_panel(out1, a10, a11, a12, a13, i, n, epilogue);
+    }
+
+    template<typename Epilogue>
+    inline void packed_1x1(const float* inVec, const float* inPacked, float* outVec, size_t m, size_t n, size_t i, Epilogue epilogue)
+    {
+        const float* w = &inPacked[i * m];
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+
+        for (size_t j = 0; j < m; j++)
+        {
+            const float* wj = &w[j * packed_panel_width];
+            const __m128 in = _mm_set1_ps(inVec[j]);
+
+            a0 = _mm_add_ps(a0, _mm_mul_ps(in, _mm_loadu_ps(&wj[0])));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(in, _mm_loadu_ps(&wj[4])));
+            a2 = _mm_add_ps(a2, _mm_mul_ps(in, _mm_loadu_ps(&wj[8])));
+            a3 = _mm_add_ps(a3, _mm_mul_ps(in, _mm_loadu_ps(&wj[12])));
+        }
+
+        store_panel(outVec, a0, a1, a2, a3, i, n, epilogue);
+    }
+
+    /* same contract as mat_mat_mul with inPacked from pack_weights, the whole batch goes through a panel before moving on */
+    template<typename Epilogue>
+    inline void mat_mat_mul_packed_apply(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        Epilogue epilogue)
+    {
+        for (size_t i = 0; i < n; i += packed_panel_width)
+        {
+            size_t b = 0;
+            for (; b + 2 <= batch; b += 2)
+                packed_2x1(&inMat[b * inStride], &inMat[(b + 1) * inStride], inPacked, &outMat[b * outStride], &outMat[(b + 1) * outStride], m, n, i, epilogue);
+
+            if (b < batch)
+                packed_1x1(&inMat[b * inStride], inPacked, &outMat[b * outStride], m, n, i, epilogue);
+        }
+    }
+
+    inline void mat_mat_mul_packed(const float* inMat, const float* inPacked, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, no_epilogue{});
+    }
+
+    inline void set_to_zero(float* inVec, size_t count)
+    {
+        size_t leftover = count % 4;
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            _mm_storeu_ps(&inVec[i], _mm_setzero_ps());
+
+        for (size_t i = count - leftover; i < count; i++)
+            inVec[i] = 0.0f;
+    }
+
+    inline void set_range_value(float* inVec, size_t count, float value)
+    {
+        size_t leftover = count % 4;
+        __m128 mValue = _mm_set1_ps(value);
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            _mm_storeu_ps(&inVec[i], mValue);
+
+        for (size_t i = count - leftover; i < count; i++)
+            inVec[i] = value;
+    }
+
+    inline void scale_offset(float* ioVec, size_t count, float scale, float offset)
+    {
+        size_t leftover = count % 4;
+        const __m128 mScale = _mm_set1_ps(scale), mOffset = _mm_set1_ps(offset);
+
+        for (size_t i = 0; i < (count - leftover); i+=4)
+            _mm_storeu_ps(&ioVec[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&ioVec[i]), mScale), mOffset));
+
+        for (size_t i = count - leftover; i < count; i++)
+            ioVec[i] = ioVec[i] * scale + offset;
+    }
+
+    /*------------------------------int8------------------------------------------*/
+    inline int8_input quantize_input(const float* inVec, uint8_t* outVec, size_t m, size_t paddedM) { return scalar::quantize_input(inVec, outVec, m, paddedM); }
+
+    /* 16 unsigned x 16 signed bytes, the ssse3 half of the avx2 dot_i8 */
+    inline __m128i dot_i8(__m128i x, const int8_t* w, __m128i acc)
+    {
+        const __m128i products = _mm_maddubs_epi16(x, _mm_loadu_si128((const __m128i*)w));
+        return _mm_add_epi32(acc, _mm_madd_epi16(products, _mm_set1_epi16(1)));
+    }
+
+    inline void vec_mat_mul_i8(const uint8_t* inVec, int8_input inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outVec, size_t paddedM, size_t n)
+    {
+        const __m128 inScale = _mm_set1_ps(inParams.scale);
+        const __m128i zeroPoint = _mm_set1_epi32(inParams.zero_point);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const int8_t* w = &inMatrix[i * paddedM];
+            __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128(), acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+
+            for (size_t j = 0; j < paddedM; j += 16)
+            {
+                const __m128i x = _mm_loadu_si128((const __m128i*)&inVec[j]);
+                acc0 = dot_i8(x, &w[0 * paddedM + j], acc0);
+                acc1 = dot_i8(x, &w[1 * paddedM + j], acc1);
+                acc2 = dot_i8(x, &w[2 * paddedM + j], acc2);
+                acc3 = dot_i8(x, &w[3 * paddedM + j], acc3);
+            }
+
+            __m128i dots = _mm_hadd_epi32(_mm_hadd_epi32(acc0, acc1), _mm_hadd_epi32(acc2, acc3));
+            dots = _mm_sub_epi32(dots, _mm_mullo_epi32(zeroPoint, _mm_loadu_si128((const __m128i*)&rowSums[i])));
+
+            __m128 scales = _mm_mul_ps(_mm_loadu_ps(&rowScales[i]), inScale);
+            _mm_storeu_ps(&outVec[i], _mm_mul_ps(_mm_cvtepi32_ps(dots), scales));
+        }
+
+        if (i < n)
+            scalar::vec_mat_mul_i8(inVec, inParams, &inMatrix[i * paddedM], &rowScales[i], &rowSums[i], &outVec[i], paddedM, n - i);
+    }
+
+    inline void mat_mat_mul_i8(const uint8_t* inMat, const int8_input* inParams, const int8_t* inMatrix, const float* rowScales, const int32_t* rowSums,
+        float* outMat, size_t paddedM, size_t n, size_t batch, size_t outStride)
+    {
+        const size_t panelColumns = std::max<size_t>(4ULL, (int8_panel_size / std::max<size_t>(paddedM, 1ULL)) & ~size_t(3));
+
+        for (size_t p = 0; p < n; p += panelColumns)
+        {
+            const size_t count = std::min(n - p, panelColumns);
+
+            for (size_t b = 0; b < batch; b++)
+                vec_mat_mul_i8(&inMat[b * paddedM], inParams[b], &inMatrix[p * paddedM], &rowScales[p], &rowSums[p], &outMat[b * outStride + p], paddedM, count);
+        }
+    }
+
+    /*------------------------------activations-----------------------------------*/
+    inline void add_bias_relu(float* outVec, const float* inBiases, size_t n)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        size_t leftover = n % 4;
+
+        for (size_t i = 0; i < (n - leftover); i+=4)
+            _mm_storeu_ps(&outVec[i], _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&outVec[i]), _mm_loadu_ps(&inBiases[i])), zero));
+
+        for (size_t i = n - leftover; i < n; i++)
+            outVec[i] = std::max(outVec[i] + inBiases[i], 0.0f);
+    }
+
+    inline void add_bias_leaky_relu(float* outVec, const float* inBiases, size_t n, float alpha)
+    {
+        const __m128 zero = _mm_setzero_ps(), mAlpha = _mm_set1_ps(alpha);
+        size_t leftover = n % 4;
+
+        for (size_t i = 0; i < (n - leftover); i+=4)
+        {
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(&outVec[i]), _mm_loadu_ps(&inBiases[i]));
+            _mm_storeu_ps(&outVec[i], _mm_blendv_ps(_mm_mul_ps(sum, mAlpha), sum, _mm_cmpgt_ps(sum, zero)));
+        }
+
+        scalar::add_bias_leaky_relu(&outVec[n - leftover], &inBiases[n - leftover], leftover, alpha);
+    }
+
+    /* no vectorized exp at this level, these are the scalar ones */
+    inline void add_bias_sigmoid(float* outVec, const float* inBiases, size_t n) { scalar::add_bias_sigmoid(outVec, inBiases, n); }
+    inline void add_bias_tanh(float* outVec, const float* inBiases, size_t n) { scalar::add_bias_tanh(outVec, inBiases, n); }
+
+    /* add_bias_* for any stateless op, how the kernel table binds the approximate sigmoid and tanh */
+    template<typename Op>
+    inline void add_bias_op(float* outVec, const float* inBiases, size_t n)
+    {
+        const Op op;
+        size_t leftover = n % 4;
+
+        for (size_t i = 0; i < (n - leftover); i+=4)
+            _mm_storeu_ps(&outVec[i], op(_mm_add_ps(_mm_loadu_ps(&outVec[i]), _mm_loadu_ps(&inBiases[i]))));
+
+        for (size_t i = n - leftover; i < n; i++)
+            outVec[i] = op(outVec[i] + inBiases[i]);
+    }
+
+    /*------------------------------fused layer-----------------------------------*/
+    inline void mat_mat_mul_bias_sigmoid(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_tanh(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_bias_leaky_relu(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { alpha } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_bias_op(const float* inMat, const float* inMatrix, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_apply(inMat, inMatrix, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+
+    /*------------------------------fused layer, packed weights-------------------*/
+    inline void mat_mat_mul_packed_bias_sigmoid(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<sigmoid_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_tanh(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<tanh_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<relu_op>{ inBiases, {} });
+    }
+
+    inline void mat_mat_mul_packed_bias_leaky_relu(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride,
+        float alpha)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<leaky_relu_op>{ inBiases, { alpha } });
+    }
+
+    template<typename Op>
+    inline void mat_mat_mul_packed_bias_op(const float* inMat, const float* inPacked, const float* inBiases, float* outMat, size_t m, size_t n, size_t batch, size_t inStride, size_t outStride)
+    {
+        mat_mat_mul_packed_apply(inMat, inPacked, outMat, m, n, batch, inStride, outStride, bias_epilogue<Op>{ inBiases, {} });
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(APP_COMPILER_GNUC) || defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
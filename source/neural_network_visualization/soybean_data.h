@@ -2,46 +2,181 @@
 
 #include <gensou/core.h>
 
-/* just a helper to load our soybean data */
-inline std::vector<float> load_soybean_series(const std::string& path, bool normalize, uint32_t obervationCount = 0)
+#include "simd.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+/* one column of a csv file as a series of floats, parsed straight from the file's buffer
+ * rows are fed in chunks that end on a line boundary, nothing is allocated per row and the range is tracked while parsing,
+ * so the only pass over the values after it is the (simd) normalization
+ */
+struct csv_series_reader
+{
+	/* zero based, fields are comma separated */
+	uint32_t column = 0;
+
+	float min = std::numeric_limits<float>::max();
+	float max = std::numeric_limits<float>::lowest();
+
+	/* rows seen, rows that had no number in the column (a header line is not counted) */
+	size_t rows = 0, skipped = 0;
+
+	/* appends the column of every row in [begin, end) to outSeries, a row cut at end is parsed as is */
+	void parse(const char* begin, const char* end, std::vector<float>& outSeries)
+	{
+		for(const char* line = begin; line < end;)
+		{
+			const char* lineEnd = (const char*)std::memchr(line, '\n', end - line);
+			if(!lineEnd)
+				lineEnd = end;
+
+			parse_row(line, lineEnd, outSeries);
+			line = lineEnd + 1;
+		}
+	}
+
+	/* (value - min) / (max - min) in place, a constant series becomes all zeros */
+	void normalize(float* ioSeries, size_t count) const
+	{
+		if(!count)
+			return;
+
+		const float range = max - min;
+		const float scale = range > 0.0f ? 1.0f / range : 0.0f;
+
+		simd::scale_offset(ioSeries, count, scale, -min * scale);
+	}
+
+private:
+	void parse_row(const char* field, const char* lineEnd, std::vector<float>& outSeries)
+	{
+		/* blank lines (and windows line endings on them) are not rows */
+		if(field == lineEnd || (*field == '\r' && field + 1 == lineEnd))
+			return;
+
+		rows++;
+
+		for(uint32_t c = 0; c < column && field; c++)
+		{
+			field = (const char*)std::memchr(field, ',', lineEnd - field);
+			if(field)
+				field++;
+		}
+
+		float value = 0.0f;
+		bool parsed = false;
+
+		if(field)
+		{
+			/* from_chars takes neither leading blanks, quotes nor a '+' */
+			while(field < lineEnd && (*field == ' ' || *field == '\t' || *field == '"' || *field == '+'))
+				field++;
+
+			parsed = parse_float(field, lineEnd, value);
+		}
+
+		if(!parsed)
+		{
+			/* the first row is allowed to be a header */
+			if(rows > 1)
+				skipped++;
+
+			return;
+		}
+
+		min = std::min(min, value);
+		max = std::max(max, value);
+		outSeries.push_back(value);
+	}
+
+	/* the number at the start of [first, last), true if there is one in range */
+	static bool parse_float(const char* first, const char* last, float& outValue)
+	{
+#if defined(__cpp_lib_to_chars) || !defined(_LIBCPP_VERSION)
+		return std::from_chars(first, last, outValue).ec == std::errc();
+#else
+		/* libc++ only has the integral from_chars before llvm 17 and the pinned ndk (25) ships llvm 14
+		 * strtof wants a terminated string and the field is a view into the file, it parses a copy of it on the stack
+		 */
+		char buffer[64];
+		size_t length = 0;
+
+		while(first + length < last && length < sizeof(buffer) - 1 && first[length] != ',' && first[length] != '\r')
+		{
+			buffer[length] = first[length];
+			length++;
+		}
+
+		buffer[length] = '\0';
+
+		char* parsedEnd = nullptr;
+		errno = 0;
+		outValue = std::strtof(buffer, &parsedEnd);
+
+		return parsedEnd != buffer && errno != ERANGE;
+#endif
+	}
+};
+
+struct csv_series_options
 {
-    auto gsData = gs::system::load_file(path);
-    if(!gsData)
-        std::vector<float>();
+	uint32_t column = 0;
+	bool normalize = false;
+
+	/* capacity to reserve, 0 estimates it from the first chunk */
+	size_t observation_count = 0;
+};
+
+/* the whole file is in memory already, chunks only let the series be reserved once from the first one's row density */
+inline std::vector<float> load_csv_series(const std::string& path, const csv_series_options& options = {})
+{
+	static constexpr size_t s_first_chunk_bytes = 64 * 1024;
+
+	auto gsData = gs::system::load_file(path);
+	if(!gsData)
+	{
+		LOG(error, "failed to load series file %s", path.c_str());
+		return std::vector<float>();
+	}
+
+	const char* begin = (const char*)gsData->data();
+	const char* end = begin + gsData->size();
 
-    auto streamBuffer = gsData->data_as_buffer_stream();
-    std::istream csv_stream(&streamBuffer);
+	/* the first chunk ends on a line boundary */
+	const char* chunkEnd = end;
+	if(gsData->size() > s_first_chunk_bytes)
+	{
+		chunkEnd = (const char*)std::memchr(begin + s_first_chunk_bytes, '\n', end - (begin + s_first_chunk_bytes));
+		chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+	}
 
-    if (csv_stream.fail())
-        LOG(error, "failed to load file soybean data");
+	csv_series_reader reader;
+	reader.column = options.column;
 
-    std::string line;
+	std::vector<float> outData;
+	outData.reserve(options.observation_count ? options.observation_count : 1024);
 
-    std::vector<float> outData;
-    outData.reserve(obervationCount ? obervationCount : 1024);
+	reader.parse(begin, chunkEnd, outData);
 
-    while (std::getline(csv_stream, line))
-        outData.emplace_back(std::stof(line));
+	if(chunkEnd < end)
+	{
+		/* a few percent over the first chunk's density, growth covers the rest */
+		if(!options.observation_count)
+			outData.reserve(size_t(double(outData.size()) * double(end - begin) / double(chunkEnd - begin) * 1.05) + 16);
 
-    /* release any extra memory if needed */
-    outData.shrink_to_fit();
+		reader.parse(chunkEnd, end, outData);
+	}
 
-    if(normalize)
-    {
-        float min = std::numeric_limits<float>::max();
-        float max = 0.0f;
+	if(reader.skipped)
+		LOG(warn, "%zu of %zu rows of %s have no number in column %u", reader.skipped, reader.rows, path.c_str(), options.column);
 
-        for(auto f : outData)
-        {
-            min = std::min(f, min);
-            max = std::max(f, max);
-        }
-        
-        for(auto& f : outData)
-            f = (f - min) / (max - min);
-    }
+	if(options.normalize)
+		reader.normalize(outData.data(), outData.size());
 
-    LOG(trace, "loaded data size == %zu", outData.size());
+	LOG(trace, "loaded data size == %zu", outData.size());
 
-    return outData;
+	return outData;
 }
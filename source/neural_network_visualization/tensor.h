@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <memory>
+#include <new>
+
+/* every tensor row starts on a cache line and holds a whole number of the widest simd register (16 floats)
+ * padding is always zero, so kernels can run over padded rows without any remainder handling
+ */
+static constexpr size_t tensor_alignment = 64;
+static constexpr size_t tensor_row_multiple = tensor_alignment / sizeof(float);
+
+constexpr size_t padded_row(size_t count) { return (count + tensor_row_multiple - 1) & ~(tensor_row_multiple - 1); }
+
+inline bool is_tensor_aligned(const void* ptr) { return (reinterpret_cast<uintptr_t>(ptr) & (tensor_alignment - 1)) == 0; }
+
+/* owning, 64-byte aligned and zero initialized floats */
+class aligned_buffer
+{
+public:
+	aligned_buffer() = default;
+	explicit aligned_buffer(size_t count) { resize(count); }
+
+	/* does not keep the old contents, the whole buffer is zeroed */
+	void resize(size_t count)
+	{
+		m_data.reset(count ? static_cast<float*>(::operator new(padded_row(count) * sizeof(float), std::align_val_t(tensor_alignment))) : nullptr);
+		m_size = count;
+
+		if(count)
+			memset(m_data.get(), 0, padded_row(count) * sizeof(float));
+	}
+
+	void clear() { m_data.reset(); m_size = 0; }
+
+	float* data() { return m_data.get(); }
+	const float* data() const { return m_data.get(); }
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	float& operator[](size_t index) { return m_data[index]; }
+	const float& operator[](size_t index) const { return m_data[index]; }
+
+	float* begin() { return m_data.get(); }
+	float* end() { return m_data.get() + m_size; }
+	const float* begin() const { return m_data.get(); }
+	const float* end() const { return m_data.get() + m_size; }
+
+private:
+	struct aligned_delete
+	{
+		void operator()(float* ptr) const { ::operator delete(ptr, std::align_val_t(tensor_alignment)); }
+	};
+
+	std::unique_ptr<float[], aligned_delete> m_data;
+	size_t m_size = 0;
+};
+
+/* non-owning rows x cols floats, row i starts at ptr + i * stride
+ * stride is padded_row(cols) for everything the model owns
+ */
+struct tensor_view
+{
+	const float* ptr = nullptr;
+	uint32_t rows = 0, cols = 0;
+	size_t stride = 0;
+
+	const float* data() const { return ptr; }
+	const float* row(size_t i) const { return ptr + i * stride; }
+
+	const float& operator()(size_t i, size_t j) const { return ptr[i * stride + j]; }
+
+	/* floats spanned, padding included */
+	size_t size() const { return rows * stride; }
+	bool empty() const { return rows == 0; }
+};
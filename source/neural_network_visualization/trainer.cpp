@@ -0,0 +1,292 @@
+#include "trainer.h"
+#include "model.h"
+
+#include <numeric>
+
+bool trainer::attach(const model& inModel, const float* series, size_t count, const training_config& config)
+{
+    detach();
+
+    if(inModel.layout.empty())
+        return false;
+
+    const size_t inputCount = inModel.input_count();
+    const size_t outputCount = inModel.output_count();
+
+    if(count < inputCount + outputCount)
+    {
+        LOG(error, "failed to start training, %zu observations for windows of %zu inputs and %zu outputs", count, inputCount, outputCount);
+        return false;
+    }
+
+    const uint32_t layerCount = (uint32_t)inModel.layout.size();
+    const size_t sampleCount = count - inputCount - outputCount + 1;
+
+    m_model = &inModel;
+    m_series = series;
+    m_config = config;
+    m_config.batch_size = (uint32_t)std::clamp<size_t>(config.batch_size, 1, sampleCount);
+
+    /* the model's padded blobs are contiguous, biases of every layer and then weights of every layer */
+    m_bias_total = inModel.get_bias_offset(layerCount);
+    const size_t parameterCount = m_bias_total + inModel.get_weight_offset(layerCount);
+
+    m_parameters.resize(parameterCount);
+    memcpy(m_parameters.data(), inModel.layer_biases(0), m_bias_total * sizeof(float));
+    memcpy(&m_parameters[m_bias_total], inModel.layer_weights(0).data(), (parameterCount - m_bias_total) * sizeof(float));
+
+    /* never more shards than threads to run them, the calling thread included */
+    m_shard_capacity = gs::system::get_worker_count() + 1;
+    m_gradients.resize(m_shard_capacity * parameterCount);
+    m_shard_losses.assign(m_shard_capacity, 0.0f);
+
+    m_first_moment.resize(parameterCount);
+    m_second_moment.resize(parameterCount);
+
+    m_arena.resize(inModel.batch_arena_size(m_config.batch_size));
+    m_deltas.resize(inModel.batch_arena_size(m_config.batch_size));
+
+    m_random.seed(m_config.seed);
+    m_permutation.resize(sampleCount);
+    std::iota(m_permutation.begin(), m_permutation.end(), 0u);
+    std::shuffle(m_permutation.begin(), m_permutation.end(), m_random);
+
+    LOG(info, "training on %zu samples, minibatches of %u, %s at %g", sampleCount, m_config.batch_size,
+        m_config.optimizer == optimizer_type::adam ? "adam" : "sgd", m_config.learning_rate);
+
+    return true;
+}
+
+void trainer::detach()
+{
+    m_model = nullptr;
+    m_series = nullptr;
+    m_stats = {};
+
+    m_parameters.clear();
+    m_gradients.clear();
+    m_first_moment.clear();
+    m_second_moment.clear();
+    m_arena.clear();
+    m_deltas.clear();
+    m_shard_losses.clear();
+
+    m_permutation.clear();
+    m_cursor = 0;
+    m_epoch_error = 0.0;
+    m_epoch_samples = 0;
+}
+
+float trainer::step()
+{
+    if(!m_model)
+        return 0.0f;
+
+    /* an epoch always ends on a (possibly shorter) minibatch of its own */
+    const size_t batch = std::min<size_t>(m_config.batch_size, m_permutation.size() - m_cursor);
+    const size_t outputCount = m_model->output_count();
+    const uint32_t shardCount = (uint32_t)std::clamp<size_t>(batch / s_min_samples_per_shard, 1, m_shard_capacity);
+
+    /* dL/dy of the mean squared error over every output of the minibatch */
+    const float errorScale = 2.0f / float(batch * outputCount);
+
+    gs::system::parallel_for(0, shardCount, 1, [&](size_t first, size_t last)
+    {
+        for(size_t shard = first; shard < last; shard++)
+            m_shard_losses[shard] = run_shard((uint32_t)shard, batch * shard / shardCount, batch * (shard + 1) / shardCount, errorScale);
+    });
+
+    float squaredError = 0.0f;
+    for(uint32_t shard = 0; shard < shardCount; shard++)
+        squaredError += m_shard_losses[shard];
+
+    m_stats.steps++;
+    m_stats.batch_loss = squaredError / float(batch * outputCount);
+
+    /* adam's bias correction folded into the step size */
+    float stepSize = m_config.learning_rate;
+    if(m_config.optimizer == optimizer_type::adam)
+    {
+        const double t = double(m_stats.steps);
+        stepSize *= float(std::sqrt(1.0 - std::pow(double(m_config.beta2), t)) / (1.0 - std::pow(double(m_config.beta1), t)));
+    }
+
+    gs::system::parallel_for(0, m_parameters.size(), s_min_parameters_per_task, [&](size_t first, size_t last)
+    {
+        apply_gradients(first, last, shardCount, stepSize);
+    });
+
+    m_cursor += batch;
+    m_epoch_error += squaredError;
+    m_epoch_samples += batch;
+
+    if(m_cursor == m_permutation.size())
+    {
+        m_stats.epochs++;
+        m_stats.epoch_loss = float(m_epoch_error / double(m_epoch_samples * outputCount));
+
+        m_cursor = 0;
+        m_epoch_error = 0.0;
+        m_epoch_samples = 0;
+        std::shuffle(m_permutation.begin(), m_permutation.end(), m_random);
+    }
+
+    return m_stats.batch_loss;
+}
+
+void trainer::run(uint32_t stepCount)
+{
+    for(uint32_t i = 0; i < stepCount; i++)
+        step();
+}
+
+void trainer::publish(model& outModel) const
+{
+    if(&outModel != m_model)
+    {
+        LOG(error, "trainer was not attached to this model");
+        return;
+    }
+
+    outModel.assign_parameters(m_parameters.data(), &m_parameters[m_bias_total]);
+}
+
+float trainer::run_shard(uint32_t shard, size_t first, size_t last, float errorScale)
+{
+    const model& inModel = *m_model;
+    const uint32_t layerCount = (uint32_t)inModel.layout.size();
+    const size_t inputCount = inModel.input_count();
+    const size_t outputCount = inModel.output_count();
+    const size_t stride = inModel.arena_stride();
+    const size_t count = last - first;
+
+    const uint32_t* samples = &m_permutation[m_cursor + first];
+    float* arena = &m_arena[first * stride];
+    float* deltas = &m_deltas[first * stride];
+
+    const float* parameters = m_parameters.data();
+    float* gradients = &m_gradients[shard * m_parameters.size()];
+    memset(gradients, 0, m_parameters.size() * sizeof(float));
+
+    /*------------------------------forward---------------------------------------*/
+    /* the same fused kernels as inference, unpacked since the weights change every step
+     * every padding column is computed as well, the next layer's padding weights are zero
+     */
+    const size_t inputPadding = padded_row(inputCount) - inputCount;
+
+    for(size_t b = 0; b < count; b++)
+    {
+        memcpy(&arena[b * stride], &m_series[samples[b]], inputCount * sizeof(float));
+        memset(&arena[b * stride + inputCount], 0, inputPadding * sizeof(float));
+    }
+
+    for(uint32_t layer = 0; layer < layerCount; layer++)
+    {
+        const auto [rowCount, columnCount] = inModel.layout[layer];
+
+        inModel.get_layer_activation(layer).mat_mat_mul_bias_activation(&arena[inModel.get_arena_offset(layer)],
+            &parameters[m_bias_total + inModel.get_weight_offset(layer)], &parameters[inModel.get_bias_offset(layer)],
+            &arena[inModel.get_arena_offset(layer + 1)], padded_row(rowCount), padded_row(columnCount), count, stride, stride);
+    }
+
+    /*------------------------------output error----------------------------------*/
+    const layer_activation& outputActivation = inModel.get_layer_activation(layerCount - 1);
+    const size_t outputOffset = inModel.get_arena_offset(layerCount);
+    float squaredError = 0.0f;
+
+    for(size_t b = 0; b < count; b++)
+    {
+        const float* targets = &m_series[samples[b] + inputCount];
+        const float* outputs = &arena[b * stride + outputOffset];
+        float* outputDeltas = &deltas[b * stride + outputOffset];
+
+        for(size_t i = 0; i < outputCount; i++)
+        {
+            const float error = outputs[i] - targets[i];
+
+            squaredError += error * error;
+            outputDeltas[i] = errorScale * error;
+        }
+
+        outputActivation.mul_derivative(outputDeltas, outputs, outputCount);
+    }
+
+    /*------------------------------backward--------------------------------------*/
+    /* only the real rows and columns get gradients, the padding of every blob stays zero */
+    for(uint32_t layer = layerCount; layer-- > 0;)
+    {
+        const auto [rowCount, columnCount] = inModel.layout[layer];
+        const size_t rowStride = padded_row(rowCount);
+        const size_t inOffset = inModel.get_arena_offset(layer);
+        const size_t outOffset = inModel.get_arena_offset(layer + 1);
+
+        const float* weights = &parameters[m_bias_total + inModel.get_weight_offset(layer)];
+        float* weightGradients = &gradients[m_bias_total + inModel.get_weight_offset(layer)];
+        float* biasGradients = &gradients[inModel.get_bias_offset(layer)];
+
+        /* dW += delta^T * inputs and db += delta over the shard */
+        simd::rank_k_update(&deltas[outOffset], &arena[inOffset], weightGradients, rowCount, columnCount, count, stride, stride, rowStride);
+        simd::accumulate_rows(&deltas[outOffset], biasGradients, columnCount, count, stride);
+
+        if(!layer)
+            break;
+
+        /* the previous layer's error: W^T * delta, then its activation's derivative at the cached outputs
+         * the padding columns of W are zero, so are the padding deltas they produce
+         */
+        const layer_activation& previousActivation = inModel.get_layer_activation(layer - 1);
+
+        simd::mat_t_mat_mul(&deltas[outOffset], weights, &deltas[inOffset], rowStride, columnCount, count, stride, stride);
+
+        for(size_t b = 0; b < count; b++)
+            previousActivation.mul_derivative(&deltas[b * stride + inOffset], &arena[b * stride + inOffset], rowCount);
+    }
+
+    return squaredError;
+}
+
+void trainer::apply_gradients(size_t first, size_t last, uint32_t shardCount, float stepSize)
+{
+    const size_t parameterCount = m_parameters.size();
+    float* parameters = m_parameters.data();
+    float* gradients = m_gradients.data();
+
+    /* every shard's gradients into the first one's */
+    for(uint32_t shard = 1; shard < shardCount; shard++)
+    {
+        const float* shardGradients = &m_gradients[shard * parameterCount];
+        for(size_t k = first; k < last; k++)
+            gradients[k] += shardGradients[k];
+    }
+
+    float* firstMoment = m_first_moment.data();
+    float* secondMoment = m_second_moment.data();
+
+    if(m_config.optimizer == optimizer_type::adam)
+    {
+        const float beta1 = m_config.beta1, beta2 = m_config.beta2;
+
+        for(size_t k = first; k < last; k++)
+        {
+            const float gradient = gradients[k];
+
+            firstMoment[k] = beta1 * firstMoment[k] + (1.0f - beta1) * gradient;
+            secondMoment[k] = beta2 * secondMoment[k] + (1.0f - beta2) * gradient * gradient;
+            parameters[k] -= stepSize * firstMoment[k] / (std::sqrt(secondMoment[k]) + m_config.epsilon);
+        }
+    }
+    else if(m_config.momentum > 0.0f)
+    {
+        /* the first moment is the velocity */
+        for(size_t k = first; k < last; k++)
+        {
+            firstMoment[k] = m_config.momentum * firstMoment[k] + gradients[k];
+            parameters[k] -= stepSize * firstMoment[k];
+        }
+    }
+    else
+    {
+        for(size_t k = first; k < last; k++)
+            parameters[k] -= stepSize * gradients[k];
+    }
+}
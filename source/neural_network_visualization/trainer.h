@@ -0,0 +1,114 @@
+#pragma once
+
+#include "tensor.h"
+
+#include <random>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class model;
+
+enum class optimizer_type : uint32_t { sgd = 0, adam };
+
+struct training_config
+{
+	optimizer_type optimizer = optimizer_type::adam;
+	float learning_rate = 1e-3f;
+
+	/* sgd only, 0 is plain sgd */
+	float momentum = 0.0f;
+
+	/* adam only */
+	float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+
+	/* samples per step, drawn without replacement from a permutation reshuffled every epoch */
+	uint32_t batch_size = 64;
+	uint32_t seed = 1;
+};
+
+struct training_stats
+{
+	uint64_t steps = 0;
+	uint32_t epochs = 0;
+
+	/* mean squared error of the last minibatch and over the last complete epoch */
+	float batch_loss = 0.0f, epoch_loss = 0.0f;
+};
+
+/* minibatch backpropagation on a copy of a model's parameters, next-value regression over a series:
+ * sample t is the window series[t, t + input_count) and its targets the output_count values right after it
+ * forward passes keep every layer's activations in an arena laid out like the model's (see model::get_arena_offset),
+ * the backward pass reads them back through each layer_activation's mul_derivative and the simd backward kernels
+ * a minibatch is split in shards over the engine's thread pool, each shard accumulates its own gradients
+ * and the reduction is fused with the optimizer update
+ * the model is only read (layout, activations, parameters on attach), publish hands the trained parameters back
+ */
+class trainer
+{
+public:
+	/* copies the model's parameters, series has to outlive the trainer (or the next attach)
+	 * returns false when the model is empty or the series is shorter than one sample
+	 */
+	bool attach(const model& inModel, const float* series, size_t count, const training_config& config = {});
+	void detach();
+
+	bool attached() const { return m_model != nullptr; }
+
+	/* one minibatch: forward, backward and an optimizer update, returns the minibatch loss */
+	float step();
+	void run(uint32_t stepCount);
+
+	/* copies the trained parameters into the model it was attached to (see model::assign_parameters)
+	 * neither step nor inference on that model may run meanwhile
+	 */
+	void publish(model& outModel) const;
+
+	/* not synchronized with step, read them in between */
+	const training_stats& stats() const { return m_stats; }
+
+	uint32_t sample_count() const { return (uint32_t)m_permutation.size(); }
+
+private:
+	/* samples [first, last) of the current minibatch into shard's gradients, errorScale is dL/dy per unit of error
+	 * returns their summed squared error
+	 */
+	float run_shard(uint32_t shard, size_t first, size_t last, float errorScale);
+
+	/* sums every shard's gradients into the first one's and applies the optimizer to parameters [first, last) */
+	void apply_gradients(size_t first, size_t last, uint32_t shardCount, float stepSize);
+
+private:
+	/* below this a shard costs more to schedule than to run */
+	static constexpr size_t s_min_samples_per_shard = 8;
+
+	/* parameters per reduction task */
+	static constexpr size_t s_min_parameters_per_task = 8192;
+
+	const model* m_model = nullptr;
+	training_config m_config;
+	training_stats m_stats;
+
+	const float* m_series = nullptr;
+
+	/* biases then weights, both padded exactly like the model's (get_bias_offset, get_weight_offset) */
+	aligned_buffer m_parameters;
+	size_t m_bias_total = 0;
+
+	/* one gradient blob per shard, m_parameters.size() floats each, and the optimizer's moments */
+	aligned_buffer m_gradients;
+	uint32_t m_shard_capacity = 0;
+	aligned_buffer m_first_moment, m_second_moment;
+
+	/* batch_size samples each, activations and the error terms (dL/dz) of every layer at the same offsets */
+	aligned_buffer m_arena, m_deltas;
+	std::vector<float> m_shard_losses;
+
+	/* sample indices of the current epoch, the minibatch is the batch_size of them from m_cursor */
+	std::vector<uint32_t> m_permutation;
+	size_t m_cursor = 0;
+	double m_epoch_error = 0.0;
+	size_t m_epoch_samples = 0;
+
+	std::mt19937 m_random;
+};
@@ -49,6 +49,74 @@ void application_widgets::on_init()
 	orbitTextPos.x = orbitTogglePosition.x + rectSize.x * 1.0f;
 	orbitTextPos.y = orbitTogglePosition.y;
 
+	/*---------------------int8-toggle---------------------------------------*/
+	m_int8_toggle = add_subobject("int8 toogle");
+	auto& int8Toggle = m_int8_toggle.add_component<gs::toggle_switch_component>();
+	int8Toggle.set_rect(rectSize);
+	int8Toggle.handle_scale = orbitToggle.handle_scale;
+	int8Toggle.user_data = this;
+	int8Toggle.set_off();
+
+	m_int8_toggle.get_component<gs::anchor_component>().set(gs::anchor::top_left);
+
+	auto& int8TogglePosition = m_int8_toggle.get_component<gs::transform_component>().translation;
+	int8TogglePosition.x = rectSize.x * 1.0f;
+	int8TogglePosition.y = rectSize.y * (supportsNonVsync ? 6.0f : 4.0f);
+
+	int8Toggle.on_toggle_action = [](gs::toggle_switch_component* toggle, gs::scene* scene, bool on, void* data)
+	{
+		auto appScene = static_cast<application_scene*>(scene);
+		appScene->set_int8_inference(on);
+	};
+
+	/*------------------int8-text--------------------------------*/
+	m_int8_text = add_subobject("int8 text");
+	auto& int8Text = m_int8_text.add_component<gs::text_component>();
+	int8Text.text = "Int8 weights";
+	int8Text.text_size_dynamic = true;
+	int8Text.font_size = fontSize;
+	int8Text.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	m_int8_text.get_component<gs::anchor_component>().set(gs::anchor::top_left);
+
+	auto& int8TextPos = m_int8_text.get_component<gs::transform_component>().translation;
+	int8TextPos.x = int8TogglePosition.x + rectSize.x * 1.0f;
+	int8TextPos.y = int8TogglePosition.y;
+
+	/*---------------------training-toggle-----------------------------------*/
+	m_training_toggle = add_subobject("training toogle");
+	auto& trainingToggle = m_training_toggle.add_component<gs::toggle_switch_component>();
+	trainingToggle.set_rect(rectSize);
+	trainingToggle.handle_scale = orbitToggle.handle_scale;
+	trainingToggle.user_data = this;
+	trainingToggle.set_off();
+
+	m_training_toggle.get_component<gs::anchor_component>().set(gs::anchor::top_left);
+
+	auto& trainingTogglePosition = m_training_toggle.get_component<gs::transform_component>().translation;
+	trainingTogglePosition.x = rectSize.x * 1.0f;
+	trainingTogglePosition.y = int8TogglePosition.y + rectSize.y * 2.0f;
+
+	trainingToggle.on_toggle_action = [](gs::toggle_switch_component* toggle, gs::scene* scene, bool on, void* data)
+	{
+		auto appScene = static_cast<application_scene*>(scene);
+		appScene->set_training(on);
+	};
+
+	/*------------------training-text--------------------------------*/
+	m_training_text = add_subobject("training text");
+	auto& trainingText = m_training_text.add_component<gs::text_component>();
+	trainingText.text = "Train on series";
+	trainingText.text_size_dynamic = true;
+	trainingText.font_size = fontSize;
+	trainingText.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	m_training_text.get_component<gs::anchor_component>().set(gs::anchor::top_left);
+
+	auto& trainingTextPos = m_training_text.get_component<gs::transform_component>().translation;
+	trainingTextPos.x = trainingTogglePosition.x + rectSize.x * 1.0f;
+	trainingTextPos.y = trainingTogglePosition.y;
+
 	/*---------------------vsyn-toggle---------------------------------------*/
 	if (supportsNonVsync)
 	{
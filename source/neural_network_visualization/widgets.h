@@ -17,4 +17,10 @@ private:
 
 	gs::game_object m_orbit_toggle;
 	gs::game_object m_orbit_text;
+
+	gs::game_object m_int8_toggle;
+	gs::game_object m_int8_text;
+
+	gs::game_object m_training_toggle;
+	gs::game_object m_training_text;
 };
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "core/gensou_file_format.h"
+#include "core/lz4_block.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/*
+ * compresses a gensou file into its compressed form (see gensou_file_format.h), or back with -d
+ * usage: asset_compressor [-d] <input.gsasset> <output.gsasset>
+ * the uuid is kept, system::load_file decodes the payload transparently. a payload that doesn't shrink by at least
+ * s_min_saving is written back raw, not worth a decode at load time
+ * binary models are meant to be mapped and used in place, compress csv models and raw data instead
+ */
+
+static constexpr double s_min_saving = 0.1;
+
+/* lz4 block format limits: matches are at least 4 bytes and reach back at most 65535 bytes,
+ * the last match starts 12 bytes before the end at the latest and the last 5 bytes are always literals
+ */
+static constexpr size_t s_min_match = 4;
+static constexpr size_t s_max_offset = 65535;
+static constexpr size_t s_match_start_limit = 12;
+static constexpr size_t s_last_literals = 5;
+static constexpr uint32_t s_hash_bits = 16;
+
+static uint32_t read_u32(const uint8_t* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static void write_length(std::vector<uint8_t>& out, size_t length)
+{
+	for(; length >= 255; length -= 255)
+		out.push_back(255);
+
+	out.push_back((uint8_t)length);
+}
+
+static void write_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+{
+	const size_t matchCode = matchLength ? matchLength - s_min_match : 0;
+
+	out.push_back(uint8_t((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+	if(literalCount >= 15)
+		write_length(out, literalCount - 15);
+
+	out.insert(out.end(), literals, literals + literalCount);
+
+	/* the last sequence has no match */
+	if(!matchLength)
+		return;
+
+	out.push_back(uint8_t(offset));
+	out.push_back(uint8_t(offset >> 8));
+
+	if(matchCode >= 15)
+		write_length(out, matchCode - 15);
+}
+
+/* greedy single pass, a hash of the next 4 bytes to the last position they were seen at */
+static std::vector<uint8_t> lz4_compress_block(const uint8_t* src, size_t size)
+{
+	std::vector<uint8_t> out;
+	out.reserve(size + size / 255 + 16);
+
+	std::vector<uint32_t> lastSeen(size_t(1) << s_hash_bits, UINT32_MAX);
+	auto hash = [](uint32_t sequence) { return (sequence * 2654435761u) >> (32 - s_hash_bits); };
+
+	size_t anchor = 0, position = 0;
+	while(size > s_match_start_limit && position <= size - s_match_start_limit)
+	{
+		const uint32_t sequence = read_u32(src + position);
+		const uint32_t h = hash(sequence);
+
+		const size_t candidate = lastSeen[h];
+		lastSeen[h] = (uint32_t)position;
+
+		if(candidate == UINT32_MAX || position - candidate > s_max_offset || read_u32(src + candidate) != sequence)
+		{
+			position++;
+			continue;
+		}
+
+		size_t matchLength = s_min_match;
+		while(position + matchLength < size - s_last_literals && src[candidate + matchLength] == src[position + matchLength])
+			matchLength++;
+
+		write_sequence(out, src + anchor, position - anchor, position - candidate, matchLength);
+
+		position += matchLength;
+		anchor = position;
+	}
+
+	write_sequence(out, src + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>& outData)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		return false;
+
+	outData.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static bool write_file(const char* path, const std::vector<uint8_t>& header, const uint8_t* payload, size_t payloadSize)
+{
+	std::ofstream file(path, std::ios::binary);
+	if(!file)
+		return false;
+
+	file.write((const char*)header.data(), header.size());
+	file.write((const char*)payload, payloadSize);
+
+	return file.good();
+}
+
+static int compress(const std::vector<uint8_t>& data, const char* outputPath)
+{
+	if(data.size() < gensou_header_size || memcmp(data.data(), gensou_magic, 4) != 0)
+	{
+		std::fprintf(stderr, "input is not a raw gensou file\n");
+		return 1;
+	}
+
+	const uint8_t* payload = data.data() + gensou_header_size;
+	const size_t payloadSize = data.size() - gensou_header_size;
+
+	std::vector<uint8_t> encoded = lz4_compress_block(payload, payloadSize);
+
+	/* every block written is decoded back before it ever reaches the engine */
+	std::vector<uint8_t> check(payloadSize);
+	if(!lz4_decompress_block(encoded.data(), encoded.size(), check.data(), check.size()) || memcmp(check.data(), payload, payloadSize) != 0)
+	{
+		std::fprintf(stderr, "compressed payload doesn't decode back, nothing written\n");
+		return 1;
+	}
+
+	if(double(encoded.size() + gensou_compressed_header_size) > double(payloadSize + gensou_header_size) * (1.0 - s_min_saving))
+	{
+		std::printf("%zu -> %zu bytes is not worth it, written raw\n", payloadSize, encoded.size());
+
+		std::vector<uint8_t> header(data.begin(), data.begin() + gensou_header_size);
+		return write_file(outputPath, header, payload, payloadSize) ? 0 : 1;
+	}
+
+	gensou_compressed_header compressedHeader;
+	memcpy(&compressedHeader.id, data.data() + 4, sizeof(compressedHeader.id));
+	compressedHeader.codec = gensou_codec::lz4;
+	compressedHeader.raw_size = payloadSize;
+
+	std::vector<uint8_t> header(gensou_compressed_header_size);
+	write_gensou_compressed_header(compressedHeader, header.data());
+
+	if(!write_file(outputPath, header, encoded.data(), encoded.size()))
+	{
+		std::fprintf(stderr, "failed to write '%s'\n", outputPath);
+		return 1;
+	}
+
+	std::printf("%zu -> %zu bytes (%.1f%%)\n", payloadSize, encoded.size(), 100.0 * double(encoded.size()) / double(payloadSize ? payloadSize : 1));
+	return 0;
+}
+
+static int decompress(const std::vector<uint8_t>& data, const char* outputPath)
+{
+	gensou_compressed_header compressedHeader;
+	if(!read_gensou_compressed_header(data.data(), data.size(), compressedHeader) || compressedHeader.codec != gensou_codec::lz4)
+	{
+		std::fprintf(stderr, "input is not an lz4 compressed gensou file\n");
+		return 1;
+	}
+
+	const size_t encodedSize = data.size() - gensou_compressed_header_size;
+	if(compressedHeader.raw_size > (uint64_t)encodedSize * gensou_lz4_max_ratio)
+	{
+		std::fprintf(stderr, "input claims a raw size of %llu bytes, corrupted\n", (unsigned long long)compressedHeader.raw_size);
+		return 1;
+	}
+
+	std::vector<uint8_t> payload((size_t)compressedHeader.raw_size);
+	if(!lz4_decompress_block(data.data() + gensou_compressed_header_size, encodedSize, payload.data(), payload.size()))
+	{
+		std::fprintf(stderr, "input doesn't decode, corrupted\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> header(gensou_header_size);
+	memcpy(header.data(), gensou_magic, 4);
+	memcpy(header.data() + 4, &compressedHeader.id, sizeof(compressedHeader.id));
+
+	if(!write_file(outputPath, header, payload.data(), payload.size()))
+	{
+		std::fprintf(stderr, "failed to write '%s'\n", outputPath);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const bool decode = argc == 4 && strcmp(argv[1], "-d") == 0;
+	if(argc != 3 && !decode)
+	{
+		std::fprintf(stderr, "usage: %s [-d] <input.gsasset> <output.gsasset>\n", argv[0]);
+		return 1;
+	}
+
+	const char* inputPath = argv[argc - 2];
+	const char* outputPath = argv[argc - 1];
+
+	std::vector<uint8_t> data;
+	if(!read_file(inputPath, data))
+	{
+		std::fprintf(stderr, "failed to read '%s'\n", inputPath);
+		return 1;
+	}
+
+	return decode ? decompress(data, outputPath) : compress(data, outputPath);
+}
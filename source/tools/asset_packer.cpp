@@ -0,0 +1,195 @@
+#include "core/asset_archive_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * packs asset directories into one archive (see asset_archive_format.h), mounted by the engine at startup
+ * usage: asset_packer <output.gspak> <[prefix=]directory>...
+ * every file under a directory is stored as prefix/relative/path, the prefix defaults to the directory as given, e.g.
+ * asset_packer resources.gspak resources
+ * asset_packer engine_res.gspak engine_res=source/gensou_engine/res
+ * blobs are sorted by path, so the files of a directory are next to each other in the archive
+ */
+
+namespace fs = std::filesystem;
+
+struct packed_file
+{
+	std::string path;
+	fs::path source;
+	uint64_t size = 0;
+	uint64_t offset = 0;
+};
+
+static uint64_t align_up(uint64_t offset, uint64_t alignment) { return (offset + alignment - 1) & ~(alignment - 1); }
+
+static bool collect_files(const std::string& argument, std::vector<packed_file>& outFiles)
+{
+	std::string prefix = argument, directory = argument;
+	if(size_t separator = argument.find('='); separator != std::string::npos)
+	{
+		prefix = argument.substr(0, separator);
+		directory = argument.substr(separator + 1);
+	}
+
+	/* the same form the application asks for, forward slashes and no trailing one */
+	prefix = fs::path(prefix).generic_string();
+	while(!prefix.empty() && prefix.back() == '/')
+		prefix.pop_back();
+
+	std::error_code error;
+	if(!fs::is_directory(directory, error))
+	{
+		std::fprintf(stderr, "'%s' is not a directory\n", directory.c_str());
+		return false;
+	}
+
+	for(const auto& entry : fs::recursive_directory_iterator(directory, error))
+	{
+		if(!entry.is_regular_file() || entry.path().filename().string()[0] == '.')
+			continue;
+
+		packed_file file;
+		file.source = entry.path();
+		file.size = entry.file_size();
+		file.path = fs::relative(entry.path(), directory).generic_string();
+
+		if(!prefix.empty())
+			file.path = prefix + "/" + file.path;
+
+		outFiles.push_back(std::move(file));
+	}
+
+	if(error)
+	{
+		std::fprintf(stderr, "failed to list '%s', %s\n", directory.c_str(), error.message().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3)
+	{
+		std::fprintf(stderr, "usage: %s <output.gspak> <[prefix=]directory>...\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<packed_file> files;
+	for(int i = 2; i < argc; i++)
+	{
+		if(!collect_files(argv[i], files))
+			return 1;
+	}
+
+	std::sort(files.begin(), files.end(), [](const packed_file& a, const packed_file& b) { return a.path < b.path; });
+
+	for(size_t i = 1; i < files.size(); i++)
+	{
+		if(files[i].path == files[i - 1].path)
+		{
+			std::fprintf(stderr, "'%s' is packed twice ('%s' and '%s')\n", files[i].path.c_str(), files[i - 1].source.string().c_str(), files[i].source.string().c_str());
+			return 1;
+		}
+	}
+
+	/*------------------------------layout----------------------------------------*/
+	archive_header header;
+	header.entry_count = (uint32_t)files.size();
+
+	/* at most half full */
+	header.table_size = 1;
+	while(header.table_size < 2 * files.size())
+		header.table_size <<= 1;
+
+	header.table_offset = sizeof(archive_header);
+	header.names_offset = header.table_offset + header.table_size * sizeof(archive_entry);
+
+	std::string names;
+	std::vector<archive_entry> table(header.table_size);
+
+	for(const packed_file& file : files)
+	{
+		const uint64_t hash = archive_path_hash(file.path);
+
+		uint32_t slot = uint32_t(hash & (header.table_size - 1));
+		while(table[slot].path_hash)
+			slot = (slot + 1) & (header.table_size - 1);
+
+		table[slot].path_hash = hash;
+		table[slot].name_offset = (uint32_t)names.size();
+		table[slot].name_size = (uint32_t)file.path.size();
+		table[slot].size = file.size;
+
+		names += file.path;
+	}
+
+	header.names_size = names.size();
+	header.data_offset = align_up(header.names_offset + header.names_size, archive_blob_alignment);
+
+	/* every file starts aligned, as it would at the start of its own mapping */
+	uint64_t cursor = header.data_offset;
+	for(packed_file& file : files)
+	{
+		file.offset = align_up(cursor, archive_blob_alignment);
+		cursor = file.offset + file.size;
+	}
+
+	for(archive_entry& entry : table)
+	{
+		if(!entry.path_hash)
+			continue;
+
+		const std::string_view name(&names[entry.name_offset], entry.name_size);
+		entry.offset = std::find_if(files.begin(), files.end(), [&](const packed_file& file) { return file.path == name; })->offset;
+	}
+
+	/*------------------------------write-----------------------------------------*/
+	std::ofstream archive(argv[1], std::ios::binary);
+	if(!archive)
+	{
+		std::fprintf(stderr, "failed to create '%s'\n", argv[1]);
+		return 1;
+	}
+
+	archive.write((const char*)&header, sizeof(header));
+	archive.write((const char*)table.data(), table.size() * sizeof(archive_entry));
+	archive.write(names.data(), names.size());
+
+	std::vector<char> blob;
+	uint64_t written = header.names_offset + header.names_size;
+
+	for(const packed_file& file : files)
+	{
+		std::ifstream source(file.source, std::ios::binary);
+		blob.resize(file.size);
+
+		if(!source.read(blob.data(), blob.size()))
+		{
+			std::fprintf(stderr, "failed to read '%s'\n", file.source.string().c_str());
+			return 1;
+		}
+
+		static const char padding[archive_blob_alignment] = {};
+		archive.write(padding, file.offset - written);
+		archive.write(blob.data(), blob.size());
+
+		written = file.offset + file.size;
+	}
+
+	if(!archive.good())
+	{
+		std::fprintf(stderr, "failed to write '%s'\n", argv[1]);
+		return 1;
+	}
+
+	std::printf("packed %zu files into '%s', %llu bytes\n", files.size(), argv[1], (unsigned long long)written);
+	return 0;
+}
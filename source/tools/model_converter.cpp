@@ -0,0 +1,132 @@
+#include "model_format.h"
+
+#include <cstdio>
+#include <fstream>
+
+/*
+ * converts a csv model (.gsasset) into the binary model container
+ * usage: model_converter <input.gsasset> <output.gsasset> [activations]
+ * activations is one name for every layer or a comma separated list with one per layer (relu,relu,linear),
+ * out of relu, leaky_relu[:alpha], sigmoid, tanh and linear. it overrides the csv's own activations line
+ * the output keeps the input's uuid, it is the same asset in another form
+ */
+
+static bool read_gensou_file(const char* path, uint64_t& outId, std::vector<uint8_t>& outPayload)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		return false;
+
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	/* 4-byte AOTO magic + 8-byte uuid */
+	if(data.size() < model_payload_offset || memcmp(data.data(), "AOTO", 4) != 0)
+		return false;
+
+	memcpy(&outId, data.data() + 4, sizeof(outId));
+	outPayload.assign(data.begin() + model_payload_offset, data.end());
+	return true;
+}
+
+static bool write_gensou_file(const char* path, uint64_t id, const std::vector<uint8_t>& payload)
+{
+	std::ofstream file(path, std::ios::binary);
+	if(!file)
+		return false;
+
+	file.write("AOTO", 4);
+	file.write((const char*)&id, sizeof(id));
+	file.write((const char*)payload.data(), payload.size());
+
+	return file.good();
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3)
+	{
+		std::fprintf(stderr, "usage: %s <input.gsasset> <output.gsasset> [relu|leaky_relu[:alpha]|sigmoid|tanh|linear, one or one per layer]\n", argv[0]);
+		return 1;
+	}
+
+	uint64_t id = 0;
+	std::vector<uint8_t> payload;
+	if(!read_gensou_file(argv[1], id, payload))
+	{
+		std::fprintf(stderr, "'%s' is not a gensou file\n", argv[1]);
+		return 1;
+	}
+
+	if(is_model_binary(payload.data(), payload.size()))
+	{
+		std::fprintf(stderr, "'%s' is already a binary model\n", argv[1]);
+		return 1;
+	}
+
+	std::string text(payload.begin(), payload.end());
+	std::istringstream csvStream(text);
+
+	std::vector<uint32_t> layerSizes;
+	std::vector<float> biases, weights;
+	std::vector<model_layer_activation> activations;
+
+	if(const char* error = parse_model_csv(csvStream, layerSizes, biases, weights, activations))
+	{
+		std::fprintf(stderr, "failed to parse '%s', %s\n", argv[1], error);
+		return 1;
+	}
+
+	if(argc > 3)
+	{
+		std::vector<model_layer_activation> overrides;
+		std::stringstream names(argv[3]);
+		std::string name;
+
+		while(std::getline(names, name, ','))
+		{
+			if(!parse_model_activation(name, overrides.emplace_back()))
+			{
+				std::fprintf(stderr, "unknown activation '%s'\n", name.c_str());
+				return 1;
+			}
+		}
+
+		if(overrides.size() == 1)
+			overrides.resize(activations.size(), overrides.front());
+
+		if(overrides.size() != activations.size())
+		{
+			std::fprintf(stderr, "%zu activations for %zu layers\n", overrides.size(), activations.size());
+			return 1;
+		}
+
+		activations = overrides;
+	}
+
+	/* make sure the blobs match the layout before writing anything */
+	size_t expectedBiases = 0, expectedWeights = 0;
+	model_blob_sizes(layerSizes.data(), uint32_t(layerSizes.size() - 1), false, expectedBiases, expectedWeights);
+
+	if(biases.size() != expectedBiases || weights.size() != expectedWeights)
+	{
+		std::fprintf(stderr, "'%s' does not match its layout (biases %zu/%zu, weights %zu/%zu)\n",
+			argv[1], biases.size(), expectedBiases, weights.size(), expectedWeights);
+		return 1;
+	}
+
+	auto binary = serialize_model_binary(layerSizes, biases.data(), weights.data(), activations);
+
+	if(!write_gensou_file(argv[2], id, binary))
+	{
+		std::fprintf(stderr, "failed to write '%s'\n", argv[2]);
+		return 1;
+	}
+
+	std::printf("%s -> %s | %zu layers, %zu biases, %zu weights, %zu bytes\n",
+		argv[1], argv[2], layerSizes.size() - 1, biases.size(), weights.size(), binary.size() + model_payload_offset);
+
+	for(size_t i = 0; i < activations.size(); i++)
+		std::printf("  layer %zu: %u -> %u, %s\n", i, layerSizes[i], layerSizes[i + 1], model_activation_name(activations[i].activation));
+
+	return 0;
+}